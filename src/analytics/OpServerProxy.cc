@@ -185,6 +185,34 @@ class OpServerProxy::OpServerImpl {
             collector_->SendRemote(destination, dec_sandesh);
         }
 
+        void UVEUpdateSent(const std::string &generator, size_t attrs) {
+            tbb::mutex::scoped_lock lock(uve_stats_mutex_);
+            OpServerProxy::UVEUpdateStats &stats = uve_stats_map_[generator];
+            stats.redis_calls++;
+            stats.attr_updates += attrs;
+        }
+
+        void UVEUpdateDone(const std::string &generator, bool res,
+                uint64_t latency) {
+            tbb::mutex::scoped_lock lock(uve_stats_mutex_);
+            OpServerProxy::UVEUpdateStats &stats = uve_stats_map_[generator];
+            stats.replies++;
+            if (!res) stats.failures++;
+            stats.total_latency_usec += latency;
+            if (latency > stats.max_latency_usec)
+                stats.max_latency_usec = latency;
+        }
+
+        bool GetUVEUpdateStats(const std::string &generator,
+                OpServerProxy::UVEUpdateStats &stats) {
+            tbb::mutex::scoped_lock lock(uve_stats_mutex_);
+            UVEStatsMap::const_iterator it = uve_stats_map_.find(generator);
+            if (it == uve_stats_map_.end())
+                return false;
+            stats = it->second;
+            return true;
+        }
+
         RedisAsyncConnection *to_ops_conn() {
             return (to_ops_conn_.get());
         }
@@ -217,6 +245,9 @@ class OpServerProxy::OpServerImpl {
         }
 
     private:
+        typedef std::map<std::string, OpServerProxy::UVEUpdateStats>
+            UVEStatsMap;
+
         /* these are made public, so they are accessed by OpServerProxy */
         EventManager *evm_;
         VizCollector *collector_;
@@ -226,6 +257,8 @@ class OpServerProxy::OpServerImpl {
         boost::scoped_ptr<RedisAsyncConnection> from_ops_conn_;
         RedisAsyncConnection::ClientAsyncCmdCbFn analytics_cb_proc_fn;
         RedisAsyncConnection::ClientAsyncCmdCbFn processor_cb_proc_fn;
+        tbb::mutex uve_stats_mutex_;
+        UVEStatsMap uve_stats_map_;
     public:
         std::string redis_ip_;
         unsigned short redis_port_;
@@ -254,6 +287,33 @@ OpServerProxy::UVEUpdate(const std::string &type, const std::string &attr,
 
     RedisProcessorExec::UVEUpdate(impl_->to_ops_conn(), NULL, type, attr,
             source, module, key, message, seq, agg, atyp, ts);
+    impl_->UVEUpdateSent(source + ":" + module, 1);
+
+    return true;
+}
+
+bool
+OpServerProxy::UVEUpdateAttrs(const std::string &type,
+                       const UVEAttrList &attrs,
+                       const std::string &source, const std::string &module,
+                       const std::string &key, int32_t seq) {
+
+    if ((!impl_->to_ops_conn()) || (!impl_->to_ops_conn()->IsConnUp()))
+        return false;
+
+    if (attrs.empty())
+        return true;
+
+    string generator(source + ":" + module);
+    UVEUpdateReq *req = new UVEUpdateReq(impl_->to_ops_conn(),
+            boost::bind(&OpServerImpl::UVEUpdateDone, impl_, generator,
+                        _1, _2),
+            type, attrs, source, module, key, seq);
+    if (!req->RedisSend()) {
+        delete req;
+        return false;
+    }
+    impl_->UVEUpdateSent(generator, attrs.size());
 
     return true;
 }
@@ -311,6 +371,14 @@ OpServerProxy::GeneratorCleanup(GenCleanupReply gcr) {
     return dr->RedisSend();
 }
 
+bool
+OpServerProxy::GetUVEUpdateStats(const std::string &source,
+        const std::string &module, UVEUpdateStats &stats) const {
+    if (!impl_) return false;
+
+    return impl_->GetUVEUpdateStats(source + ":" + module, stats);
+}
+
 bool
 OpServerProxy::RefreshGenerator(const std::string &source, const std::string &module) {
     if ((!impl_->to_ops_conn()) || (!impl_->to_ops_conn()->IsConnUp()))
@@ -6,6 +6,8 @@
 #define __OPSERVERPROXY_H__
 
 #include <string>
+#include <utility>
+#include <vector>
 #include "io/event_manager.h"
 
 // This class can be used to send UVE Traces from vizd to the OpSever(s)
@@ -22,6 +24,20 @@ public:
         STATUS_PRESENT = 3,
     };
 
+    typedef std::vector<std::pair<std::string, std::string> > UVEAttrList;
+
+    // Per generator counters of UVE updates sent to Redis
+    struct UVEUpdateStats {
+        UVEUpdateStats() : redis_calls(0), attr_updates(0), replies(0),
+            failures(0), total_latency_usec(0), max_latency_usec(0) {}
+        uint64_t redis_calls;
+        uint64_t attr_updates;
+        uint64_t replies;
+        uint64_t failures;
+        uint64_t total_latency_usec;
+        uint64_t max_latency_usec;
+    };
+
     // To construct this interface, pass in the hostname and port for Redis
     OpServerProxy(EventManager *evm, VizCollector *collector,
             const std::string & redis_ip,
@@ -36,6 +52,12 @@ public:
                            int32_t seq, const std::string& agg, 
                            const std::string& atyp, int64_t ts);
 
+    // Update several non-stats attributes of a UVE in one Redis call
+    virtual bool UVEUpdateAttrs(const std::string &type,
+                       const UVEAttrList &attrs,
+                       const std::string &source, const std::string &module,
+                       const std::string &key, int32_t seq);
+
     // Use this to delete the object when the deleted attribute is set
     virtual bool UVEDelete(const std::string &type,
                        const std::string &source, const std::string &module,
@@ -51,6 +73,9 @@ public:
     typedef boost::function<void(int)> GenCleanupReply;
     bool GeneratorCleanup(GenCleanupReply gcr);
 
+    bool GetUVEUpdateStats(const std::string &source,
+            const std::string &module, UVEUpdateStats &stats) const;
+
 private:
     class OpServerImpl;
     OpServerImpl *impl_;
@@ -6,6 +6,8 @@
 
 #include <boost/lexical_cast.hpp>
 #include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/assign/list_of.hpp>
 
 #include "base/logging.h"
 #include "base/task.h"
@@ -34,19 +36,96 @@ Collector::Collector(EventManager *evm, short server_port,
         db_handler_(db_handler),
         osp_(ruleeng->GetOSP()),
         evm_(evm),
-        cb_(boost::bind(&Ruleeng::rule_execute, ruleeng, _1, _2)) {
+        cb_(boost::bind(&Ruleeng::rule_execute, ruleeng, _1, _2)),
+        shards_shutdown_(false) {
+    SetTaskPolicy();
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    int task_id = scheduler->GetTaskId("collector::Generator");
+    int shard_count = scheduler->HardwareThreadCount();
+    if (shard_count <= 0) shard_count = 1;
+    for (int i = 0; i < shard_count; i++) {
+        shards_.push_back(new GeneratorMsgQueue(task_id, i,
+                boost::bind(&Collector::ProcessGeneratorMsg, this, _1)));
+        shards_.back().SetExitCallback(
+                boost::bind(&Collector::ShardRunnerExit, this, i, _1));
+    }
+    deferred_sessions_.resize(shard_count);
     SandeshServer::Initialize(server_port);
 }
 
 Collector::~Collector() {
 }
 
+//
+// Shards run the message table insert, rule engine and UVE publish paths
+// in parallel. The GenDb column queue and the redis connections are safe
+// for concurrent use, but DbHandler initialization and teardown run in
+// collector::DbIf and replace the GenDb queue, so keep the shards out of
+// collector::DbIf.
+//
+void Collector::SetTaskPolicy() {
+    static bool policy_set;
+    if (policy_set) return;
+    policy_set = true;
+
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    TaskPolicy shard_policy = boost::assign::list_of
+        (TaskExclusion(scheduler->GetTaskId("collector::DbIf")));
+    scheduler->SetPolicy(scheduler->GetTaskId("collector::Generator"),
+                         shard_policy);
+}
+
+//
+// WorkQueue::Shutdown must not run concurrently with the queue's runner.
+// Run it from collector::DbIf, which the shard policy excludes, so that
+// no shard runner is executing and any runner waiting to be scheduled is
+// cancelled.
+//
+class Collector::ShardShutdownTask : public Task {
+public:
+    explicit ShardShutdownTask(Collector *collector)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("collector::DbIf")),
+          collector_(collector) {
+    }
+    virtual bool Run() {
+        collector_->ShutdownShards();
+        return true;
+    }
+private:
+    Collector *collector_;
+};
+
 void Collector::Shutdown() {
     SandeshServer::Shutdown();
+    {
+        std::unique_lock<tbb::mutex> lock(shard_mutex_);
+        if (!shards_shutdown_) {
+            TaskScheduler *scheduler = TaskScheduler::GetInstance();
+            scheduler->Enqueue(new ShardShutdownTask(this));
+        }
+        while (!shards_shutdown_) {
+            shard_cond_var_.wait(lock);
+        }
+    }
+    // Queued messages carry raw Generator pointers, the generators can only
+    // be deleted once the shards are stopped
     tbb::mutex::scoped_lock lock(gen_map_mutex_);
     gen_map_.clear();
 }
 
+void Collector::ShutdownShards() {
+    for (boost::ptr_vector<GeneratorMsgQueue>::iterator it = shards_.begin();
+         it != shards_.end(); ++it) {
+        it->Shutdown();
+    }
+    tbb::mutex::scoped_lock lock(shard_mutex_);
+    for (size_t i = 0; i < deferred_sessions_.size(); i++) {
+        deferred_sessions_[i].clear();
+    }
+    shards_shutdown_ = true;
+    shard_cond_var_.notify_all();
+}
+
 void Collector::RedisUpdate(bool rsc) {
     LOG(INFO, "RedisUpdate " << rsc);
 
@@ -108,22 +187,87 @@ bool Collector::ReceiveSandeshMsg(SandeshSession *session,
 
     boost::shared_ptr<VizMsg> vmsgp(new VizMsg(header, message_type, xml_message, unm));
 
-    db_handler_->MessageTableInsert(vmsgp);
-
     VizSession *vsession = dynamic_cast<VizSession *>(session);
     if (!vsession) {
+        db_handler_->MessageTableInsert(vmsgp);
         LOG(ERROR, __func__ << ": NO VizSession");
         return false;
     }
-    if (vsession->gen_) {
-        return vsession->gen_->ReceiveSandeshMsg(vmsgp, rsc);
+    Generator *gen = vsession->gen_;
+    if (gen) {
+        // Decode, rule evaluation and DB enqueue run on the generator's
+        // shard
+        size_t index = gen->shard_index();
+        shards_[index].Enqueue(GeneratorMsg(gen, vmsgp, rsc));
+        if (shards_[index].QueueCount() >= kShardHighWaterMark) {
+            DeferSession(index, vsession);
+        }
+        return true;
     } else {
+        db_handler_->MessageTableInsert(vmsgp);
         LOG(ERROR, __func__ << ": Sandesh message " << message_type <<
                 ": Generator NOT PRESENT: Session: " << vsession->ToString());
         return false;
     }
 }
 
+bool Collector::ProcessGeneratorMsg(GeneratorMsg msg) {
+    db_handler_->MessageTableInsert(msg.vmsg);
+    if (!msg.gen->ReceiveSandeshMsg(msg.vmsg, msg.rsc)) {
+        LOG(ERROR, __func__ << ": Sandesh message " << msg.vmsg->messagetype
+                << ": Processing FAILED: Generator: " << msg.gen->ToString());
+    }
+    return true;
+}
+
+void Collector::DeferSession(size_t index, VizSession *session) {
+    tbb::mutex::scoped_lock lock(shard_mutex_);
+    if (shards_shutdown_) {
+        return;
+    }
+    deferred_sessions_[index].insert(SessionPtr(session));
+    session->SetDeferReader(true);
+    lock.release();
+    // The shard runner may have drained the queue before the session was
+    // added
+    ShardRunnerExit(index, true);
+}
+
+void Collector::ShardRunnerExit(size_t index, bool done) {
+    if (shards_[index].QueueCount() >= kShardLowWaterMark) {
+        return;
+    }
+    SessionSet sessions;
+    {
+        tbb::mutex::scoped_lock lock(shard_mutex_);
+        sessions.swap(deferred_sessions_[index]);
+    }
+    for (SessionSet::iterator it = sessions.begin(); it != sessions.end();
+         ++it) {
+        (*it)->SetDeferReader(false);
+    }
+}
+
+size_t Collector::ShardIndex(const Generator::GeneratorId &id) const {
+    boost::hash<Generator::GeneratorId> hasher;
+    return hasher(id) % shards_.size();
+}
+
+void Collector::GetShardStats(vector<CollectorShardStats> &shard_stats) {
+    shard_stats.clear();
+    for (size_t i = 0; i < shards_.size(); i++) {
+        CollectorShardStats stats;
+        stats.set_shard(i);
+        stats.set_queue_depth(shards_[i].QueueCount());
+        stats.set_enqueues(shards_[i].EnqueueCount());
+        {
+            tbb::mutex::scoped_lock lock(shard_mutex_);
+            stats.set_deferred_sessions(deferred_sessions_[i].size());
+        }
+        shard_stats.push_back(stats);
+    }
+}
+
  
 TcpSession* Collector::AllocSession(Socket *socket) {
     VizSession *session = new VizSession(this, socket, AllocConnectionIndex(), 
@@ -155,6 +299,7 @@ bool Collector::ReceiveSandeshCtrlMsg(SandeshStateMachine *state_machine,
     if (gen_it == gen_map_.end()) {
         gen = new Generator(this, vsession, state_machine, id.first,
                 id.second);
+        gen->set_shard_index(ShardIndex(id));
         gen_map_.insert(id, gen);
     } else {
         // Update the generator if needed
@@ -6,12 +6,17 @@
 #define COLLECTOR_H_
 
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/intrusive_ptr.hpp>
 #include <boost/ptr_container/ptr_map.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <tbb/mutex.h>
+#include <tbb/compat/condition_variable>
 
 #include "base/parse_object.h"
+#include "base/queue_task.h"
 
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
@@ -21,7 +26,9 @@
 #include "Thrift.h"
 #include "viz_constants.h"
 #include "generator.h"
+#include <set>
 #include <string>
+#include <vector>
 
 class DbHandler;
 class Ruleeng;
@@ -33,6 +40,24 @@ class Collector : public SandeshServer {
 public:
     typedef boost::function<bool(const boost::shared_ptr<VizMsg>, bool)> VizCallback;
 
+    // Sandesh message from a generator, queued for processing on the
+    // generator's shard
+    struct GeneratorMsg {
+        GeneratorMsg() : gen(NULL), rsc(false) {}
+        GeneratorMsg(Generator *gen, const boost::shared_ptr<VizMsg> &vmsg,
+                bool rsc) : gen(gen), vmsg(vmsg), rsc(rsc) {}
+        Generator *gen;
+        boost::shared_ptr<VizMsg> vmsg;
+        bool rsc;
+    };
+    typedef WorkQueue<GeneratorMsg> GeneratorMsgQueue;
+
+    // Reading from a generator's session is deferred while its shard holds
+    // kShardHighWaterMark messages or more, and resumed once the shard
+    // drains below kShardLowWaterMark.
+    static const size_t kShardHighWaterMark = GeneratorMsgQueue::kThreshold;
+    static const size_t kShardLowWaterMark = kShardHighWaterMark / 2;
+
     Collector(EventManager *evm, short server_port,
               DbHandler *db_handler, Ruleeng *ruleeng);
     virtual ~Collector();
@@ -50,6 +75,13 @@ public:
     void GetGeneratorSandeshStatsInfo(std::vector<ModuleServerState> &genlist);
     bool SendRemote(const std::string& destination,
             const std::string &dec_sandesh);
+    void GetShardStats(std::vector<CollectorShardStats> &shard_stats);
+    size_t ShardCount() const { return shards_.size(); }
+    size_t ShardIndex(const Generator::GeneratorId &id) const;
+    // For testing only, stop the shard runner from processing messages
+    void set_shard_disable(size_t index, bool disable) {
+        shards_[index].set_disable(disable);
+    }
 
     OpServerProxy * GetOSP() const { return osp_; }
     EventManager * event_manager() const { return evm_; }
@@ -66,6 +98,16 @@ protected:
     virtual void DisconnectSession(SandeshSession *session);
 
 private:
+    class ShardShutdownTask;
+    typedef boost::intrusive_ptr<TcpSession> SessionPtr;
+    typedef std::set<SessionPtr> SessionSet;
+
+    static void SetTaskPolicy();
+    bool ProcessGeneratorMsg(GeneratorMsg msg);
+    void ShutdownShards();
+    void DeferSession(size_t index, VizSession *session);
+    void ShardRunnerExit(size_t index, bool done);
+
     DbHandler *db_handler_;
     OpServerProxy * const osp_;
     EventManager * const evm_;
@@ -76,6 +118,17 @@ private:
     tbb::mutex gen_map_mutex_;
     GeneratorMap gen_map_;
 
+    // Messages are processed on the shard selected by the GeneratorId,
+    // so each generator's messages stay in order while different
+    // generators are processed in parallel.
+    boost::ptr_vector<GeneratorMsgQueue> shards_;
+    // Protects deferred_sessions_ and shards_shutdown_
+    tbb::mutex shard_mutex_;
+    std::condition_variable shard_cond_var_;
+    // Sessions whose reader is deferred, per shard
+    std::vector<SessionSet> deferred_sessions_;
+    bool shards_shutdown_;
+
     // Random generator for UUIDs
     tbb::mutex rand_mutex_;
     boost::uuids::random_generator umn_gen_;
@@ -139,7 +139,8 @@ bool DbHandler::Init() {
 }
 
 inline bool DbHandler::AllowMessageTableInsert(std::string& message_type) {
-    return message_type != "FlowDataIpv4Object";
+    return message_type != "FlowDataIpv4Object" &&
+        message_type != "FlowDataIpv4ListObject";
 }
 
 inline bool DbHandler::MessageIndexTableInsert(const std::string& cfname,
@@ -381,11 +382,27 @@ bool FlowDataIpv4ObjectWalker::for_each(pugi::xml_node& node) {
 }
 
 /*
- * process the flow message and insert into appropriate tables
+ * process the flow message and insert into appropriate tables. The message
+ * carries a single flow record (FlowDataIpv4Object) or a list of them
+ * (FlowDataIpv4ListObject)
  */
 bool DbHandler::FlowTableInsert(const RuleMsg& rmsg) {
-    pugi::xml_node parent = rmsg.get_doc();
+    RuleMsg::RuleMsgPredicate pugi_p("FlowDataIpv4");
+    pugi::xml_node record = rmsg.get_doc().find_node(pugi_p);
+    if (!record) {
+        return false;
+    }
+
+    for (; record; record = record.next_sibling("FlowDataIpv4")) {
+        if (!FlowRecordInsert(record, rmsg.hdr)) {
+            return false;
+        }
+    }
+    return true;
+}
 
+bool DbHandler::FlowRecordInsert(pugi::xml_node parent,
+        const SandeshHeader& hdr) {
     RuleMsg::RuleMsgPredicate pugi_p(g_viz_constants.FlowRecordNames.find(FlowRecordFields::FLOWREC_FLOWUUID)->second);
     pugi::xml_node flownode = parent.find_node(pugi_p);
     if (!flownode) {
@@ -402,7 +419,7 @@ bool DbHandler::FlowTableInsert(const RuleMsg& rmsg) {
     col_list->cfname_ = g_viz_constants.FLOW_TABLE;
     std::vector<GenDb::NewCol>& columns = col_list->columns_;
     columns.push_back(GenDb::NewCol(g_viz_constants.FlowRecordNames.find(FlowRecordFields::FLOWREC_VROUTER)->second,
-                rmsg.hdr.get_Source()));
+                hdr.get_Source()));
 
     GenDb::DbDataValueVec& rowkey = col_list->rowkey_;
     rowkey.push_back(flowu);
@@ -431,7 +448,7 @@ bool DbHandler::FlowTableInsert(const RuleMsg& rmsg) {
             int32_t runint32;
             std::string runstring;
 
-            t = rmsg.hdr.get_Timestamp();
+            t = hdr.get_Timestamp();
             t2 = t >> g_viz_constants.RowTimeInBits;
             t1 = t & g_viz_constants.RowTimeInMask;
 
@@ -675,7 +692,7 @@ bool DbHandler::FlowTableInsert(const RuleMsg& rmsg) {
 
             GenDb::DbDataValueVec col_name;
             /* setup the column-name */
-            col_name.push_back(rmsg.hdr.get_Source());
+            col_name.push_back(hdr.get_Source());
             /* T1 */
             col_name.push_back(t1);
 
@@ -708,7 +725,7 @@ bool DbHandler::FlowTableInsert(const RuleMsg& rmsg) {
             /* setup the column-name */
             col_name.push_back(t1);
 
-            col_name.push_back(rmsg.hdr.get_Source());
+            col_name.push_back(hdr.get_Source());
 
             pugi_p = std::string(g_viz_constants.FlowRecordNames.find(FlowRecordFields::FLOWREC_SOURCEVN)->second);
             runnode = parent.find_node(pugi_p);
@@ -46,6 +46,8 @@ public:
             const RuleMsg& rmsg, const boost::uuids::uuid& unm);
 
     bool FlowTableInsert(const RuleMsg& rmsg);
+    bool FlowRecordInsert(pugi::xml_node parent,
+            const SandeshHeader& hdr);
 
     GenDb::GenDbIf *get_dbif() {
         return dbif_.get();
@@ -55,7 +55,8 @@ Generator::Generator(Collector * const collector, VizSession *session,
                     "Delete wait timer" + source + module)),
         source_(source),
         module_(module),
-        name_(source_ + ":" + module_) {
+        name_(source_ + ":" + module_),
+        shard_index_(0) {
     // Update state machine
     state_machine_->SetGeneratorKey(name_);
 }
@@ -195,6 +196,19 @@ void Generator::GetGeneratorInfo(ModuleServerState &genlist) const {
     GeneratorInfo gi;
     gi.set_hostname(Sandesh::source());
     gi.set_gen_attr(gen_attr_);
+    OpServerProxy::UVEUpdateStats stats;
+    if (collector_->GetOSP() &&
+        collector_->GetOSP()->GetUVEUpdateStats(source_, module_, stats)) {
+        GeneratorUVEUpdateStats uve_stats;
+        uve_stats.set_redis_calls(stats.redis_calls);
+        uve_stats.set_attr_updates(stats.attr_updates);
+        uve_stats.set_replies(stats.replies);
+        uve_stats.set_failures(stats.failures);
+        uve_stats.set_avg_latency_usec(stats.replies ?
+            stats.total_latency_usec / stats.replies : 0);
+        uve_stats.set_max_latency_usec(stats.max_latency_usec);
+        gi.set_uve_update_stats(uve_stats);
+    }
     giv.push_back(gi);
     genlist.set_generator_info(giv);
     genlist.set_name(source_ + ":" + module_);
@@ -216,6 +230,22 @@ void GeneratorListReq::HandleRequest() const {
     resp->Response();
 }
 
+void CollectorShardStatsReq::HandleRequest() const {
+    CollectorShardStatsResp *resp(new CollectorShardStatsResp);
+    vector<CollectorShardStats> shard_stats;
+    VizSandeshContext *vsc = dynamic_cast<VizSandeshContext *>
+                                 (Sandesh::client_context());
+    if (!vsc) {
+        LOG(ERROR, __func__ << ": Sandesh client context NOT PRESENT");
+        resp->Response();
+        return;
+    }
+    vsc->Analytics()->GetCollector()->GetShardStats(shard_stats);
+    resp->set_shard_stats(shard_stats);
+    resp->set_context(context());
+    resp->Response();
+}
+
 const std::string Generator::State() const {
     if (state_machine_) {
         return state_machine_->StateName();
@@ -64,6 +64,8 @@ public:
         return state_machine_;
     }
     const std::string State() const;
+    size_t shard_index() const { return shard_index_; }
+    void set_shard_index(size_t shard_index) { shard_index_ = shard_index; }
 
     void GetGeneratorInfo(ModuleServerState &genlist) const;
 private:
@@ -103,6 +105,7 @@ private:
     const std::string source_;
     const std::string module_;
     const std::string name_;
+    size_t shard_index_;
 };
 
 #endif
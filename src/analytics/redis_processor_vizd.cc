@@ -3,6 +3,7 @@
  */
 
 #include "base/logging.h"
+#include "base/util.h"
 #include "redis_processor_vizd.h"
 #include "redis_connection.h"
 #include <boost/assign/list_of.hpp>
@@ -13,6 +14,7 @@
 #include "delrequest_lua.cpp"
 #include "uveupdate_lua.cpp"
 #include "uveupdate_st_lua.cpp"
+#include "uveupdate_multi_lua.cpp"
 #include "uvedelete_lua.cpp"
 #include "expiredgens_lua.cpp"
 #include "withdrawgen_lua.cpp"
@@ -101,6 +103,36 @@ RedisProcessorExec::UVEUpdate(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
     }
 }
 
+bool
+RedisProcessorExec::UVEUpdateAttrs(RedisAsyncConnection * rac,
+        RedisProcessorIf *rpi, const std::string &type,
+        const std::vector<std::pair<std::string, std::string> > &attrs,
+        const std::string &source, const std::string &module,
+        const std::string &key, int32_t seq) {
+
+    size_t sep = key.find(":");
+    string table = key.substr(0, sep);
+    std::ostringstream seqstr;
+    seqstr << seq;
+
+    string lua_scr(reinterpret_cast<char *>(uveupdate_multi_lua),
+            uveupdate_multi_lua_len);
+    vector<string> args = list_of(string("EVAL"))(lua_scr)("5")(
+            string("TYPES:") + source + ":" + module)(
+            string("ORIGINS:") + key)(
+            string("TABLE:") + table)(
+            string("UVES:") + source + ":" + module + ":" + type)(
+            string("VALUES:") + key + ":" + source + ":" + module + ":" + type)(
+            source)(module)(type)(key)(seqstr.str());
+    args.reserve(args.size() + 2 * attrs.size());
+    for (vector<pair<string, string> >::const_iterator it = attrs.begin();
+            it != attrs.end(); it++) {
+        args.push_back(it->first);
+        args.push_back(it->second);
+    }
+    return rac->RedisAsyncArgCmd(rpi, args);
+}
+
 void
 RedisProcessorExec::UVEDelete(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
         const std::string &type,
@@ -321,3 +353,39 @@ void GenCleanupReq::FinalResult() {
     (fin_)(Key(), res_);
     delete this;
 }
+
+
+UVEUpdateReq::UVEUpdateReq(RedisAsyncConnection * rac, finFn fn,
+        const std::string &type, const AttrList &attrs,
+        const std::string &source, const std::string &module,
+        const std::string &key, int32_t seq) :
+        rac_(rac), fin_(fn), type_(type), attrs_(attrs), source_(source),
+        module_(module), key_(key), seq_(seq), send_time_(0), res_(false) {}
+
+string UVEUpdateReq::Key() {
+    string vkey = "VALUES:" + key_ + ":" + source_ + ":" + module_ + ":" +
+            type_;
+    return vkey;
+}
+
+bool UVEUpdateReq::RedisSend() {
+    if (!rac_->IsConnUp())
+        return false;
+
+    send_time_ = UTCTimestampUsec();
+    return RedisProcessorExec::UVEUpdateAttrs(rac_, this, type_, attrs_,
+            source_, module_, key_, seq_);
+}
+
+void UVEUpdateReq::ProcessCallback(redisReply *reply) {
+    res_ = (reply->type != REDIS_REPLY_ERROR);
+    if (!res_) {
+        LOG(ERROR, "UVEUpdateReq failed for " << Key() << ": " << reply->str);
+    }
+    FinalResult();
+}
+
+void UVEUpdateReq::FinalResult() {
+    (fin_)(res_, UTCTimestampUsec() - send_time_);
+    delete this;
+}
@@ -25,6 +25,14 @@ public:
                        int32_t seq, const std::string &agg,
                        const std::string &atyp, int64_t ts);
 
+    // Update several non-stats attributes of one UVE with a single EVAL
+    static bool
+    UVEUpdateAttrs(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
+            const std::string &type,
+            const std::vector<std::pair<std::string, std::string> > &attrs,
+            const std::string &source, const std::string &module,
+            const std::string &key, int32_t seq);
+
     static void
     UVEDelete(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
             const std::string &type,
@@ -105,5 +113,31 @@ private:
 
     void CallbackFromChild(const std::string & key, bool res);
 };
+
+// Batched attribute update of a UVE. The callback is invoked with the
+// Redis round trip time in microseconds when the reply is received.
+struct UVEUpdateReq : public RedisProcessorIf {
+    typedef std::vector<std::pair<std::string, std::string> > AttrList;
+    typedef boost::function<void(bool, uint64_t)> finFn;
+    UVEUpdateReq(RedisAsyncConnection * rac, finFn fn,
+            const std::string &type, const AttrList &attrs,
+            const std::string &source, const std::string &module,
+            const std::string &key, int32_t seq);
+    bool RedisSend();
+    void ProcessCallback(redisReply *reply);
+    std::string Key();
+    void FinalResult();
+private:
+    RedisAsyncConnection * rac_;
+    finFn fin_;
+    std::string type_;
+    AttrList attrs_;
+    std::string source_;
+    std::string module_;
+    std::string key_;
+    int32_t seq_;
+    uint64_t send_time_;
+    bool res_;
+};
 #endif
 
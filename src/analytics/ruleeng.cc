@@ -177,6 +177,8 @@ bool Ruleeng::handle_uve_publish(const RuleMsg& rmsg) {
     }
 
     bool deleted = false;
+    // Non-stats attributes are sent to redis together in one update
+    OpServerProxy::UVEAttrList attrs;
     for (pugi::xml_node node = object.first_child(); node;
            node = node.next_sibling()) {
         std::ostringstream ostr; 
@@ -206,6 +208,12 @@ bool Ruleeng::handle_uve_publish(const RuleMsg& rmsg) {
             agg = std::string("None");
         }
 
+        if (agg != "stats") {
+            attrs.push_back(std::make_pair(std::string(node.name()),
+                                           ostr.str()));
+            continue;
+        }
+
         if (!osp_->UVEUpdate(object.name(), node.name(),
                              source, module,
                              key, ostr.str(), seq,
@@ -218,6 +226,20 @@ bool Ruleeng::handle_uve_publish(const RuleMsg& rmsg) {
         }
     }
 
+    if (!attrs.empty()) {
+        bool success = osp_->UVEUpdateAttrs(object.name(), attrs, source,
+                                            module, key, seq);
+        if (!success) {
+            LOG(ERROR, __func__ << " Message: "  << type << " Source: " << source <<
+              " Name: " << object.name() <<  " UVEUpdate Failed"); 
+        }
+        for (OpServerProxy::UVEAttrList::const_iterator it = attrs.begin();
+             it != attrs.end(); it++) {
+            PUBLISH_UVE_UPDATE_TRACE(UVETraceBuf, source, module, type, key,
+                                     it->first, success);
+        }
+    }
+
     if (deleted) {
         if (!osp_->UVEDelete(object.name(), source, module, key, seq)) {
             LOG(ERROR, __func__ << " Cannot Delete " << key);
@@ -20,6 +20,11 @@ public:
                        const std::string &agg, const std::string &atyp, int64_t ts));
 
 
+    MOCK_METHOD6(UVEUpdateAttrs, bool(const std::string &type,
+                       const UVEAttrList &attrs,
+                       const std::string &source, const std::string &module,
+                       const std::string &key, int32_t seq));
+
     MOCK_METHOD4(UVESend, bool(const std::string &type, const std::string &source,
                 const std::string &key, const std::string &message));
 
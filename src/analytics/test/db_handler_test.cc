@@ -292,6 +292,51 @@ TEST_F(DbHandlerTest, FlowTableInsertTest) {
     db_handler()->FlowTableInsert(rmsg);
 }
 
+// Each record of a batched flow message is inserted
+TEST_F(DbHandlerTest, FlowListTableInsertTest) {
+    SandeshHeader hdr;
+    hdr.Module = "VizdTest";
+    hdr.Source = "127.0.0.1";
+    std::string messagetype("");
+    std::string xmlmessage = "<FlowDataIpv4ListObject type=\"sandesh\"><flowdata type=\"list\" identifier=\"1\"><list type=\"struct\" size=\"2\">"
+        "<FlowDataIpv4><flowuuid type=\"string\" identifier=\"1\">d6ab8614-7745-4211-b6e3-a33b3dfcc270</flowuuid><direction_ing type=\"byte\" identifier=\"2\">1</direction_ing><sourcevn type=\"string\" identifier=\"3\">default-domain:admin:vn0</sourcevn><sourceip type=\"i32\" identifier=\"4\">167837706</sourceip><destvn type=\"string\" identifier=\"5\">default-domain:admin:vn0</destvn><destip type=\"i32\" identifier=\"6\">167837706</destip><protocol type=\"byte\" identifier=\"7\">17</protocol><sport type=\"i16\" identifier=\"8\">-32768</sport><dport type=\"i16\" identifier=\"9\">80</dport><setup_time type=\"i64\" identifier=\"17\">1357843963698076</setup_time><bytes type=\"i64\" identifier=\"23\">10000</bytes><packets type=\"i64\" identifier=\"24\">100</packets><diff_bytes type=\"i64\" identifier=\"26\">10000</diff_bytes><diff_packets type=\"i64\" identifier=\"27\">100</diff_packets></FlowDataIpv4>"
+        "<FlowDataIpv4><flowuuid type=\"string\" identifier=\"1\">5f8a5bc7-3c9a-4b1e-9bb3-6a1f8d2a6c01</flowuuid><direction_ing type=\"byte\" identifier=\"2\">1</direction_ing><sourcevn type=\"string\" identifier=\"3\">default-domain:admin:vn0</sourcevn><sourceip type=\"i32\" identifier=\"4\">167837706</sourceip><destvn type=\"string\" identifier=\"5\">default-domain:admin:vn0</destvn><destip type=\"i32\" identifier=\"6\">167837706</destip><protocol type=\"byte\" identifier=\"7\">17</protocol><sport type=\"i16\" identifier=\"8\">-32768</sport><dport type=\"i16\" identifier=\"9\">80</dport><setup_time type=\"i64\" identifier=\"17\">1357843963698076</setup_time><bytes type=\"i64\" identifier=\"23\">10000</bytes><packets type=\"i64\" identifier=\"24\">100</packets><diff_bytes type=\"i64\" identifier=\"26\">10000</diff_bytes><diff_packets type=\"i64\" identifier=\"27\">100</diff_packets></FlowDataIpv4>"
+        "</list></flowdata><file type=\"string\" identifier=\"-32768\">src/vnsw/agent/uve/flow_stats.cc</file><line type=\"i32\" identifier=\"-32767\">1</line></FlowDataIpv4ListObject>";
+    boost::uuids::uuid unm = boost::uuids::random_generator()();
+    boost::shared_ptr<VizMsg> vmsgp(new VizMsg(hdr, messagetype, xmlmessage, unm)); 
+    RuleMsg rmsg(vmsgp);
+
+    EXPECT_CALL(*dbif_mock(), Db_AddColumnfamily(_))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*dbif_mock(),
+            Db_AddColumn(Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE)))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*dbif_mock(),
+            Db_AddColumn(Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE_VN2VN)))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*dbif_mock(),
+            Db_AddColumn(Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE_ALL_FIELDS)))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*dbif_mock(), Db_AddColumn(AnyOf(
+            Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE_SVN_SIP),
+            Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE_DVN_DIP),
+            Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE_PROT_SP),
+            Field(&GenDb::Column::cfname_, g_viz_constants.FLOW_TABLE_PROT_DP))))
+        .Times(8)
+        .WillRepeatedly(Return(true));
+
+    db_handler()->VizCreateFlowTables();
+
+    EXPECT_TRUE(db_handler()->FlowTableInsert(rmsg));
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
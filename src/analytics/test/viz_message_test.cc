@@ -5,6 +5,7 @@
 #include "../viz_message.h"
 #include "testing/gunit.h"
 #include "base/logging.h"
+#include "base/util.h"
 #include "boost/lexical_cast.hpp"
 
 class VizMessageTest : public ::testing::Test {
@@ -46,6 +47,83 @@ TEST_F(VizMessageTest, Test1) {
     EXPECT_EQ(p1.tmp_, "Second");
 }
 
+TEST_F(VizMessageTest, SharedDoc) {
+    SandeshHeader hdr;
+    std::string messagetype("VNSwitchErrorMsg");
+    std::string xmlmessage = "<VNSwitchErrorMsg type=\"sandesh\"><field1 type=\"string\" identifier=\"1\">field1_value</field1></VNSwitchErrorMsg>";
+    boost::uuids::uuid unm = boost::uuids::random_generator()();
+    boost::shared_ptr<VizMsg> vmsgp(new VizMsg(hdr, messagetype, xmlmessage, unm));
+
+    // Every consumer of the message sees the same parsed document
+    const XmlDocPtr doc = vmsgp->doc();
+    EXPECT_EQ(doc.get(), vmsgp->doc().get());
+    RuleMsg rmsg1(vmsgp);
+    RuleMsg rmsg2(vmsgp);
+    EXPECT_EQ(rmsg1.get_doc(), rmsg2.get_doc());
+    EXPECT_EQ(rmsg1.get_doc(), pugi::xml_node(*doc));
+
+    std::string type, value;
+    EXPECT_EQ(0, rmsg2.field_value("field1", type, value));
+    EXPECT_EQ("field1_value", value);
+
+    // Document stays out of the pool while it is still referenced
+    size_t free_count = VizMsgDocPool::free_count();
+    vmsgp.reset();
+    EXPECT_EQ(free_count, VizMsgDocPool::free_count());
+}
+
+TEST_F(VizMessageTest, DocPoolReuse) {
+    SandeshHeader hdr;
+    std::string messagetype("VNSwitchErrorMsg");
+    std::string xmlmessage = "<VNSwitchErrorMsg type=\"sandesh\"><field1 type=\"string\" identifier=\"1\">field1_value</field1></VNSwitchErrorMsg>";
+    boost::uuids::uuid unm = boost::uuids::random_generator()();
+
+    {
+        boost::shared_ptr<VizMsg> vmsgp(new VizMsg(hdr, messagetype,
+                                                   xmlmessage, unm));
+        RuleMsg rmsg(vmsgp);
+    }
+    size_t free_count = VizMsgDocPool::free_count();
+    EXPECT_LT(0U, free_count);
+    uint64_t reuse_count = VizMsgDocPool::reuse_count();
+    {
+        boost::shared_ptr<VizMsg> vmsgp(new VizMsg(hdr, messagetype,
+                                                   xmlmessage, unm));
+        RuleMsg rmsg(vmsgp);
+        EXPECT_EQ(free_count - 1, VizMsgDocPool::free_count());
+        std::string type, value;
+        EXPECT_EQ(0, rmsg.field_value("field1", type, value));
+        EXPECT_EQ("field1_value", value);
+    }
+    EXPECT_EQ(reuse_count + 1, VizMsgDocPool::reuse_count());
+    EXPECT_EQ(free_count, VizMsgDocPool::free_count());
+}
+
+//
+// Replay a representative UVE message through the parse and field lookup
+// path and report the per core message rate.
+//
+TEST_F(VizMessageTest, ReplayRate) {
+    SandeshHeader hdr;
+    std::string messagetype("UveVirtualNetworkAgentTrace");
+    std::string xmlmessage = "<UveVirtualNetworkAgentTrace type=\"sandesh\"><data type=\"struct\" identifier=\"1\"><UveVirtualNetworkAgent><name type=\"string\" identifier=\"1\" key=\"ObjectVNTable\">default-domain:admin:vn0</name><in_tpkts type=\"i64\" identifier=\"2\">1000</in_tpkts><out_tpkts type=\"i64\" identifier=\"3\">2000</out_tpkts><in_bytes type=\"i64\" identifier=\"4\">100000</in_bytes><out_bytes type=\"i64\" identifier=\"5\">200000</out_bytes></UveVirtualNetworkAgent></data></UveVirtualNetworkAgentTrace>";
+    boost::uuids::uuid unm = boost::uuids::random_generator()();
+    const int kMessages = 100000;
+
+    uint64_t start = UTCTimestampUsec();
+    for (int i = 0; i < kMessages; i++) {
+        boost::shared_ptr<VizMsg> vmsgp(new VizMsg(hdr, messagetype,
+                                                   xmlmessage, unm));
+        RuleMsg rmsg(vmsgp);
+        std::string type, value;
+        EXPECT_EQ(0, rmsg.field_value("in_tpkts", type, value));
+    }
+    uint64_t elapsed = UTCTimestampUsec() - start;
+    if (elapsed == 0) elapsed = 1;
+    LOG(DEBUG, "Replayed " << kMessages << " messages in " << elapsed <<
+        " usec: " << (kMessages * 1000000ULL) / elapsed << " msgs/sec");
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
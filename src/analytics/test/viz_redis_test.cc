@@ -230,6 +230,12 @@ public:
         assert(0);
     }    
 
+    CollectorShardStats GetShardStats(size_t index) {
+        std::vector<CollectorShardStats> shard_stats;
+        collector_->GetShardStats(shard_stats);
+        return shard_stats[index];
+    }
+
     virtual void SetUp() {
     }
 
@@ -279,6 +285,89 @@ TEST_F(VizRedisTest, SendUVE) {
 
 }
 
+TEST_F(VizRedisTest, ShardDistribution) {
+    size_t shard_count = collector_->ShardCount();
+    ASSERT_GE(shard_count, 1U);
+
+    static const int kGeneratorCount = 1024;
+    std::vector<int> shard_gens(shard_count, 0);
+    for (int i = 0; i < kGeneratorCount; i++) {
+        Generator::GeneratorId id(std::make_pair(
+            "host-" + integerToString(i), string("VRouterAgent")));
+        size_t index = collector_->ShardIndex(id);
+        ASSERT_LT(index, shard_count);
+        // A generator always maps to the same shard
+        EXPECT_EQ(index, collector_->ShardIndex(id));
+        shard_gens[index]++;
+    }
+
+    // Every shard gets a share of the generators
+    for (size_t i = 0; i < shard_count; i++) {
+        EXPECT_LT(0, shard_gens[i]) << "Shard " << i;
+    }
+}
+
+TEST_F(VizRedisTest, ShardStats) {
+    analytics_->Init();
+    std::vector<CollectorShardStats> shard_stats;
+    collector_->GetShardStats(shard_stats);
+    ASSERT_EQ(collector_->ShardCount(), shard_stats.size());
+    for (size_t i = 0; i < shard_stats.size(); i++) {
+        EXPECT_EQ(i, shard_stats[i].get_shard());
+        EXPECT_EQ(0U, shard_stats[i].get_enqueues());
+    }
+
+    GeneratorTest gentest(collector_port_);
+    task_util::WaitForIdle();
+    gentest.SendMessageUVETrace();
+    usleep(1000000);
+    task_util::WaitForIdle();
+
+    // Both messages from the generator are processed on its shard
+    Generator::GeneratorId id(std::make_pair(sourcehost,
+                                             string("VRouterAgent")));
+    size_t index = collector_->ShardIndex(id);
+    collector_->GetShardStats(shard_stats);
+    ASSERT_EQ(collector_->ShardCount(), shard_stats.size());
+    for (size_t i = 0; i < shard_stats.size(); i++) {
+        EXPECT_EQ(0U, shard_stats[i].get_queue_depth());
+        if (i == index) {
+            EXPECT_LE(2U, shard_stats[i].get_enqueues());
+        } else {
+            EXPECT_EQ(0U, shard_stats[i].get_enqueues());
+        }
+    }
+    gentest.Shutdown();
+}
+
+TEST_F(VizRedisTest, ShardFlowControl) {
+    analytics_->Init();
+    GeneratorTest gentest(collector_port_);
+    task_util::WaitForIdle();
+
+    Generator::GeneratorId id(std::make_pair(sourcehost,
+                                             string("VRouterAgent")));
+    size_t index = collector_->ShardIndex(id);
+
+    // Messages pile up on the stopped shard until it reaches the high
+    // watermark, which defers reading from the generator's session
+    collector_->set_shard_disable(index, true);
+    for (size_t i = 0; i < Collector::kShardHighWaterMark; i++) {
+        gentest.SendMessageUVETrace();
+    }
+    WAIT_FOR(GetShardStats(index).get_deferred_sessions() == 1U);
+    EXPECT_LE(static_cast<uint64_t>(Collector::kShardHighWaterMark),
+              GetShardStats(index).get_queue_depth());
+
+    // The shard drains once restarted and the session is read again
+    collector_->set_shard_disable(index, false);
+    WAIT_FOR(GetShardStats(index).get_deferred_sessions() == 0U);
+    WAIT_FOR(GetShardStats(index).get_queue_depth() == 0U);
+    EXPECT_LE(static_cast<uint64_t>(2 * Collector::kShardHighWaterMark),
+              GetShardStats(index).get_enqueues());
+    gentest.Shutdown();
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
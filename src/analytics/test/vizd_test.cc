@@ -37,6 +37,8 @@ using ::testing::AnyNumber;
 using ::testing::_;
 using ::testing::Eq;
 using ::testing::ElementsAre;
+using ::testing::Contains;
+using ::testing::Pair;
 
 string sourcehost = "127.0.0.1";
 string collector_server = "127.0.0.1";
@@ -338,58 +340,23 @@ TEST_F(VizdTest, MessagesTest) {
         .WillRepeatedly(Return(true));
 
     EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkConfig", "total_interfaces",
+            UVEUpdateAttrs("UveVirtualNetworkConfig",
+                      AllOf(Contains(Pair("total_interfaces", ::testing::_)),
+                            Contains(Pair("total_virtual_machines", ::testing::_)),
+                            Contains(Pair("connected_networks", ::testing::_)),
+                            Contains(Pair("total_acl_rules", ::testing::_))),
                       "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_, 
-                      ::testing::_, ::testing::_, ::testing::_))
+                      "abc-corp:vn02", ::testing::_))
         .Times(1)
         .WillOnce(Return(true));
 
     EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkConfig", "total_virtual_machines",
+            UVEUpdateAttrs("UveVirtualNetworkAgent",
+                      AllOf(Contains(Pair("in_tpkts", ::testing::_)),
+                            Contains(Pair("in_stats", ::testing::_)),
+                            Contains(Pair("total_acl_rules", ::testing::_))),
                       "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_,
-                      ::testing::_, ::testing::_, ::testing::_))
-        .Times(1)
-        .WillOnce(Return(true));
-
-    EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkConfig", "connected_networks",
-                      "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_,
-                      ::testing::_, ::testing::_, ::testing::_))
-        .Times(1)
-        .WillOnce(Return(true));
-
-    EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkConfig", "total_acl_rules",
-                      "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_,
-                      ::testing::_, ::testing::_, ::testing::_))
-        .Times(1)
-        .WillOnce(Return(true));
-
-    EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkAgent", "in_tpkts",
-                      "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_,
-                      ::testing::_, ::testing::_, ::testing::_))
-        .Times(1)
-        .WillOnce(Return(true));
-
-    EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkAgent", "in_stats",
-                      "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_,
-                      ::testing::_, ::testing::_, ::testing::_))
-        .Times(1)
-        .WillOnce(Return(true));
-
-    EXPECT_CALL(*osp_mock(),
-            UVEUpdate("UveVirtualNetworkAgent", "total_acl_rules",
-                      "127.0.0.1", "GeneratorTest",
-                      "abc-corp:vn02", ::testing::_, ::testing::_,
-                      ::testing::_, ::testing::_, ::testing::_))
+                      "abc-corp:vn02", ::testing::_))
         .Times(1)
         .WillOnce(Return(true));
 
@@ -0,0 +1,24 @@
+--
+-- Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+--
+
+local sm = ARGV[1]..":"..ARGV[2]
+local typ = ARGV[3]
+local key = ARGV[4]
+local seq = ARGV[5]
+
+local _types = KEYS[1]
+local _origins = KEYS[2]
+local _table = KEYS[3]
+local _uves = KEYS[4]
+local _values = KEYS[5]
+
+redis.call('sadd',_types,typ)
+redis.call('sadd',_origins,sm..":"..typ)
+redis.call('sadd',_table,key..':'..sm..":"..typ)
+redis.call('zadd',_uves,seq,key)
+for i = 6,#ARGV,2 do
+    redis.call('hset',_values,ARGV[i],ARGV[i+1])
+end
+
+return true
@@ -5,13 +5,61 @@
 #include "base/logging.h"
 #include "viz_message.h"
 
-RuleMsg::RuleMsg(const boost::shared_ptr<VizMsg> vmsgp) : hdr(vmsgp->hdr),
-    messagetype(vmsgp->messagetype) {
-    pugi::xml_parse_result result = doc_.load(vmsgp->xmlmessage.c_str());
+tbb::mutex VizMsgDocPool::mutex_;
+std::vector<pugi::xml_document *> VizMsgDocPool::free_list_;
+tbb::atomic<uint64_t> VizMsgDocPool::alloc_count_;
+tbb::atomic<uint64_t> VizMsgDocPool::reuse_count_;
+
+XmlDocPtr VizMsgDocPool::Alloc() {
+    pugi::xml_document *doc = NULL;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        if (!free_list_.empty()) {
+            doc = free_list_.back();
+            free_list_.pop_back();
+        }
+    }
+    if (doc) {
+        reuse_count_++;
+    } else {
+        alloc_count_++;
+        doc = new pugi::xml_document;
+    }
+    return XmlDocPtr(doc, &VizMsgDocPool::Release);
+}
+
+void VizMsgDocPool::Release(pugi::xml_document *doc) {
+    doc->reset();
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (free_list_.size() < kMaxFreeDocs) {
+        free_list_.push_back(doc);
+        return;
+    }
+    lock.release();
+    delete doc;
+}
+
+size_t VizMsgDocPool::free_count() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return free_list_.size();
+}
+
+const XmlDocPtr &VizMsg::doc() {
+    if (doc_) {
+        return doc_;
+    }
+    doc_ = VizMsgDocPool::Alloc();
+    pugi::xml_parse_result result = doc_->load_buffer(xmlmessage.c_str(),
+                                                      xmlmessage.size());
     if (!result) {
         LOG(ERROR, __func__ << ": ERROR parsing XML: " << result.description()
-            << " Message: " << vmsgp->xmlmessage);
+            << " Message: " << xmlmessage);
     }
+    return doc_;
+}
+
+RuleMsg::RuleMsg(const boost::shared_ptr<VizMsg> vmsgp) : hdr(vmsgp->hdr),
+    messagetype(vmsgp->messagetype), doc_(vmsgp->doc()) {
 }
 
 RuleMsg::~RuleMsg() {
@@ -50,5 +98,5 @@ int RuleMsg::field_value_recur(const std::string& field_id, std::string& type, s
 }
 
 int RuleMsg::field_value(const std::string& field_id, std::string& type, std::string& value) const {
-    return field_value_recur(field_id, type, value, doc_);
+    return field_value_recur(field_id, type, value, *doc_);
 }
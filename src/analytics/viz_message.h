@@ -6,19 +6,49 @@
 #define __VIZ_MESSAGE_H__
 
 #include <string>
+#include <vector>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include "pugixml/pugixml.hpp"
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
 #include "sandesh/sandesh_types.h"
 
 #define VIZD_ASSERT(condition) assert((condition));
 
+typedef boost::shared_ptr<pugi::xml_document> XmlDocPtr;
+
+/*
+ * Free list of pugixml documents used by the collector message pipeline.
+ * Documents handed out by Alloc are returned to the pool, after a reset,
+ * when the last reference to them goes away.
+ */
+class VizMsgDocPool {
+public:
+    static const size_t kMaxFreeDocs = 1024;
+
+    static XmlDocPtr Alloc();
+
+    static size_t free_count();
+    static uint64_t alloc_count() { return alloc_count_; }
+    static uint64_t reuse_count() { return reuse_count_; }
+
+private:
+    static void Release(pugi::xml_document *doc);
+
+    static tbb::mutex mutex_;
+    static std::vector<pugi::xml_document *> free_list_;
+    static tbb::atomic<uint64_t> alloc_count_;
+    static tbb::atomic<uint64_t> reuse_count_;
+};
+
 /* message format used to store in the cassandra */
 struct VizMsg {
-    VizMsg(SandeshHeader hdr,
-            std::string mtype,
-            std::string xmlmessage,
+    VizMsg(const SandeshHeader &hdr,
+            const std::string &mtype,
+            const std::string &xmlmessage,
             boost::uuids::uuid unm) :
         hdr(hdr),
         messagetype(mtype),
@@ -26,10 +56,20 @@ struct VizMsg {
         unm(unm) {}
     ~VizMsg() {}
 
+    /*
+     * Parsed form of xmlmessage. The message is parsed the first time the
+     * document is requested and the same document is shared by the rule
+     * engine, object log and flow table processing.
+     */
+    const XmlDocPtr &doc();
+
     SandeshHeader hdr;
     std::string messagetype;
     std::string xmlmessage;
     boost::uuids::uuid unm; /* uuid key for this message in the global table */
+
+private:
+    XmlDocPtr doc_;
 };
 
 /* generic message for ruleeng processing */
@@ -43,7 +83,7 @@ struct RuleMsg {
         std::string messagetype;
 
         const pugi::xml_node get_doc() const {
-            return doc_;
+            return *doc_;
         }
 
         struct RuleMsgPredicate {
@@ -61,7 +101,7 @@ struct RuleMsg {
 
         int field_value_recur(const std::string& field_id, std::string& type, std::string& value, pugi::xml_node doc) const;
 
-        pugi::xml_document doc_;
+        XmlDocPtr doc_;
 };
 
 #endif
@@ -4,6 +4,7 @@
 
 #include "base/bitset.h"
 
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <string.h>
@@ -11,42 +12,22 @@
 using namespace std;
 
 //
-// Provides the same functionality as ffsl.  Needed as ffsl is not supported
-// on all platforms. Note that the positions are numbered 1 through 64, with
-// a return value of 0 indicating that there are no set bits.
+// Return the position of the lowest set bit, starting at 0.  The value must
+// not be 0.
 //
-static int find_first_set64(uint64_t value) {
-    int bit;
-
-    int lower = value;
-    if ((bit = ffs(lower)) > 0)
-        return bit;
-
-    int upper = value >> 32;
-    if ((bit = ffs(upper)) > 0)
-        return 32 + bit;
-
-    return 0;
-}
-
-static int find_first_clear64(uint64_t value) {
-    return find_first_set64(~value);
+static inline int find_first_set64(uint64_t value) {
+    return __builtin_ctzll(value);
 }
 
 //
-// Return the number of set bits. K&R method.
+// Return the number of set bits.
 //
-static int num_bits_set(uint64_t value) {
-    int count = 0;
-    while (value != 0) {
-        value &= value - 1;
-        count++;
-    }
-    return count;
+static inline int num_bits_set(uint64_t value) {
+    return __builtin_popcountll(value);
 }
 
 // Position pos is w.r.t the entire bitset, starts at 0.
-// Index    idx is the block number i.e. the index in the vector, starts at 0.
+// Index    idx is the block number i.e. the index in the array, starts at 0.
 // Offset   offset is w.r.t a given 64 bit block, starts at 0.
 static inline size_t block_index(size_t pos) {
     return pos / 64;
@@ -61,26 +42,70 @@ static inline size_t bit_position(size_t idx, size_t offset) {
 }
 
 const size_t BitSet::npos;
+const size_t BitSet::kInlineBlocks;
+
+BitSet::BitSet() : size_(0) {
+    memset(inline_, 0, sizeof(inline_));
+}
+
+//
+// Grow the number of blocks in use to the given size.  The new blocks are
+// already 0.  Blocks move from the inline array to the vector the first
+// time the inline array is too small, and the vector at least doubles in
+// size whenever it grows.
+//
+void BitSet::resize(size_t size) {
+    if (size <= size_)
+        return;
+
+    if (size > capacity()) {
+        size_t new_capacity = std::max(size, 2 * capacity());
+        if (heap_.empty()) {
+            heap_.resize(new_capacity);
+            std::copy(inline_, inline_ + size_, heap_.begin());
+            memset(inline_, 0, sizeof(inline_));
+        } else {
+            heap_.resize(new_capacity);
+        }
+    }
+    size_ = size;
+}
+
+//
+// Shrink the number of blocks in use to the given size, clearing the blocks
+// that are no longer in use.
+//
+void BitSet::shrink(size_t size) {
+    if (size >= size_)
+        return;
+
+    uint64_t *data = blocks();
+    std::fill(data + size, data + size_, 0);
+    size_ = size;
+}
 
 //
-// Set bit at given position, growing the vector if needed.
+// Set bit at given position, growing the bitset if needed.
 //
 BitSet &BitSet::set(size_t pos) {
     size_t idx = block_index(pos);
-    if (idx >= blocks_.size())
-        blocks_.resize(idx + 1);
-    blocks_[idx] |= 1LL << block_offset(pos);
+    if (idx >= size_)
+        resize(idx + 1);
+    blocks()[idx] |= 1ULL << block_offset(pos);
     return *this;
 }
 
 //
-// Reset bit at given position, shrinking the vector if possible.
+// Reset bit at given position, shrinking the bitset if possible.  There's
+// nothing to shrink unless the last block becomes 0.
 //
 BitSet &BitSet::reset(size_t pos) {
     size_t idx = block_index(pos);
-    if (idx < blocks_.size()) {
-        blocks_[idx] &= ~(1LL << block_offset(pos));
-        compact();
+    if (idx < size_) {
+        uint64_t *data = blocks();
+        data[idx] &= ~(1ULL << block_offset(pos));
+        if (idx == size_ - 1 && data[idx] == 0)
+            compact();
     }
     return *this;
 }
@@ -88,8 +113,8 @@ BitSet &BitSet::reset(size_t pos) {
 // Test bit at given position.
 bool BitSet::test(size_t pos) const {
     size_t idx = block_index(pos);
-    if (idx < blocks_.size()) {
-        return ((blocks_[idx] & (1LL << block_offset(pos))) != 0);
+    if (idx < size_) {
+        return ((blocks()[idx] & (1ULL << block_offset(pos))) != 0);
     } else {
         return false;
     }
@@ -99,73 +124,61 @@ bool BitSet::test(size_t pos) const {
 // Shortcut to reset all bits in the bitset.
 //
 void BitSet::clear() {
-    blocks_.resize(0);
+    shrink(0);
 }
 
 //
 // Return true if there are no bits in the bitset.
 //
 bool BitSet::empty() const {
-    return (blocks_.size() == 0);
+    return (size_ == 0);
 }
 
 //
 // Return true if no bits are set.
 //
 bool BitSet::none() const {
-    return (blocks_.size() == 0);
+    return (size_ == 0);
 }
 
 //
 // Return true at least one bit is set.
 //
 bool BitSet::any() const {
-    return (blocks_.size() != 0);
+    return (size_ != 0);
 }
 
 //
 // Return the raw number of bits in the bitset. Simply depends on the number
-// of blocks in the vector.
+// of blocks in use.
 //
 size_t BitSet::size() const {
-    return blocks_.size() * 64;
+    return size_ * 64;
 }
 
 //
 // Return total number of set bits.
 //
 size_t BitSet::count() const {
+    const uint64_t *data = blocks();
     size_t count = 0;
-    for (size_t idx = 0; idx < blocks_.size(); idx++) {
-        count += num_bits_set(blocks_[idx]);
+    for (size_t idx = 0; idx < size_; idx++) {
+        count += num_bits_set(data[idx]);
     }
     return count;
 }
 
 //
-// Shrink the underlying vector as much as possible.  All trailing blocks
-// that are 0 can be removed.
-//
-// Note that the for loop does not handle idx 0 since the loop  variable
-// is unsigned.
+// Shrink the bitset as much as possible.  All trailing blocks that are 0
+// can be removed.
 //
 void BitSet::compact() {
-    if (blocks_.size() == 0)
-        return;
-
-    for (size_t idx = blocks_.size() - 1; idx > 0; idx--) {
-        if (blocks_[idx] != 0) {
-            blocks_.resize(idx + 1);
-            return;
-        }
-    }
-
-    if (blocks_[0] != 0) {
-        blocks_.resize(1);
-        return;
+    const uint64_t *data = blocks();
+    size_t size = size_;
+    while (size > 0 && data[size - 1] == 0) {
+        size--;
     }
-
-    blocks_.clear();
+    size_ = size;
 }
 
 //
@@ -173,66 +186,60 @@ void BitSet::compact() {
 // after any compaction is done or in cases where no compaction is needed.
 //
 void BitSet::check_invariants() {
-    size_t mysize = blocks_.size();
-    if (mysize != 0)
-        assert(blocks_[mysize -1] != 0);
+    if (size_ != 0)
+        assert(blocks()[size_ - 1] != 0);
 }
 
 //
-// Return the position of the first set bit.  Needs to compensate for the
-// return value convention used by find_first_set64.
+// Return the position of the first set bit.
 //
 size_t BitSet::find_first() const {
-    for (size_t idx = 0; idx < blocks_.size(); idx++) {
-        int bit = find_first_set64(blocks_[idx]);
-        if (bit > 0)
-            return bit_position(idx, bit - 1);
+    const uint64_t *data = blocks();
+    for (size_t idx = 0; idx < size_; idx++) {
+        if (data[idx] != 0)
+            return bit_position(idx, find_first_set64(data[idx]));
     }
     return BitSet::npos;
 }
 
 //
-// Return the position of the next set bit.  Needs to compensate for the
-// return value convention used by find_first_set64.
+// Return the position of the next set bit.
 //
 size_t BitSet::find_next(size_t pos) const {
     size_t idx = block_index(pos);
 
-    // If the block index is beyond the vector, we're done.
-    if (idx >= blocks_.size())
+    // If the block index is beyond the last block, we're done.
+    if (idx >= size_)
         return BitSet::npos;
 
     // If the offset is not 63, clear out the bits from 0 through offset
     // and look for the first set bit.
+    const uint64_t *data = blocks();
     if (block_offset(pos) < 63) {
-        uint64_t temp = blocks_[idx] & ~((1LL << (block_offset(pos) + 1)) - 1);
-        int bit = find_first_set64(temp);
-        if (bit > 0)
-            return bit_position(idx, bit - 1);
+        uint64_t temp = data[idx] & (~0ULL << (block_offset(pos) + 1));
+        if (temp != 0)
+            return bit_position(idx, find_first_set64(temp));
     }
 
     // Go through all blocks after the start block for the pos and see if
     // there's a set bit.
-    for (idx++; idx < blocks_.size(); idx++) {
-        int bit = find_first_set64(blocks_[idx]);
-        if (bit > 0)
-            return bit_position(idx, bit - 1);
+    for (idx++; idx < size_; idx++) {
+        if (data[idx] != 0)
+            return bit_position(idx, find_first_set64(data[idx]));
     }
     return BitSet::npos;
 }
 
 //
 // Return the position of the first clear bit.  It could be beyond the last
-// block in the vector. This is fine as we automatically grow the vector if
-// needed from set().
-//
-// Need to compensate for return value convention used by find_first_clear64.
+// block in use. This is fine as we automatically grow the bitset if needed
+// from set().
 //
 size_t BitSet::find_first_clear() const {
-    for (size_t idx = 0; idx < blocks_.size(); idx++) {
-        int bit = find_first_clear64(blocks_[idx]);
-        if (bit > 0) {
-            return bit_position(idx, bit - 1);
+    const uint64_t *data = blocks();
+    for (size_t idx = 0; idx < size_; idx++) {
+        if (~data[idx] != 0) {
+            return bit_position(idx, find_first_set64(~data[idx]));
         }
     }
     return size();
@@ -240,33 +247,30 @@ size_t BitSet::find_first_clear() const {
 
 //
 // Return the position of the next clear bit.  It could be beyond the last
-// block in the vector. This is fine as we automatically grow the vector if
-// needed from set().
-//
-// Need to compensate for return value convention used by find_first_clear64.
+// block in use. This is fine as we automatically grow the bitset if needed
+// from set().
 //
 size_t BitSet::find_next_clear(size_t pos) const {
     size_t idx = block_index(pos);
 
-    // If the block index is beyond the vector, we're done.
-    if (idx >= blocks_.size())
+    // If the block index is beyond the last block, we're done.
+    if (idx >= size_)
         return pos + 1;
 
     // If the offset is not 63, set all the bits from 0 through offset and
     // look for the first clear bit.
+    const uint64_t *data = blocks();
     if (block_offset(pos) < 63) {
-        uint64_t temp = blocks_[idx] | ((1LL << (block_offset(pos) + 1)) - 1);
-        int bit = find_first_clear64(temp);
-        if (bit > 0)
-            return bit_position(idx, bit - 1);
+        uint64_t temp = ~data[idx] & (~0ULL << (block_offset(pos) + 1));
+        if (temp != 0)
+            return bit_position(idx, find_first_set64(temp));
     }
 
     // Go through all blocks after the start block for the pos and see if
     // there's a clear bit.
-    for (idx++; idx < blocks_.size(); idx++) {
-        int bit = find_first_clear64(blocks_[idx]);
-        if (bit > 0) {
-            return bit_position(idx, bit - 1);
+    for (idx++; idx < size_; idx++) {
+        if (~data[idx] != 0) {
+            return bit_position(idx, find_first_set64(~data[idx]));
         }
     }
     return size();
@@ -275,29 +279,31 @@ size_t BitSet::find_next_clear(size_t pos) const {
 //
 // Return (*this & rhs != 0).
 //
+// The loop accumulates the result instead of returning early so that the
+// compiler can vectorize it.  Bitsets are small enough that looking at all
+// the common blocks is cheaper than a branch per block.
+//
 bool BitSet::intersects(const BitSet &rhs) const {
-    size_t minsize = std::min(blocks_.size(), rhs.blocks_.size());
+    size_t minsize = std::min(size_, rhs.size_);
+    const uint64_t *lhs_data = blocks();
+    const uint64_t *rhs_data = rhs.blocks();
+    uint64_t result = 0;
     for (size_t idx = 0; idx < minsize; idx++) {
-        if (blocks_[idx] & rhs.blocks_[idx])
-            return true;
+        result |= lhs_data[idx] & rhs_data[idx];
     }
-    return false;
+    return (result != 0);
 }
 
 //
 // Return (*this == rhs).
 //
-// Note that it's fine to first compare the number of blocks in the vectors
-// since we always shrink the vectors whenever possible.
+// Note that it's fine to first compare the number of blocks since we always
+// shrink the bitsets whenever possible.
 //
 bool BitSet::operator==(const BitSet &rhs) const {
-    if (blocks_.size() != rhs.blocks_.size())
+    if (size_ != rhs.size_)
         return false;
-    for (size_t idx = 0; idx < blocks_.size(); idx++) {
-        if (blocks_[idx] != rhs.blocks_[idx])
-            return false;
-    }
-    return true;
+    return std::equal(blocks(), blocks() + size_, rhs.blocks());
 }
 
 //
@@ -321,43 +327,24 @@ BitSet BitSet::operator&(const BitSet &rhs) const {
 // Return (*this | rhs).
 //
 BitSet BitSet::operator|(const BitSet &rhs) const {
-    BitSet temp;
-    size_t minsize = std::min(blocks_.size(), rhs.blocks_.size());
-    size_t maxsize = std::max(blocks_.size(), rhs.blocks_.size());
-    temp.blocks_.resize(maxsize);
-
-    // Process common blocks.
-    for (size_t idx = 0; idx < minsize; idx++) {
-        temp.blocks_[idx] = blocks_[idx] | rhs.blocks_[idx];
-    }
-
-    // Process blocks that exist in LHS only. It's a noop if RHS is bigger.
-    for (size_t idx = minsize; idx < blocks_.size(); idx++) {
-        temp.blocks_[idx] = blocks_[idx];
-    }
-
-    // Process blocks that exist in RHS only. It's a noop if LHS is bigger.
-    for (size_t idx = minsize; idx < rhs.blocks_.size(); idx++) {
-        temp.blocks_[idx] = rhs.blocks_[idx];
-    }
-
-    temp.check_invariants();
+    BitSet temp(*this);
+    temp |= rhs;
     return temp;
 }
 
 //
 // Implement (*this &= rhs).
 //
-// Note that we can't simply resize the vector to minsize since we may be
-// able to shrink it even more depending on the values in the blocks.
+// Note that we can't simply shrink to minsize since we may be able to
+// shrink even more depending on the values in the blocks.
 //
 BitSet &BitSet::operator&=(const BitSet &rhs) {
-    size_t minsize = std::min(blocks_.size(), rhs.blocks_.size());
+    size_t minsize = std::min(size_, rhs.size_);
+    shrink(minsize);
+    uint64_t *lhs_data = blocks();
+    const uint64_t *rhs_data = rhs.blocks();
     for (size_t idx = 0; idx < minsize; idx++) {
-        blocks_[idx] &= rhs.blocks_[idx];
-    }
-    for (size_t idx = minsize; idx < blocks_.size(); idx++) {
-        blocks_[idx] = 0;
+        lhs_data[idx] &= rhs_data[idx];
     }
     compact();
     check_invariants();
@@ -367,14 +354,15 @@ BitSet &BitSet::operator&=(const BitSet &rhs) {
 //
 // Implement (*this |= rhs).
 //
-// Note that we grow the vector only once instead of doing it multiple
+// Note that we grow the bitset only once instead of doing it multiple
 // times.
 //
 BitSet &BitSet::operator|=(const BitSet &rhs) {
-    if (blocks_.size() < rhs.blocks_.size())
-        blocks_.resize(rhs.blocks_.size());
-    for (size_t idx = 0; idx < rhs.blocks_.size(); idx++) {
-        blocks_[idx] |= rhs.blocks_[idx];
+    resize(rhs.size_);
+    uint64_t *lhs_data = blocks();
+    const uint64_t *rhs_data = rhs.blocks();
+    for (size_t idx = 0; idx < rhs.size_; idx++) {
+        lhs_data[idx] |= rhs_data[idx];
     }
     check_invariants();
     return *this;
@@ -392,9 +380,11 @@ void BitSet::Set(const BitSet &rhs) {
 // Implement (*this &= ~rhs).
 //
 void BitSet::Reset(const BitSet &rhs) {
-    size_t minsize = std::min(blocks_.size(), rhs.blocks_.size());
+    size_t minsize = std::min(size_, rhs.size_);
+    uint64_t *lhs_data = blocks();
+    const uint64_t *rhs_data = rhs.blocks();
     for (size_t idx = 0; idx < minsize; idx++) {
-        blocks_[idx] &= ~rhs.blocks_[idx];
+        lhs_data[idx] &= ~rhs_data[idx];
     }
     compact();
     check_invariants();
@@ -403,20 +393,21 @@ void BitSet::Reset(const BitSet &rhs) {
 //
 // Implement (*this = lhs & ~rhs).
 //
-// Note that we won't enter the second for loop at all if lhs is not bigger
-// than rhs.  Need to compact only for this case, but it is cheap enough to
-// try (and do nothing) when lhs is bigger than rhs.
+// Blocks of lhs past the end of rhs are copied as is.  Need to compact only
+// if lhs is not bigger than rhs, but it is cheap enough to try (and do
+// nothing) when lhs is bigger than rhs.
 //
 void BitSet::BuildComplement(const BitSet &lhs, const BitSet &rhs) {
-    blocks_.clear();
-    blocks_.resize(lhs.blocks_.size());
-    size_t minsize = std::min(blocks_.size(), rhs.blocks_.size());
+    shrink(0);
+    resize(lhs.size_);
+    size_t minsize = std::min(lhs.size_, rhs.size_);
+    uint64_t *data = blocks();
+    const uint64_t *lhs_data = lhs.blocks();
+    const uint64_t *rhs_data = rhs.blocks();
     for (size_t idx = 0; idx < minsize; idx++) {
-        blocks_[idx] = lhs.blocks_[idx] & ~rhs.blocks_[idx];
-    }
-    for (size_t idx = minsize; idx < lhs.blocks_.size(); idx++) {
-        blocks_[idx] = lhs.blocks_[idx];
+        data[idx] = lhs_data[idx] & ~rhs_data[idx];
     }
+    std::copy(lhs_data + minsize, lhs_data + lhs.size_, data + minsize);
     compact();
     check_invariants();
 }
@@ -424,47 +415,33 @@ void BitSet::BuildComplement(const BitSet &lhs, const BitSet &rhs) {
 //
 // Implement (*this = lhs & rhs).
 //
-// We avoid the need to compact or to resize multiple times by building
-// the blocks in reverse order.
-//
-// Note that the for loop does not handle idx 0 since the loop  variable
-// is unsigned.
-//
 void BitSet::BuildIntersection(const BitSet &lhs, const BitSet &rhs) {
-    blocks_.clear();
-    size_t minsize = std::min(lhs.blocks_.size(), rhs.blocks_.size());
-
-    if (minsize == 0)
-        return;
-
-    for (size_t idx = minsize - 1; idx > 0; idx--) {
-        if (lhs.blocks_[idx] & rhs.blocks_[idx]) {
-            if (blocks_.size() == 0)
-                blocks_.resize(idx + 1);
-            blocks_[idx] = lhs.blocks_[idx] & rhs.blocks_[idx];
-        }
-    }
-
-    if (lhs.blocks_[0] & rhs.blocks_[0]) {
-        if (blocks_.size() == 0)
-            blocks_.resize(1);
-        blocks_[0] = lhs.blocks_[0] & rhs.blocks_[0];
+    shrink(0);
+    size_t minsize = std::min(lhs.size_, rhs.size_);
+    resize(minsize);
+    uint64_t *data = blocks();
+    const uint64_t *lhs_data = lhs.blocks();
+    const uint64_t *rhs_data = rhs.blocks();
+    for (size_t idx = 0; idx < minsize; idx++) {
+        data[idx] = lhs_data[idx] & rhs_data[idx];
     }
-
+    compact();
     check_invariants();
 }
 
 //
-// Return true if *this contains rhs.  Implemented as (rhs & ~*this != 0).
+// Return true if *this contains rhs.  Implemented as (rhs & ~*this == 0).
 //
 bool BitSet::Contains(const BitSet &rhs) const {
-    if (blocks_.size() < rhs.blocks_.size())
+    if (size_ < rhs.size_)
         return false;
-    for (size_t idx = 0; idx < rhs.blocks_.size(); idx++) {
-        if (rhs.blocks_[idx] & ~blocks_[idx])
-            return false;
+    const uint64_t *lhs_data = blocks();
+    const uint64_t *rhs_data = rhs.blocks();
+    uint64_t result = 0;
+    for (size_t idx = 0; idx < rhs.size_; idx++) {
+        result |= rhs_data[idx] & ~lhs_data[idx];
     }
-    return true;
+    return (result == 0);
 }
 
 //
@@ -494,7 +471,7 @@ string BitSet::ToString() const {
 // is unsigned.
 //
 void BitSet::FromString(string str) {
-    blocks_.clear();
+    clear();
 
     if (str.length() == 0)
         return;
@@ -12,12 +12,19 @@
 //
 // BitSet automatically resizes the bit set when needed and allows for
 // logical operations between bitsets of different sizes.  Implemented
-// using a vector of uint64_t as the underlying storage.
+// using an array of uint64_t blocks as the underlying storage.
+//
+// The first kInlineBlocks blocks are stored in the BitSet itself, so sets
+// of up to 256 bits, which covers typical peer counts, do not allocate any
+// memory.  Larger sets move all blocks to a vector, which is kept for the
+// lifetime of the BitSet.
 //
 class BitSet {
 public:
     static const size_t npos = static_cast<size_t>(-1);
 
+    BitSet();
+
     BitSet &set(size_t pos);
     BitSet &reset(size_t pos);
     bool test(size_t pos) const;
@@ -51,10 +58,25 @@ public:
 private:
     friend class BitSetTest;
 
+    static const size_t kInlineBlocks = 4;
+
+    uint64_t *blocks() { return heap_.empty() ? inline_ : &heap_[0]; }
+    const uint64_t *blocks() const {
+        return heap_.empty() ? inline_ : &heap_[0];
+    }
+    size_t capacity() const {
+        return heap_.empty() ? kInlineBlocks : heap_.size();
+    }
+
+    void resize(size_t size);
+    void shrink(size_t size);
     void compact();
     void check_invariants();
 
-    std::vector<uint64_t> blocks_;
+    // Number of blocks in use.  All blocks past size_ are 0.
+    size_t size_;
+    uint64_t inline_[kInlineBlocks];
+    std::vector<uint64_t> heap_;
 };
 
 #endif
@@ -52,51 +52,178 @@ size_t LabelBlockManager::size() {
 LabelBlock::LabelBlock(uint32_t first, uint32_t last)
     : block_manager_(NULL),
       first_(first),
-      last_(last),
-      prev_pos_(BitSet::npos) {
+      last_(last) {
       refcount_ = 0;
+      fallback_idx_ = 0;
+      Initialize();
 }
 
 LabelBlock::LabelBlock(
         LabelBlockManager *block_manager, uint32_t first, uint32_t last)
     : block_manager_(block_manager),
       first_(first),
-      last_(last),
-      prev_pos_(BitSet::npos) {
+      last_(last) {
       refcount_ = 0;
+      fallback_idx_ = 0;
+      Initialize();
 }
 
 LabelBlock::~LabelBlock() {
-    assert(used_bitset_.empty());
+    for (size_t idx = 0; idx < sub_blocks_.size(); idx++) {
+        assert(sub_blocks_[idx].empty());
+    }
     if (block_manager_)
         block_manager_->RemoveBlock(this);
 }
 
-uint32_t LabelBlock::AllocateLabel() {
-    mutex::scoped_lock lock(mutex_);
+//
+// Split the block into sub-blocks. All sub-blocks except the last one have
+// a size that is a multiple of 64. The size is rounded up so that there are
+// never more than count sub-blocks.
+//
+void LabelBlock::Initialize() {
+    assert(first_ <= last_);
+    size_t size = static_cast<size_t>(last_ - first_) + 1;
+    size_t count = size / kMinSubBlockSize;
+    if (count > kMaxSubBlockCount) {
+        count = kMaxSubBlockCount;
+    } else if (count == 0) {
+        count = 1;
+    }
 
-    size_t pos;
-    for (int idx = 0; idx < 2; prev_pos_ = BitSet::npos, idx++) {
-        if (prev_pos_ == BitSet::npos) {
-            pos = used_bitset_.find_first_clear();
-        } else {
-            pos = used_bitset_.find_next_clear(prev_pos_);
-        }
+    sub_block_size_ =
+        ((size + count - 1) / count + 63) & ~static_cast<size_t>(63);
+    for (size_t base = 0; base < size; base += sub_block_size_) {
+        size_t remaining = size - base;
+        sub_blocks_.push_back(new SubBlock(base,
+            remaining < sub_block_size_ ? remaining : sub_block_size_));
+    }
+}
 
-        if (first_ + pos <= last_) {
-            used_bitset_.set(pos);
-            prev_pos_ = pos;
-            return (first_ + pos);
-        }
+//
+// Allocate from the sub-block selected by the hint, and from the others in
+// turn if it is full. The fallback starts with the sub-block that the last
+// fallback allocation came from, so that it keeps filling that sub-block
+// rather than the single labels released in other full sub-blocks.
+//
+uint32_t LabelBlock::AllocateLabel(size_t hint) {
+    size_t count = sub_blocks_.size();
+    uint32_t offset;
+    if (sub_blocks_[hint % count].Allocate(&offset)) {
+        return (first_ + offset);
     }
 
+    size_t start = fallback_idx_;
+    size_t idx = start;
+    do {
+        if (sub_blocks_[idx].Allocate(&offset)) {
+            fallback_idx_ = idx;
+            return (first_ + offset);
+        }
+        if (++idx == count)
+            idx = 0;
+    } while (idx != start);
+
     return 0;
 }
 
 void LabelBlock::ReleaseLabel(uint32_t value) {
+    assert(value >= first_ && value <= last_);
+    uint32_t offset = value - first_;
+    sub_blocks_[offset / sub_block_size_].Release(offset);
+}
+
+LabelBlock::SubBlock::SubBlock(uint32_t base, size_t size)
+    : base_(base),
+      size_(size),
+      prev_pos_(size),
+      leaf_((size + 63) / 64, 0),
+      summary_((leaf_.size() + 63) / 64, 0) {
+    used_count_ = 0;
+    if (size_ % 64 != 0) {
+        leaf_.back() = ~0ULL << (size_ % 64);
+    }
+    if (leaf_.size() % 64 != 0) {
+        summary_.back() = ~0ULL << (leaf_.size() % 64);
+    }
+}
+
+static inline size_t find_first_set64(uint64_t value) {
+    return __builtin_ctzll(value);
+}
+
+//
+// Return the position of the first clear bit at or after start, or size_ if
+// there is none.
+//
+size_t LabelBlock::SubBlock::FindClear(size_t start) const {
+    if (start >= size_)
+        return size_;
+
+    // Skip the leaf word if the summary says that it is full
+    size_t idx = start / 64;
+    uint64_t word;
+    if ((summary_[idx / 64] & (1ULL << (idx % 64))) == 0) {
+        word = ~leaf_[idx] & (~0ULL << (start % 64));
+        if (word != 0)
+            return idx * 64 + find_first_set64(word);
+    }
+
+    // Look for the next leaf word that is not full
+    idx++;
+    if (idx >= leaf_.size())
+        return size_;
+    size_t sidx = idx / 64;
+    word = ~summary_[sidx] & (~0ULL << (idx % 64));
+    while (word == 0) {
+        if (++sidx >= summary_.size())
+            return size_;
+        word = ~summary_[sidx];
+    }
+    idx = sidx * 64 + find_first_set64(word);
+    return idx * 64 + find_first_set64(~leaf_[idx]);
+}
+
+void LabelBlock::SubBlock::Set(size_t pos) {
+    size_t idx = pos / 64;
+    leaf_[idx] |= 1ULL << (pos % 64);
+    if (leaf_[idx] == ~0ULL) {
+        summary_[idx / 64] |= 1ULL << (idx % 64);
+    }
+    used_count_++;
+}
+
+bool LabelBlock::SubBlock::Allocate(uint32_t *offset) {
+    if (full())
+        return false;
+
     mutex::scoped_lock lock(mutex_);
 
-    assert(value >= first_ && value <= last_);
-    size_t pos = value - first_;
-    used_bitset_.reset(pos);
+    size_t pos = FindClear(prev_pos_ + 1);
+    if (pos == size_) {
+        pos = FindClear(0);
+        if (pos == size_)
+            return false;
+    }
+
+    Set(pos);
+    prev_pos_ = pos;
+    *offset = base_ + pos;
+    return true;
+}
+
+void LabelBlock::SubBlock::Release(uint32_t offset) {
+    mutex::scoped_lock lock(mutex_);
+
+    assert(offset >= base_ && offset - base_ < size_);
+    size_t pos = offset - base_;
+    size_t idx = pos / 64;
+    uint64_t mask = 1ULL << (pos % 64);
+    if ((leaf_[idx] & mask) == 0)
+        return;
+    if (leaf_[idx] == ~0ULL) {
+        summary_[idx / 64] &= ~(1ULL << (idx % 64));
+    }
+    leaf_[idx] &= ~mask;
+    used_count_--;
 }
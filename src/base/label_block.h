@@ -5,11 +5,14 @@
 #ifndef ctrlplane_label_block_h
 #define ctrlplane_label_block_h
 
+#include <stdint.h>
 #include <vector>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 
-#include "base/bitset.h"
+#include "base/util.h"
 
 class LabelBlock;
 class LabelBlockManager;
@@ -68,25 +71,29 @@ inline void intrusive_ptr_release(LabelBlockManager *block_manager) {
 // As mentioned above, clients always maintain an intrusive pointer to these
 // objects.
 //
-// A BitSet is used to keep track of used/allocated values. A position in the
-// BitSet represents an offset from the first value e.g. label value of first
-// corresponds to bit position 0.
-//
-// TBD: A BitSet is not time efficient when managing a large label space so
-// we should revisit the implementation of this class. Perhaps we could use
-// an itable or a hierarchy of BitSets.
+// Large blocks are split into up to kMaxSubBlockCount sub-blocks of at least
+// kMinSubBlockSize labels, each with its own mutex. Clients pass a hint, such
+// as a partition index, to select the sub-block to allocate from first, so
+// that clients with different hints do not contend. Allocation falls back
+// to the other sub-blocks when the preferred one is full, starting with the
+// one that the last fallback allocation came from.
 //
 class LabelBlock {
 public:
+    static const size_t kMinSubBlockSize = 1024;
+    static const size_t kMaxSubBlockCount = 16;
+
     LabelBlock(uint32_t first, uint32_t last);
     LabelBlock(LabelBlockManager *block_manager, uint32_t first, uint32_t last);
     ~LabelBlock();
 
-    uint32_t AllocateLabel();
+    // Returns 0 if all labels in the block are in use.
+    uint32_t AllocateLabel(size_t hint = 0);
     void ReleaseLabel(uint32_t value);
     uint32_t first() { return first_; }
     uint32_t last() { return last_; }
     LabelBlockManagerPtr block_manager() { return block_manager_; }
+    size_t sub_block_count() const { return sub_blocks_.size(); }
 
 private:
     friend class LabelBlockManager;
@@ -94,15 +101,54 @@ private:
     friend void intrusive_ptr_add_ref(LabelBlock *block);
     friend void intrusive_ptr_release(LabelBlock *block);
 
+    //
+    // A contiguous range of labels within the block, tracked by a two level
+    // bitmap. A bit in leaf_ is set when the label is used, and a bit in
+    // summary_ is set when the corresponding leaf word is full. Bits past the
+    // end of the range are set at construction so that they are never found.
+    //
+    // Finding a clear bit looks at one leaf word and then at summary words,
+    // each of which covers 4096 labels.
+    //
+    // Labels are allocated in a circular fashion starting after the label
+    // allocated last, so that a released label is not reused right away.
+    //
+    class SubBlock {
+    public:
+        SubBlock(uint32_t base, size_t size);
+
+        bool Allocate(uint32_t *offset);
+        void Release(uint32_t offset);
+        bool empty() const { return used_count_ == 0; }
+        bool full() const { return used_count_ == size_; }
+
+    private:
+        size_t FindClear(size_t start) const;
+        void Set(size_t pos);
+
+        // The bitmap is protected via the mutex_. This is needed since we
+        // need to handle concurrent calls to Allocate/Release. The used
+        // count is only updated with the mutex_ held, but is atomic so that
+        // a full sub-block can be skipped without taking the mutex_.
+        tbb::mutex mutex_;
+        uint32_t base_;
+        size_t size_;
+        size_t prev_pos_;
+        tbb::atomic<size_t> used_count_;
+        std::vector<uint64_t> leaf_;
+        std::vector<uint64_t> summary_;
+
+        DISALLOW_COPY_AND_ASSIGN(SubBlock);
+    };
+
+    void Initialize();
+
     LabelBlockManagerPtr block_manager_;
     uint32_t first_, last_;
-    size_t prev_pos_;
     tbb::atomic<int> refcount_;
-
-    // The BitSet of used labels is protected via the mutex_. This is needed
-    // since we need to handle concurrent calls to AllocateLabel/ReleaseLabel.
-    tbb::mutex mutex_;
-    BitSet used_bitset_;
+    size_t sub_block_size_;
+    tbb::atomic<size_t> fallback_idx_;
+    boost::ptr_vector<SubBlock> sub_blocks_;
 };
 
 inline void intrusive_ptr_add_ref(LabelBlock *block) {
@@ -4,14 +4,28 @@
 
 #include "base/bitset.h"
 #include "base/logging.h"
+#include "base/util.h"
 #include "testing/gunit.h"
 
 using namespace std;
 
 class BitSetTest : public ::testing::Test {
 protected:
-    vector<uint64_t> &get_blocks(BitSet &bitset) {
-        return bitset.blocks_;
+    // Read only view of the blocks in use in a bitset.
+    class BlockView {
+    public:
+        explicit BlockView(const BitSet &bitset) : bitset_(bitset) { }
+        size_t size() const { return bitset_.size_; }
+        uint64_t operator[](size_t idx) const {
+            return bitset_.blocks()[idx];
+        }
+
+    private:
+        const BitSet &bitset_;
+    };
+
+    BlockView get_blocks(const BitSet &bitset) {
+        return BlockView(bitset);
     }
 };
 
@@ -26,7 +40,7 @@ static int num_bits_set(uint64_t value) {
 
 TEST_F(BitSetTest, Basic) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
     EXPECT_EQ(bitset.size(), 0);
     EXPECT_EQ(blocks.size(), 0);
 }
@@ -35,7 +49,7 @@ TEST_F(BitSetTest, Basic) {
 TEST_F(BitSetTest, set1) {
     for (int pos = 0; pos <= 63; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), 1);
         EXPECT_EQ(blocks[0],  1LL << pos);
@@ -47,7 +61,7 @@ TEST_F(BitSetTest, set1) {
 TEST_F(BitSetTest, set2) {
     for (int pos = 128; pos <= 191; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), 3);
         EXPECT_EQ(blocks[0], 0 );
@@ -61,7 +75,7 @@ TEST_F(BitSetTest, set2) {
 TEST_F(BitSetTest, set3)  {
     for (int pos = 0; pos <= 1023; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), pos / 64 + 1);
         EXPECT_EQ(blocks[pos / 64], 1LL << (pos % 64));
@@ -72,7 +86,7 @@ TEST_F(BitSetTest, set3)  {
 // Set all bits within block idx 1 and verify.
 TEST_F(BitSetTest, set4) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
     for (int pos = 64; pos <= 127; pos++) {
         bitset.set(pos);
     }
@@ -85,7 +99,7 @@ TEST_F(BitSetTest, set4) {
 TEST_F(BitSetTest, reset1) {
     for (int pos = 0; pos <= 63; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), 1);
         bitset.reset(pos);
@@ -97,7 +111,7 @@ TEST_F(BitSetTest, reset1) {
 TEST_F(BitSetTest, reset2) {
     for (int pos = 64; pos <= 127; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), 2);
         bitset.reset(pos);
@@ -109,7 +123,7 @@ TEST_F(BitSetTest, reset2) {
 TEST_F(BitSetTest, reset3) {
     for (int pos = 0; pos <= 1023; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), pos / 64 + 1);
         bitset.reset(pos);
@@ -121,7 +135,7 @@ TEST_F(BitSetTest, reset3) {
 TEST_F(BitSetTest, reset4)  {
     for (int pos = 64; pos <= 127; pos++) {
         BitSet bitset;
-        vector<uint64_t> &blocks = get_blocks(bitset);
+        BlockView blocks = get_blocks(bitset);
         bitset.set(pos);
         EXPECT_EQ(blocks.size(), 2);
         bitset.reset(128);
@@ -133,7 +147,7 @@ TEST_F(BitSetTest, reset4)  {
 //  Set bits 0-127 and reset 0-63.
 TEST_F(BitSetTest, reset5) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
     for (int pos = 0; pos <= 127; pos++) {
         bitset.set(pos);
     }
@@ -150,7 +164,7 @@ TEST_F(BitSetTest, reset5) {
 //  Set bits 0-127 and reset 64-127.
 TEST_F(BitSetTest, reset6) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
     for (int pos = 0; pos <= 127; pos++) {
         bitset.set(pos);
     }
@@ -169,7 +183,7 @@ TEST_F(BitSetTest, reset6) {
 // Clear an empty BitSet.
 TEST_F(BitSetTest, clear1) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
     bitset.clear();
     EXPECT_EQ(blocks.size(), 0);
 }
@@ -178,7 +192,7 @@ TEST_F(BitSetTest, clear1) {
 // Clear BitSet with first/last bit set in each idx.
 TEST_F(BitSetTest, clear2) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
 
     for (int idx = 0; idx < 32; idx++) {
         bitset.set(idx * 64);
@@ -198,7 +212,7 @@ TEST_F(BitSetTest, clear2) {
 // Clear BitSet with all bits set in idx 0 thru 15.
 TEST_F(BitSetTest, clear3) {
     BitSet bitset;
-    vector<uint64_t> &blocks = get_blocks(bitset);
+    BlockView blocks = get_blocks(bitset);
     for (int pos = 0; pos < 64 * 16 ; pos++) {
         bitset.set(pos);
     }
@@ -1836,6 +1850,91 @@ TEST_F(BitSetTest, String2) {
     }
 }
 
+// Grow a bitset past the inline blocks, shrink it back and verify copies
+// and assignments in both directions.
+TEST_F(BitSetTest, InlineToHeap) {
+    BitSet bitset;
+    bitset.set(5);
+    BitSet small(bitset);
+
+    bitset.set(1000);
+    BlockView blocks = get_blocks(bitset);
+    EXPECT_EQ(16, blocks.size());
+    EXPECT_EQ(1LL << 5, blocks[0]);
+    EXPECT_EQ(1LL << (1000 - 960), blocks[15]);
+
+    BitSet large(bitset);
+    EXPECT_EQ(bitset, large);
+    EXPECT_TRUE(large.Contains(small));
+    EXPECT_FALSE(small.Contains(large));
+    EXPECT_TRUE(large.intersects(small));
+
+    bitset.reset(1000);
+    EXPECT_EQ(1, blocks.size());
+    EXPECT_EQ(small, bitset);
+    EXPECT_EQ(5, bitset.find_first());
+    EXPECT_EQ(BitSet::npos, bitset.find_next(5));
+
+    large = small;
+    EXPECT_EQ(small, large);
+    EXPECT_EQ(1, get_blocks(large).size());
+    small = bitset;
+    small.set(1000);
+    EXPECT_EQ(16, get_blocks(small).size());
+    EXPECT_EQ(2, small.count());
+
+    BitSet result;
+    result.BuildComplement(small, bitset);
+    EXPECT_EQ(1000, result.find_first());
+    result.BuildIntersection(small, bitset);
+    EXPECT_EQ(bitset, result);
+}
+
+// Time the operations used per route when exporting and sending updates,
+// for typical numbers of peers.
+TEST_F(BitSetTest, Throughput) {
+    static const int kIterations = 100000;
+    size_t peer_counts[] = { 16, 64, 256, 1024 };
+
+    for (size_t i = 0; i < sizeof(peer_counts) / sizeof(peer_counts[0]); i++) {
+        size_t peer_count = peer_counts[i];
+        BitSet members, ready;
+        for (size_t pos = 0; pos < peer_count; pos++) {
+            members.set(pos);
+            if (pos % 3 != 0)
+                ready.set(pos);
+        }
+
+        size_t total = 0;
+        uint64_t start = UTCTimestampUsec();
+        for (int iter = 0; iter < kIterations; iter++) {
+            BitSet notready;
+            notready.BuildComplement(members, ready);
+            BitSet msgset;
+            msgset.BuildIntersection(members, ready);
+            if (members.Contains(msgset) && notready.intersects(members))
+                total += msgset.count();
+        }
+        uint64_t bulk_usec = UTCTimestampUsec() - start;
+
+        size_t visited = 0;
+        start = UTCTimestampUsec();
+        for (int iter = 0; iter < kIterations / 10; iter++) {
+            for (size_t pos = ready.find_first(); pos != BitSet::npos;
+                 pos = ready.find_next(pos)) {
+                visited++;
+            }
+        }
+        uint64_t iterate_usec = UTCTimestampUsec() - start;
+
+        EXPECT_EQ(kIterations * ready.count(), total);
+        EXPECT_EQ(kIterations / 10 * ready.count(), visited);
+        LOG(DEBUG, peer_count << " peers: " << kIterations
+            << " complement/intersection/contains " << bulk_usec << " usec, "
+            << kIterations / 10 << " iterations " << iterate_usec << " usec");
+    }
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
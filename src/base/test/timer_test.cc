@@ -4,10 +4,12 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include "tbb/atomic.h"
 #include "io/test/event_manager_test.h"
 #include "base/test/task_test_util.h"
 #include "base/logging.h"
+#include "base/util.h"
 #include "base/timer.h"
 #include "testing/gunit.h"
 
@@ -51,6 +53,9 @@ public:
     }
 
     virtual void SetUp() {
+        wheel_.reset(new TimerWheel(*evm_->io_service()));
+        // 1 msec ticks and 16 slots, so that timers wrap around the wheel
+        small_wheel_.reset(new TimerWheel(*evm_->io_service(), 1, 16));
         thread_.reset(new ServerThread(evm_.get()));
         thread_->Start();		// Must be called after initialization
         timer_count_ = 0;
@@ -63,10 +68,14 @@ public:
             thread_->Join();
         }
         task_util::WaitForIdle();
+        wheel_.reset();
+        small_wheel_.reset();
     }
 
     auto_ptr<ServerThread> thread_;
     auto_ptr<EventManager> evm_;
+    auto_ptr<TimerWheel> wheel_;
+    auto_ptr<TimerWheel> small_wheel_;
 };
 
 bool TimerCb() {
@@ -230,6 +239,103 @@ TEST_F(TimerUT, destroy_fired_1) {
     EXPECT_TRUE(TimerManager::DeleteTimer(timer1));
 }
 
+TEST_F(TimerUT, wheel_basic_1) {
+    vector<Timer *> timers;
+    for (int i = 0; i < 5; i++) {
+        timers.push_back(TimerManager::CreateTimer(wheel_.get(), "Wheel"));
+        timers.back()->Start(100, TimerCb);
+    }
+    EXPECT_EQ(5U, wheel_->size());
+    ValidateTimerCount(5, 100);
+    task_util::WaitForIdle();
+    EXPECT_EQ(0U, wheel_->size());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(TimerManager::DeleteTimer(timers[i]));
+    }
+}
+
+TEST_F(TimerUT, wheel_periodic_1) {
+    Timer *timer1 = TimerManager::CreateTimer(wheel_.get(), "Wheel-1");
+
+    timer_count_ = 10;
+    timer1->Start(10, PeriodicTimerCb);
+    ValidateTimerCount(0, 100);
+
+    task_util::WaitForIdle();
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer1));
+}
+
+TEST_F(TimerUT, wheel_cancel_running_1) {
+    Timer *timer1 = TimerManager::CreateTimer(wheel_.get(), "Wheel-1");
+    timer1->Start(10, TimerCb);
+    EXPECT_TRUE(timer1->Cancel());
+    EXPECT_EQ(0U, wheel_->size());
+    ValidateTimerCount(0, 100);
+
+    timer1->Start(10, TimerCb);
+    ValidateTimerCount(1, 10);
+    task_util::WaitForIdle();
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer1));
+}
+
+// Timers more than one revolution of the wheel away
+TEST_F(TimerUT, wheel_rounds_1) {
+    Timer *timer1 = TimerManager::CreateTimer(small_wheel_.get(), "Wheel-1");
+    Timer *timer2 = TimerManager::CreateTimer(small_wheel_.get(), "Wheel-2");
+    uint64_t start = UTCTimestampUsec();
+    timer1->Start(50, TimerCb);
+    timer2->Start(100, TimerCb);
+    TASK_UTIL_EXPECT_EQ(1, timer_count_);
+    EXPECT_GE(UTCTimestampUsec() - start, 50000U);
+    TASK_UTIL_EXPECT_EQ(2, timer_count_);
+    EXPECT_GE(UTCTimestampUsec() - start, 100000U);
+    task_util::WaitForIdle();
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer1));
+    EXPECT_TRUE(TimerManager::DeleteTimer(timer2));
+    TASK_UTIL_EXPECT_EQ(0U, small_wheel_->size());
+}
+
+// Restart a large number of timers, as done for keepalive timers, with the
+// ASIO and the TimerWheel backends
+TEST_F(TimerUT, wheel_restart_scale) {
+    static const int kTimerCount = 100000;
+    static const int kRestartCount = 4;
+
+    for (int backend = 0; backend < 2; backend++) {
+        vector<Timer *> timers;
+        for (int i = 0; i < kTimerCount; i++) {
+            if (backend == 0) {
+                timers.push_back(
+                    TimerManager::CreateTimer(*evm_->io_service(), "Asio"));
+            } else {
+                timers.push_back(
+                    TimerManager::CreateTimer(wheel_.get(), "Wheel"));
+            }
+        }
+
+        uint64_t start = UTCTimestampUsec();
+        for (int round = 0; round < kRestartCount; round++) {
+            for (int i = 0; i < kTimerCount; i++) {
+                timers[i]->Cancel();
+                timers[i]->Start(60000 + i % 1000, TimerCb);
+            }
+        }
+        uint64_t usec = UTCTimestampUsec() - start;
+        if (backend == 1) {
+            EXPECT_EQ(kTimerCount, (int) wheel_->size());
+        }
+        LOG(DEBUG, (backend == 0 ? "Asio" : "TimerWheel") << ": "
+            << kRestartCount * kTimerCount << " restarts of " << kTimerCount
+            << " timers in " << usec << " usec");
+
+        for (int i = 0; i < kTimerCount; i++) {
+            EXPECT_TRUE(TimerManager::DeleteTimer(timers[i]));
+        }
+    }
+    EXPECT_EQ(0U, wheel_->size());
+    EXPECT_EQ(0, timer_count_);
+}
+
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
     scheduler = TaskScheduler::GetInstance();
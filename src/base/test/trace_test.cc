@@ -2,8 +2,13 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <vector>
+#include <tbb/tbb_thread.h>
+
 #include "testing/gunit.h"
+#include "base/logging.h"
 #include "base/trace.h"
+#include "base/util.h"
 
 namespace {
 
@@ -27,6 +32,145 @@ TEST_F(TraceTest, DISABLED_1MillionTraceWrite) {
         trace_buf->TraceWrite(ni);
     }
 }
+struct TraceValue {
+    explicit TraceValue(int value) : value(value) { }
+    int value;
+};
+
+typedef TraceBuffer<TraceValue> TraceValueBuffer;
+
+struct TraceValueCollector {
+    TraceValueCollector(std::vector<int> *values, std::vector<bool> *more)
+        : values(values), more(more) {
+    }
+    void operator()(TraceValue *entry, bool more_entries) {
+        values->push_back(entry->value);
+        more->push_back(more_entries);
+    }
+    std::vector<int> *values;
+    std::vector<bool> *more;
+};
+
+struct TraceValueWriter {
+    TraceValueWriter(TraceValueBuffer *trace_buf, int id, int count)
+        : trace_buf(trace_buf), id(id), count(count) {
+    }
+    void operator()() {
+        for (int i = 0; i < count; i++) {
+            trace_buf->TraceWrite(new TraceValue(id * count + i));
+        }
+    }
+    TraceValueBuffer *trace_buf;
+    int id;
+    int count;
+};
+
+// Read in a context in batches of count, as done by the trace introspect
+static std::vector<int> TraceValueRead(TraceValueBuffer *trace_buf,
+                                       const std::string &context,
+                                       int count, std::vector<bool> *more) {
+    std::vector<int> values;
+    trace_buf->TraceRead(context, count, TraceValueCollector(&values, more));
+    return values;
+}
+
+// Writing from a single thread gives the same results in both modes
+TEST_F(TraceTest, PerThreadRead) {
+    TraceValueBuffer trace_buf("TraceBuf", 5, true);
+    TraceValueBuffer per_thread_buf("PerThreadTraceBuf", 5, true, true);
+    EXPECT_TRUE(per_thread_buf.IsPerThread());
+
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(trace_buf.TraceWrite(new TraceValue(i)),
+                  per_thread_buf.TraceWrite(new TraceValue(i)));
+    }
+
+    std::vector<bool> more, per_thread_more;
+    std::vector<int> values = TraceValueRead(&trace_buf, "c1", 2, &more);
+    EXPECT_EQ(2U, values.size());
+    EXPECT_EQ(values,
+              TraceValueRead(&per_thread_buf, "c1", 2, &per_thread_more));
+    EXPECT_EQ(more, per_thread_more);
+
+    more.clear();
+    per_thread_more.clear();
+    values = TraceValueRead(&trace_buf, "c1", 0, &more);
+    EXPECT_EQ(3U, values.size());
+    EXPECT_EQ(7, values.back());
+    EXPECT_EQ(values,
+              TraceValueRead(&per_thread_buf, "c1", 0, &per_thread_more));
+    EXPECT_EQ(more, per_thread_more);
+
+    per_thread_buf.TraceReadDone("c1");
+    per_thread_more.clear();
+    values = TraceValueRead(&per_thread_buf, "c1", 0, &per_thread_more);
+    ASSERT_EQ(5U, values.size());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(i + 3, values[i]);
+    }
+    EXPECT_FALSE(per_thread_more.back());
+}
+
+// Concurrent writers and a reader. Each read returns at most the buffer size
+// entries, with the entries of each writer in order
+TEST_F(TraceTest, PerThreadConcurrentWrite) {
+    static const int kThreadCount = 4;
+    static const int kWriteCount = 100000;
+    static const size_t kBufSize = 1000;
+
+    TraceValueBuffer trace_buf("PerThreadTraceBuf", kBufSize, true, true);
+    std::vector<tbb::tbb_thread *> threads;
+    for (int id = 0; id < kThreadCount; id++) {
+        threads.push_back(new tbb::tbb_thread(
+            TraceValueWriter(&trace_buf, id, kWriteCount)));
+    }
+
+    for (int read = 0; read < 100; read++) {
+        std::vector<bool> more;
+        std::vector<int> values =
+            TraceValueRead(&trace_buf, "c1", 0, &more);
+        EXPECT_LE(values.size(), kBufSize);
+        trace_buf.TraceReadDone("c1");
+    }
+
+    for (int id = 0; id < kThreadCount; id++) {
+        threads[id]->join();
+        delete threads[id];
+    }
+
+    std::vector<bool> more;
+    std::vector<int> values = TraceValueRead(&trace_buf, "c1", 0, &more);
+    EXPECT_EQ(kBufSize, values.size());
+    std::vector<int> last(kThreadCount, -1);
+    for (size_t i = 0; i < values.size(); i++) {
+        int id = values[i] / kWriteCount;
+        EXPECT_LT(last[id], values[i]);
+        last[id] = values[i];
+    }
+}
+
+TEST_F(TraceTest, PerThreadWriteThroughput) {
+    static const int kThreadCount = 4;
+    static const int kWriteCount = 250000;
+
+    for (int per_thread = 0; per_thread < 2; per_thread++) {
+        TraceValueBuffer trace_buf("TraceBuf", 10000, true, per_thread);
+        std::vector<tbb::tbb_thread *> threads;
+        uint64_t start = UTCTimestampUsec();
+        for (int id = 0; id < kThreadCount; id++) {
+            threads.push_back(new tbb::tbb_thread(
+                TraceValueWriter(&trace_buf, id, kWriteCount)));
+        }
+        for (int id = 0; id < kThreadCount; id++) {
+            threads[id]->join();
+            delete threads[id];
+        }
+        uint64_t usec = UTCTimestampUsec() - start;
+        LOG(DEBUG, (per_thread ? "Per-thread" : "Locked") << " trace buffer: "
+            << kThreadCount * kWriteCount << " writes from " << kThreadCount
+            << " threads in " << usec << " usec");
+    }
+}
 } // namespace
 
 template<> Trace<TraceStruct>
@@ -34,5 +178,6 @@ template<> Trace<TraceStruct>
 
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
     return RUN_ALL_TESTS();
 }
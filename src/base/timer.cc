@@ -71,7 +71,19 @@ Timer::Timer(boost::asio::io_service &service, const std::string &name,
           int task_id, int task_instance)
     : boost::asio::deadline_timer(service), name_(name), handler_(NULL),
     error_handler_(NULL), state_(Init), timer_task_(NULL), time_(0),
-    task_id_(task_id), task_instance_(task_instance) {
+    task_id_(task_id), task_instance_(task_instance), wheel_(NULL),
+    wheel_generation_(0), wheel_slot_(0), wheel_rounds_(0),
+    wheel_entry_generation_(0) {
+    refcount_ = 0;
+}
+
+Timer::Timer(TimerWheel *wheel, const std::string &name, int task_id,
+          int task_instance)
+    : boost::asio::deadline_timer(wheel->io_service()), name_(name),
+    handler_(NULL), error_handler_(NULL), state_(Init), timer_task_(NULL),
+    time_(0), task_id_(task_id), task_instance_(task_instance), wheel_(wheel),
+    wheel_generation_(0), wheel_slot_(0), wheel_rounds_(0),
+    wheel_entry_generation_(0) {
     refcount_ = 0;
 }
 
@@ -98,6 +110,13 @@ bool Timer::Start(int time, Handler handler, ErrorHandler error_handler) {
     // Restart the timer
     handler_ = handler;
     error_handler_ = error_handler;
+    if (wheel_) {
+        time_ = time;
+        wheel_->Add(this, time, ++wheel_generation_);
+        SetState(Running);
+        return true;
+    }
+
     boost::system::error_code ec;
     expires_from_now(boost::posix_time::milliseconds(time), ec);
     if (ec) {
@@ -128,6 +147,10 @@ bool Timer::Cancel() {
         timer_task_ = NULL;
     }
 
+    if (wheel_) {
+        wheel_->Remove(this);
+    }
+
     SetState(Cancelled);
     return true;
 }
@@ -153,6 +176,165 @@ void Timer::StartTimerTask(boost::asio::deadline_timer* t, TimerPtr timer,
     TaskScheduler::GetInstance()->Enqueue(timer->timer_task_);
 }
 
+// TimerWheel callback on timer expiry. Start a task to serve the timer
+void Timer::StartWheelTimerTask(TimerPtr timer, uint64_t generation) {
+    tbb::mutex::scoped_lock lock(timer->mutex_);
+
+    // Timer was cancelled, or cancelled and started again, after it expired
+    if (timer->state_ != Running || timer->wheel_generation_ != generation) {
+        return;
+    }
+
+    // Start a task and add Task reference.
+    assert(timer->timer_task_ == NULL);
+    timer->timer_task_ = new TimerTask(timer, boost::system::error_code());
+    TaskScheduler::GetInstance()->Enqueue(timer->timer_task_);
+}
+
+//
+// TimerWheel class routines
+//
+TimerWheel::TimerWheel(boost::asio::io_service &service, int tick_msec,
+                       size_t slot_count)
+    : service_(&service), timer_(service), tick_msec_(tick_msec),
+      slot_count_(slot_count), slots_(new TimerList[slot_count]),
+      current_tick_(0), count_(0), running_(false) {
+}
+
+TimerWheel::~TimerWheel() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (size_t slot = 0; slot < slot_count_; slot++) {
+        while (!slots_[slot].empty()) {
+            Timer *timer = &slots_[slot].front();
+            slots_[slot].pop_front();
+            intrusive_ptr_release(timer);
+        }
+    }
+    count_ = 0;
+    boost::system::error_code ec;
+    timer_.cancel(ec);
+}
+
+size_t TimerWheel::size() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return count_;
+}
+
+//
+// Add a timer to the slot of the first tick at or after the expiry time.
+// The wheel gets anchored at the current time if it was idle.
+//
+// Called with the timer's mutex held.
+//
+void TimerWheel::Add(Timer *timer, int time, uint64_t generation) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    assert(!timer->wheel_node_.is_linked());
+
+    boost::posix_time::ptime now =
+        boost::asio::deadline_timer::traits_type::now();
+    if (!running_) {
+        base_time_ = now;
+        current_tick_ = 0;
+    }
+
+    uint64_t tick_usec = tick_msec_ * 1000;
+    uint64_t expiry_usec =
+        (now - base_time_).total_microseconds() + time * 1000ULL;
+    uint64_t expiry_tick = (expiry_usec + tick_usec - 1) / tick_usec;
+    if (expiry_tick <= current_tick_) {
+        expiry_tick = current_tick_ + 1;
+    }
+
+    timer->wheel_slot_ = expiry_tick % slot_count_;
+    timer->wheel_rounds_ = (expiry_tick - current_tick_ - 1) / slot_count_;
+    timer->wheel_entry_generation_ = generation;
+    slots_[timer->wheel_slot_].push_back(*timer);
+    intrusive_ptr_add_ref(timer);
+    count_++;
+
+    if (!running_) {
+        running_ = true;
+        ScheduleTick();
+    }
+}
+
+//
+// Remove a timer from the wheel, if it's still there. It's not there if it
+// has already expired.
+//
+// Called with the timer's mutex held. The caller holds a reference to the
+// timer, so releasing the wheel's reference does not delete it.
+//
+void TimerWheel::Remove(Timer *timer) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (!timer->wheel_node_.is_linked()) {
+        return;
+    }
+
+    TimerList &slot = slots_[timer->wheel_slot_];
+    slot.erase(slot.iterator_to(*timer));
+    count_--;
+    intrusive_ptr_release(timer);
+}
+
+// Arm the ASIO timer for the next tick. Called with mutex_ held.
+void TimerWheel::ScheduleTick() {
+    boost::system::error_code ec;
+    timer_.expires_at(base_time_ +
+        boost::posix_time::milliseconds(tick_msec_ * (current_tick_ + 1)), ec);
+    timer_.async_wait(boost::bind(&TimerWheel::ProcessTick, this,
+                                  boost::asio::placeholders::error));
+}
+
+//
+// ASIO callback on tick expiry. Advance the wheel to the current time and
+// collect the expired timers. Tasks are started for them after releasing
+// mutex_, since the timer's mutex is taken before mutex_ elsewhere.
+//
+void TimerWheel::ProcessTick(const boost::system::error_code &ec) {
+    if (ec && ec.value() == boost::asio::error::operation_aborted) {
+        return;
+    }
+
+    ExpiryList expired;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        boost::posix_time::ptime now =
+            boost::asio::deadline_timer::traits_type::now();
+        uint64_t tick_usec = tick_msec_ * 1000;
+        uint64_t tick = (now - base_time_).total_microseconds() / tick_usec;
+
+        while (current_tick_ < tick) {
+            current_tick_++;
+            TimerList &slot = slots_[current_tick_ % slot_count_];
+            for (TimerList::iterator it = slot.begin(); it != slot.end(); ) {
+                Timer *timer = &*it;
+                if (timer->wheel_rounds_ > 0) {
+                    timer->wheel_rounds_--;
+                    ++it;
+                    continue;
+                }
+                it = slot.erase(it);
+                count_--;
+                expired.push_back(std::make_pair(Timer::TimerPtr(timer),
+                    timer->wheel_entry_generation_));
+                intrusive_ptr_release(timer);
+            }
+        }
+
+        if (count_ == 0) {
+            running_ = false;
+        } else {
+            ScheduleTick();
+        }
+    }
+
+    for (ExpiryList::iterator it = expired.begin(); it != expired.end();
+         ++it) {
+        Timer::StartWheelTimerTask(it->first, it->second);
+    }
+}
+
 //
 // TimerManager class routines
 //
@@ -167,6 +349,14 @@ Timer *TimerManager::CreateTimer(
     return timer;
 }
 
+Timer *TimerManager::CreateTimer(
+            TimerWheel *wheel, const std::string &name,
+            int task_id, int task_instance) {
+    Timer *timer = new Timer(wheel, name, task_id, task_instance);
+    AddTimer(timer);
+    return timer;
+}
+
 void TimerManager::AddTimer(Timer *timer) {
     tbb::mutex::scoped_lock lock(mutex_);
     timer_ref_.insert(TimerPtr(timer));
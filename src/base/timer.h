@@ -24,6 +24,12 @@
 //    Cancels the timer and triggers deletion of the timer. Application should
 //    not access the timer after its deleted
 //
+//  Backends
+//  - By default, each timer registers its own ASIO timer when started
+//  - A timer created with a TimerWheel is instead kept in the wheel, which
+//    drives all its timers from a single ASIO timer. Use this for large
+//    numbers of timers that get restarted often, e.g. protocol keepalives
+//
 //  Concurrency aspects:
 //  - Timer is allocated by application
 //  - Applications must call TimerManager::DeleteTimer() to delete the timer
@@ -43,11 +49,16 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/asio.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/system/error_code.hpp>
 #include <set>
+#include <vector>
 
 #include <base/task.h>
 
+class TimerWheel;
+
 class Timer : public boost::asio::deadline_timer {
 private:
 	// Task used to fire the timer
@@ -60,6 +71,8 @@ public:
 
     Timer(boost::asio::io_service &service, const std::string &name,
           int task_id, int task_instance);
+    Timer(TimerWheel *wheel, const std::string &name, int task_id,
+          int task_instance);
     virtual ~Timer();
 
     // Start a timer
@@ -106,6 +119,7 @@ public:
 private:
     friend class TimerManager;
     friend class TimerTest;
+    friend class TimerWheel;
 
     friend void intrusive_ptr_add_ref(Timer *timer);
     friend void intrusive_ptr_release(Timer *timer);
@@ -122,6 +136,10 @@ private:
     static void StartTimerTask(boost::asio::deadline_timer* t, TimerPtr t_ptr,
                                int time, const boost::system::error_code &ec);
 
+    // TimerWheel callback on timer expiry. Start a task to serve the timer,
+    // unless the timer was restarted since it was added to the wheel
+    static void StartWheelTimerTask(TimerPtr timer, uint64_t generation);
+
     void SetState(TimerState s) { state_ = s; }
     static int GetTimerInstanceId() { return -1; }
     static int GetTimerTaskId() {
@@ -144,6 +162,15 @@ private:
     int task_id_;
     int task_instance_;
     tbb::atomic<int> refcount_;
+
+    // TimerWheel state. The generation is bumped on every start under mutex_
+    // and the other fields are protected by the wheel's mutex
+    TimerWheel *wheel_;
+    uint64_t wheel_generation_;
+    boost::intrusive::list_member_hook<> wheel_node_;
+    size_t wheel_slot_;
+    uint64_t wheel_rounds_;
+    uint64_t wheel_entry_generation_;
 };
 
 inline void intrusive_ptr_add_ref(Timer *timer) {
@@ -157,6 +184,62 @@ inline void intrusive_ptr_release(Timer *timer) {
     }
 }
 
+//
+// TimerWheel is a hashed timing wheel that serves as an alternate backend
+// for large numbers of Timers.
+//
+// Running Timers are kept in an array of intrusive lists, indexed by their
+// expiry tick modulo the number of slots, so starting and cancelling a Timer
+// is O(1). Timers more than one revolution away carry a count of rounds.
+// A single ASIO timer drives the wheel and is only armed while there are
+// running Timers. Expired Timers are served by a TimerTask like any other
+// Timer. Timers never expire early, and at most one tick late.
+//
+// The wheel holds a reference to each Timer in it. It must not be destroyed
+// before the io_service has stopped running.
+//
+class TimerWheel {
+public:
+    static const int kDefaultTickMsec = 10;
+    static const size_t kDefaultSlotCount = 1024;
+
+    TimerWheel(boost::asio::io_service &service,
+               int tick_msec = kDefaultTickMsec,
+               size_t slot_count = kDefaultSlotCount);
+    ~TimerWheel();
+
+    boost::asio::io_service &io_service() { return *service_; }
+
+    // Number of running Timers in the wheel
+    size_t size() const;
+
+private:
+    friend class Timer;
+
+    typedef boost::intrusive::member_hook<Timer,
+        boost::intrusive::list_member_hook<>, &Timer::wheel_node_> TimerNode;
+    typedef boost::intrusive::list<Timer, TimerNode> TimerList;
+    typedef std::vector<std::pair<Timer::TimerPtr, uint64_t> > ExpiryList;
+
+    void Add(Timer *timer, int time, uint64_t generation);
+    void Remove(Timer *timer);
+    void ScheduleTick();
+    void ProcessTick(const boost::system::error_code &ec);
+
+    boost::asio::io_service *service_;
+    boost::asio::deadline_timer timer_;
+    int tick_msec_;
+    size_t slot_count_;
+    boost::scoped_array<TimerList> slots_;
+    mutable tbb::mutex mutex_;
+    boost::posix_time::ptime base_time_;
+    uint64_t current_tick_;
+    size_t count_;
+    bool running_;
+
+    DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
 //
 // TimerManager is the place holder for all the Timer objects
 // instantiated in the life time of a process
@@ -175,6 +258,9 @@ public:
                               const std::string &name,
                               int task_id = Timer::GetTimerTaskId(),
                               int task_instance = Timer::GetTimerInstanceId());
+    static Timer *CreateTimer(TimerWheel *wheel, const std::string &name,
+                              int task_id = Timer::GetTimerTaskId(),
+                              int task_instance = Timer::GetTimerInstanceId());
     static bool DeleteTimer(Timer *Timer);
 
 private:
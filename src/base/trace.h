@@ -5,33 +5,57 @@
 #ifndef __TRACE_H__
 #define __TRACE_H__
 
+#include <tbb/atomic.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/mutex.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <stdexcept>
 #include <boost/function.hpp>
 #include <boost/ptr_container/ptr_circular_buffer.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include "base/util.h"
 
+//
+// A TraceBuffer keeps the last size trace entries written to it. It takes
+// ownership of the entries.
+//
+// In the default mode the entries are kept in a single circular buffer
+// protected by a mutex. In the per-thread mode, each writing thread gets its
+// own ring of size preallocated slots, which it writes without taking any
+// lock. Readers swap the slots out, merge the entries of all rings by
+// sequence number and keep the last size of them, so TraceRead returns the
+// same entries in both modes. A slot overwritten while swapped out is caught
+// when the reader swaps it back, and the reader then frees the old entry.
+//
 template<typename TraceEntryT>
 class TraceBuffer {
 public:
-    TraceBuffer(const std::string& buf_name, size_t size, bool trace_enable) 
+    TraceBuffer(const std::string& buf_name, size_t size, bool trace_enable,
+                bool per_thread = false)
         : trace_buf_name_(buf_name), 
           trace_buf_size_(size),
-          trace_buf_(trace_buf_size_),
+          trace_buf_(per_thread ? 0 : trace_buf_size_),
           write_index_(0),
           read_index_(0),
           wrap_(false),
-          seqno_(0) {
+          seqno_(0),
+          per_thread_(per_thread),
+          local_ring_(static_cast<TraceRing *>(NULL)) {
         trace_enable_ = trace_enable;
+        write_seqno_ = 0;
     }
 
     ~TraceBuffer() {
         read_context_map_.clear();
         trace_buf_.clear();
+        for (typename std::vector<TraceRing *>::iterator it = rings_.begin();
+             it != rings_.end(); ++it) {
+            delete *it;
+        }
     }
 
     std::string Name() {
@@ -54,7 +78,15 @@ public:
         return trace_buf_size_; 
     }
 
+    bool IsPerThread() {
+        return per_thread_;
+    }
+
     uint32_t TraceWrite(TraceEntryT *trace_entry) {
+        if (per_thread_) {
+            return TraceWritePerThread(trace_entry);
+        }
+
         tbb::mutex::scoped_lock lock(mutex_);
        
         // Add the trace
@@ -101,6 +133,11 @@ public:
 
     void TraceRead(const std::string& context, const int count, 
             boost::function<void (TraceEntryT *, bool)> cb) {
+        if (per_thread_) {
+            TraceReadPerThread(context, count, cb);
+            return;
+        }
+
         tbb::mutex::scoped_lock lock(mutex_);
         if (trace_buf_.empty()) {
             // No message in the trace buffer
@@ -149,12 +186,175 @@ public:
         if (context_it != read_context_map_.end()) {
             read_context_map_.erase(context_it);
         }
+        read_seqno_map_.erase(context);
     }
 
 private:
     typedef boost::ptr_circular_buffer<TraceEntryT> ContainerType;
     typedef std::map<const std::string, boost::shared_ptr<int> > 
         ReadContextMap;
+    typedef std::map<const std::string, uint64_t> ReadSeqnoMap;
+
+    // A trace entry and its sequence number in a per-thread ring
+    struct TraceSlot {
+        TraceSlot() : entry(NULL), seqno(0) {
+        }
+        TraceEntryT *entry;
+        uint64_t seqno;
+    };
+
+    // Slots of one writing thread. A reader swaps a slot out with NULL while
+    // it reads the entry. The writer then uses spare or free slots, or
+    // allocates one if there are none.
+    struct TraceRing {
+        explicit TraceRing(size_t size)
+            : slots(new tbb::atomic<TraceSlot *>[size]),
+              size(size),
+              index(0),
+              spare(NULL) {
+            for (size_t i = 0; i < size; i++) {
+                slots[i] = new TraceSlot;
+            }
+            free = NULL;
+        }
+        ~TraceRing() {
+            for (size_t i = 0; i < size; i++) {
+                FreeSlot(slots[i]);
+            }
+            FreeSlot(spare);
+            FreeSlot(free);
+        }
+        static void FreeSlot(TraceSlot *slot) {
+            if (slot) {
+                delete slot->entry;
+                delete slot;
+            }
+        }
+
+        boost::scoped_array<tbb::atomic<TraceSlot *> > slots;
+        size_t size;
+        size_t index;                   // only used by the writer
+        TraceSlot *spare;               // only used by the writer
+        tbb::atomic<TraceSlot *> free;  // returned by readers
+    };
+
+    // A slot swapped out by a reader
+    struct TraceReadSlot {
+        TraceReadSlot(TraceRing *ring, size_t index, TraceSlot *slot)
+            : ring(ring), index(index), slot(slot) {
+        }
+        TraceRing *ring;
+        size_t index;
+        TraceSlot *slot;
+    };
+
+    struct TraceReadSlotCmp {
+        bool operator()(const TraceReadSlot &lhs,
+                        const TraceReadSlot &rhs) const {
+            return lhs.slot->seqno < rhs.slot->seqno;
+        }
+    };
+
+    TraceRing *LocateRing() {
+        TraceRing *&ring = local_ring_.local();
+        if (ring == NULL) {
+            ring = new TraceRing(trace_buf_size_);
+            tbb::mutex::scoped_lock lock(mutex_);
+            rings_.push_back(ring);
+        }
+        return ring;
+    }
+
+    uint32_t TraceWritePerThread(TraceEntryT *trace_entry) {
+        uint64_t seqno = write_seqno_.fetch_and_increment() + 1;
+        TraceRing *ring = LocateRing();
+
+        TraceSlot *slot = ring->spare;
+        ring->spare = NULL;
+        if (slot == NULL) {
+            slot = ring->free.fetch_and_store(NULL);
+            if (slot == NULL) {
+                slot = new TraceSlot;
+            }
+        }
+        slot->entry = trace_entry;
+        slot->seqno = seqno;
+
+        // The old slot is NULL if a reader has swapped it out
+        TraceSlot *old_slot = ring->slots[ring->index].fetch_and_store(slot);
+        if (++ring->index == ring->size) {
+            ring->index = 0;
+        }
+        if (old_slot) {
+            delete old_slot->entry;
+            old_slot->entry = NULL;
+            ring->spare = old_slot;
+        }
+
+        // Same sequence numbers as the default mode
+        return (seqno - 1) % kMaxSeqno + kMinSeqno;
+    }
+
+    void TraceReadPerThread(const std::string& context, const int count,
+            boost::function<void (TraceEntryT *, bool)> cb) {
+        tbb::mutex::scoped_lock lock(mutex_);
+
+        // Swap out all slots, and keep the newest trace_buf_size_ entries
+        std::vector<TraceReadSlot> read_slots;
+        std::vector<TraceReadSlot> entries;
+        for (typename std::vector<TraceRing *>::iterator it = rings_.begin();
+             it != rings_.end(); ++it) {
+            TraceRing *ring = *it;
+            for (size_t i = 0; i < ring->size; i++) {
+                TraceSlot *slot = ring->slots[i].fetch_and_store(NULL);
+                read_slots.push_back(TraceReadSlot(ring, i, slot));
+                if (slot && slot->entry) {
+                    entries.push_back(read_slots.back());
+                }
+            }
+        }
+        std::sort(entries.begin(), entries.end(), TraceReadSlotCmp());
+        size_t first = 0;
+        if (entries.size() > (size_t) trace_buf_size_) {
+            first = entries.size() - trace_buf_size_;
+        }
+
+        if (first < entries.size()) {
+            // Start after the last entry read in this context
+            typename ReadSeqnoMap::iterator context_it =
+                read_seqno_map_.find(context);
+            if (context_it == read_seqno_map_.end()) {
+                context_it = read_seqno_map_.insert(
+                    std::make_pair(context, 0)).first;
+            }
+            while (first < entries.size() &&
+                   entries[first].slot->seqno <= context_it->second) {
+                first++;
+            }
+
+            // if count = 0, then read all the entries
+            size_t cnt = count ? count : entries.size();
+            for (size_t i = first; i < entries.size() && i - first < cnt;
+                 i++) {
+                cb(entries[i].slot->entry, i + 1 != entries.size());
+                context_it->second = entries[i].slot->seqno;
+            }
+        }
+
+        // Swap the slots back. If the writer has used a slot in the meantime,
+        // its old entry has been overwritten.
+        for (typename std::vector<TraceReadSlot>::iterator it =
+             read_slots.begin(); it != read_slots.end(); ++it) {
+            if (it->slot == NULL) {
+                continue;
+            }
+            if (it->ring->slots[it->index].compare_and_swap(it->slot, NULL)) {
+                delete it->slot->entry;
+                it->slot->entry = NULL;
+                TraceRing::FreeSlot(it->ring->free.fetch_and_store(it->slot));
+            }
+        }
+    }
 
     std::string trace_buf_name_;
     int trace_buf_size_;
@@ -168,6 +368,13 @@ private:
     ReadContextMap read_context_map_; // stores the read context  
     uint32_t seqno_;
     tbb::mutex mutex_;
+
+    // Per-thread mode. mutex_ is taken by readers and when adding a ring
+    bool per_thread_;
+    tbb::enumerable_thread_specific<TraceRing *> local_ring_;
+    std::vector<TraceRing *> rings_;
+    tbb::atomic<uint64_t> write_seqno_;
+    ReadSeqnoMap read_seqno_map_;
     
     // Reserve 0 and max(uint32_t)
     static const uint32_t kMaxSeqno = ((2 ^ 32) - 1) - 1;
@@ -239,7 +446,7 @@ public:
     }
         
     boost::shared_ptr<TraceBuffer<TraceEntryT> > TraceBufAdd(const std::string& buf_name, size_t size,
-                     bool trace_enable) {
+                     bool trace_enable, bool per_thread = false) {
         // should we have a default size for the buffer?
         if (!size) {
             return boost::shared_ptr<TraceBuffer<TraceEntryT> >();
@@ -248,7 +455,8 @@ public:
         typename TraceBufMap::iterator it = trace_buf_map_.find(buf_name);
         if (it == trace_buf_map_.end()) {
             boost::shared_ptr<TraceBuffer<TraceEntryT> > trace_buf(
-                new TraceBuffer<TraceEntryT>(buf_name, size, trace_enable),
+                new TraceBuffer<TraceEntryT>(buf_name, size, trace_enable,
+                                             per_thread),
                 TraceBufferDeleter<TraceEntryT>(trace_buf_map_, mutex_));
             trace_buf_map_.insert(std::make_pair(buf_name, trace_buf));
             return trace_buf;
@@ -137,7 +137,8 @@ BgpConditionListener::BgpConditionListener(BgpServer *server) :
     server_(server), 
     walk_trigger_(new TaskTrigger(boost::bind(&BgpConditionListener::StartWalk, 
                                               this), 
-                  TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0)) {
+                  TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0)),
+    walk_request_count_(0), walk_count_(0), walk_match_count_(0) {
 }
 
 //
@@ -290,6 +291,7 @@ void BgpConditionListener::TableWalk(BgpTable *table, ConditionMatch *obj,
         walk_map_.insert(std::make_pair(table, walk_req));
         walk_req->AddMatchObject(obj, cb);
     }
+    walk_request_count_++;
     walk_trigger_->Set();
 }
 
@@ -299,19 +301,26 @@ bool BgpConditionListener::StartWalk() {
     DBTableWalker::WalkCompleteFn walk_complete 
         = boost::bind(&BgpConditionListener::WalkDone, this, _1);
 
-    DBTableWalker::WalkFn walker 
-        = boost::bind(&BgpConditionListener::BgpRouteNotify, this, server(),
-                      _1, _2);
-
     for(WalkRequestMap::iterator it = walk_map_.begin(); 
         it != walk_map_.end(); it++) {
-        if (it->second->walk_in_progress()) {
+        WalkRequest *walk_req = it->second;
+        if (walk_req->walk_in_progress()) {
             continue;
         }
+
+        //
+        // The walk runs in the db::DBTable task, so it does not start before
+        // the pending requests are moved to the current walk list.
+        //
+        DBTableWalker::WalkFn walker
+            = boost::bind(&BgpConditionListener::BgpRouteWalk, this,
+                          server(), walk_req, _1, _2);
         DB *db = server()->database();
         DBTableWalker::WalkId id = 
             db->GetWalker()->WalkTable(it->first, NULL, walker, walk_complete);
-        it->second->WalkStarted(id);
+        walk_req->WalkStarted(id);
+        walk_count_++;
+        walk_match_count_ += walk_req->walk_list()->size();
     }
     return true;
 }
@@ -343,6 +352,34 @@ bool BgpConditionListener::BgpRouteNotify(BgpServer *server,
     return true;
 }
 
+//
+// Table walk function
+// Matches the route against the ConditionMatch objects that requested the
+// walk. Other objects of the table have already seen the route, either in
+// an earlier walk or in a notification.
+// The current walk list is not modified while the walk is in progress.
+//
+bool BgpConditionListener::BgpRouteWalk(BgpServer *server,
+                                        WalkRequest *walk_req,
+                                        DBTablePartBase *root,
+                                        DBEntryBase *entry) {
+    BgpTable *bgptable = static_cast<BgpTable *>(root->parent());
+    BgpRoute *rt = static_cast<BgpRoute *> (entry);
+    bool del_rt = rt->IsDeleted();
+
+    for (WalkRequest::WalkList::iterator walk_it =
+         walk_req->walk_list()->begin();
+         walk_it != walk_req->walk_list()->end(); walk_it++) {
+        ConditionMatch *obj = walk_it->first.get();
+        bool deleted = false;
+        if (obj->deleted() || del_rt) {
+            deleted = true;
+        }
+        obj->Match(server, bgptable, rt, deleted);
+    }
+    return true;
+}
+
 // 
 // WalkComplete function
 // At the end of the walk reset the WalkId.
@@ -150,6 +150,13 @@ public:
         return server_;
     }
 
+    // Number of walk requests made on behalf of ConditionMatch objects, of
+    // table walks started, and of walk requests served by those walks. All
+    // requests pending for a table when its walk starts share the walk.
+    uint64_t walk_request_count() const { return walk_request_count_; }
+    uint64_t walk_count() const { return walk_count_; }
+    uint64_t walk_match_count() const { return walk_match_count_; }
+
 private:
     BgpServer *server_;
 
@@ -161,6 +168,10 @@ private:
     bool BgpRouteNotify(BgpServer *server, DBTablePartBase *root,
                         DBEntryBase *entry);
 
+    // Table walk function
+    bool BgpRouteWalk(BgpServer *server, WalkRequest *walk_req,
+                      DBTablePartBase *root, DBEntryBase *entry);
+
     void TableWalk(BgpTable *table, ConditionMatch *obj, RequestDoneCb cb);
 
     bool StartWalk();
@@ -170,6 +181,10 @@ private:
 
     boost::scoped_ptr<TaskTrigger> walk_trigger_;
 
+    uint64_t walk_request_count_;
+    uint64_t walk_count_;
+    uint64_t walk_match_count_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpConditionListener);
 };
 #endif // ctrlplane_bgp_condition_listener_h
@@ -7,6 +7,7 @@
 
 #include "base/logging.h"
 #include "base/task.h"
+#include "base/timer.h"
 #include "base/util.h"
 #include "bgp/bgp_config_listener.h"
 #include "bgp/bgp_factory.h"
@@ -14,6 +15,7 @@
 #include "bgp/bgp_config.h"
 #include "ifmap/ifmap_link.h"
 #include "ifmap/ifmap_table.h"
+#include "io/event_manager.h"
 
 using namespace std;
 
@@ -516,21 +518,36 @@ void BgpConfigData::DeletePeering(BgpPeeringConfig *peer) {
 int BgpConfigManager::config_task_id_ = -1;
 const int BgpConfigManager::kConfigTaskInstanceId;
 
-BgpConfigManager::BgpConfigManager()
+BgpConfigManager::BgpConfigManager(EventManager *evm)
         : db_(NULL), db_graph_(NULL),
           trigger_(boost::bind(&BgpConfigManager::ConfigHandler, this),
                    TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0),
           listener_(BgpObjectFactory::Create<BgpConfigListener>(this)),
-          config_(new BgpConfigData()) {
+          config_(new BgpConfigData()),
+          defer_timer_(NULL),
+          coalesce_changes_(false),
+          change_batch_count_(0),
+          change_delta_count_(0),
+          change_defer_count_(0),
+          last_batch_usec_(0),
+          last_convergence_usec_(0) {
+    pending_since_usec_ = 0;
     IdentifierMapInit();
 
     if (config_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         config_task_id_ = scheduler->GetTaskId("bgp::Config");
     }
+    if (evm != NULL) {
+        defer_timer_ = TimerManager::CreateTimer(*evm->io_service(),
+            "BGP config defer timer", config_task_id_, kConfigTaskInstanceId);
+    }
 }
 
 BgpConfigManager::~BgpConfigManager() {
+    if (defer_timer_ != NULL) {
+        TimerManager::DeleteTimer(defer_timer_);
+    }
 }
 
 void BgpConfigManager::Initialize(DB *db, DBGraph *db_graph,
@@ -543,6 +560,9 @@ void BgpConfigManager::Initialize(DB *db, DBGraph *db_graph,
 }
 
 void BgpConfigManager::OnChange() {
+    if (pending_since_usec_ == 0) {
+        pending_since_usec_.compare_and_swap(UTCTimestampUsec(), 0);
+    }
     trigger_.Set();
 }
 
@@ -741,14 +761,61 @@ void BgpConfigManager::ProcessChanges(const ChangeList &change_list) {
     }
 }
 
+//
+// Returns true if the pending changes should be left for a later run of the
+// config handler, so that updates still queued in the config DB are added
+// to the same batch.
+//
+// Deferral needs the defer timer to run the handler again once the DB tasks
+// have had a chance to drain the queue.
+//
+bool BgpConfigManager::ShouldDeferChanges() {
+    if (!coalesce_changes_ || defer_timer_ == NULL || db_ == NULL ||
+        db_->IsDBQueueEmpty())
+        return false;
+    uint64_t pending_since = pending_since_usec_;
+    if (pending_since == 0)
+        return false;
+    return UTCTimestampUsec() - pending_since <
+        static_cast<uint64_t>(kMaxCoalesceDelayMsec) * 1000;
+}
+
 bool BgpConfigManager::ConfigHandler() {
+    if (ShouldDeferChanges()) {
+        change_defer_count_++;
+        if (!defer_timer_->running()) {
+            defer_timer_->Start(kCoalesceRecheckMsec,
+                boost::bind(&BgpConfigManager::DeferTimerExpired, this));
+        }
+        return true;
+    }
+    if (defer_timer_ != NULL) {
+        defer_timer_->Cancel();
+    }
+
+    uint64_t pending_since = pending_since_usec_.fetch_and_store(0);
+    uint64_t start = UTCTimestampUsec();
     BgpConfigListener::ChangeList change_list;
     listener_->GetChangeList(&change_list);
     ProcessChanges(change_list);
+
+    uint64_t end = UTCTimestampUsec();
+    change_batch_count_++;
+    change_delta_count_ += change_list.size();
+    last_batch_usec_ = end - start;
+    last_convergence_usec_ = end - (pending_since ? pending_since : start);
     return true;
 }
 
+bool BgpConfigManager::DeferTimerExpired() {
+    trigger_.Set();
+    return false;
+}
+
 void BgpConfigManager::Terminate() {
+    if (defer_timer_ != NULL) {
+        defer_timer_->Cancel();
+    }
     listener_->Terminate(db_);
     config_.reset();
 }
@@ -13,6 +13,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/ptr_container/ptr_map.hpp>
+#include <tbb/atomic.h>
 
 #include "base/util.h"
 #include "base/queue_task.h"
@@ -23,6 +24,9 @@
 #include "schema/bgp_schema_types.h"
 #include "schema/vnc_cfg_types.h"
 
+class EventManager;
+class Timer;
+
 class BgpConfigListener;
 class BgpConfigManager;
 class BgpInstanceConfig;
@@ -262,6 +266,8 @@ public:
     static const int kDefaultPort;
     static const int kConfigTaskInstanceId = 0;
     static const as_t kDefaultAutonomousSystem;
+    static const int kMaxCoalesceDelayMsec = 1000;
+    static const int kCoalesceRecheckMsec = 10;
     enum EventType {
         CFG_NONE,
         CFG_ADD,
@@ -282,7 +288,7 @@ public:
         BgpNeighborObserver neighbor;
     };
 
-    BgpConfigManager();
+    explicit BgpConfigManager(EventManager *evm = NULL);
     ~BgpConfigManager();
     void Initialize(DB *db, DBGraph *db_graph, const std::string &localname);
 
@@ -300,6 +306,24 @@ public:
 
     const std::string &localname() const { return localname_; }
 
+    // When set, the config handler waits for the config DB to drain before
+    // processing the pending changes, for at most kMaxCoalesceDelayMsec
+    // since the first of them. The queue is checked again every
+    // kCoalesceRecheckMsec, which needs an EventManager at construction.
+    // A burst of ifmap updates is then applied as one deduplicated batch,
+    // so each routing instance is updated once rather than once per
+    // intermediate state.
+    void set_coalesce_changes(bool coalesce) { coalesce_changes_ = coalesce; }
+    bool coalesce_changes() const { return coalesce_changes_; }
+
+    uint64_t change_batch_count() const { return change_batch_count_; }
+    uint64_t change_delta_count() const { return change_delta_count_; }
+    uint64_t change_defer_count() const { return change_defer_count_; }
+    // Time taken to process the last batch of changes, and the time from
+    // the first change of the batch being seen to the end of processing.
+    uint64_t last_batch_usec() const { return last_batch_usec_; }
+    uint64_t last_convergence_usec() const { return last_convergence_usec_; }
+
     void Terminate();
 
 private:
@@ -320,6 +344,8 @@ private:
     void ProcessBgpPeering(const BgpConfigDelta &change);
 
     bool ConfigHandler();
+    bool ShouldDeferChanges();
+    bool DeferTimerExpired();
     static int config_task_id_;
 
     DB *db_;
@@ -331,6 +357,15 @@ private:
     boost::scoped_ptr<BgpConfigListener> listener_;
     boost::scoped_ptr<BgpConfigData> config_;
 
+    Timer *defer_timer_;
+    bool coalesce_changes_;
+    tbb::atomic<uint64_t> pending_since_usec_;
+    uint64_t change_batch_count_;
+    uint64_t change_delta_count_;
+    uint64_t change_defer_count_;
+    uint64_t last_batch_usec_;
+    uint64_t last_convergence_usec_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpConfigManager);
 };
 
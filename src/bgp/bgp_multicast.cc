@@ -4,6 +4,8 @@
 
 #include "bgp/bgp_multicast.h"
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 
 #include "base/task_annotations.h"
@@ -47,6 +49,7 @@ private:
 McastForwarder::McastForwarder(InetMcastRoute *route)
     : route_(route),
       label_(0),
+      tree_index_(-1),
       rd_(route->GetPrefix().route_distinguisher()) {
     const BgpPath *path = route->BestPath();
     label_block_ = path->GetAttr()->label_block();
@@ -119,8 +122,11 @@ void McastForwarder::FlushLinks() {
 // This is used when updating the distribution tree for the McastSGEntry to
 // this McastForwarder belongs.
 //
-void McastForwarder::AllocateLabel() {
-    label_ = label_block_->AllocateLabel();
+// The hint is the index of the McastManagerPartition, so that partitions
+// allocate from different sub-blocks of a large LabelBlock.
+//
+void McastForwarder::AllocateLabel(size_t hint) {
+    label_ = label_block_->AllocateLabel(hint);
 }
 
 //
@@ -194,73 +200,177 @@ std::string McastSGEntry::ToString() const {
 
 //
 // Add the given McastForwarder under this McastSGEntry and trigger update
-// of the distribution tree.
+// of the distribution tree. The McastForwarder goes at the end of the tree.
 //
 void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
-    forwarders_.insert(forwarder);
+    if (forwarders_.insert(forwarder).second) {
+        forwarder->set_tree_index(tree_.size());
+        changed_slots_.insert(tree_.size());
+        tree_.push_back(forwarder);
+    }
     partition_->EnqueueSGEntry(this);
 }
 
 //
 // Delete the given McastForwarder from this McastSGEntry and trigger update
-// of the distribution tree.
+// of the distribution tree. The links to the McastForwarder are flushed and
+// its neighbors are marked dirty since their OLists change.
 //
 void McastSGEntry::DeleteForwarder(McastForwarder *forwarder) {
     forwarders_.erase(forwarder);
+    if (forwarder->tree_index() >= 0) {
+        tree_[forwarder->tree_index()] = NULL;
+        changed_slots_.insert(forwarder->tree_index());
+        forwarder->set_tree_index(-1);
+    }
+    for (McastForwarderList::const_iterator it =
+         forwarder->tree_links().begin();
+         it != forwarder->tree_links().end(); ++it) {
+        dirty_.insert(*it);
+    }
+    forwarder->FlushLinks();
+    dirty_.erase(forwarder);
     partition_->EnqueueSGEntry(this);
 }
 
 //
-// Update the distribution tree for this McastSGEntry.  We traverse all the
-// McastForwarders in sorted order and arrange them in breadth first fashion
-// in a k-ary tree.  Building the tree in this manner guarantees that we get
-// the same tree for a given set of forwarders, independent of the order in
-// in which they joined. This predictability is deemed to be more important
-// than other criteria such as minimizing disruption of traffic, minimizing
-// the cost/weight of the tree etc.
+// Update the links of the given McastForwarder to match its position in the
+// k-ary tree i.e. a link to the parent and to each of the children.  Both
+// ends of a link that's added or removed are marked dirty.
 //
-void McastSGEntry::UpdateTree() {
-    CHECK_CONCURRENCY("db::DBTable");
+// A label is allocated if the McastForwarder doesn't have one yet. All the
+// neighbors are marked dirty in that case since their OLists change.
+//
+void McastSGEntry::LinkForwarder(McastForwarder *forwarder) {
+    int idx = forwarder->tree_index();
+    int size = tree_.size();
+    McastForwarderList links;
+    if (idx > 0)
+        links.push_back(tree_[(idx - 1) / McastTreeManager::kDegree]);
+    for (int child_idx = idx * McastTreeManager::kDegree + 1;
+         child_idx <= (idx + 1) * McastTreeManager::kDegree &&
+         child_idx < size; child_idx++) {
+        links.push_back(tree_[child_idx]);
+    }
 
-    // First get rid of the previous distribution tree and enqueue all the
-    // associated InetMcastRoutes for notification.  Note that DBListeners
-    // will not get invoked until after this routine is done.
-    for (ForwarderSet::iterator it = forwarders_.begin();
-        it != forwarders_.end(); ++it) {
-       (*it)->FlushLinks();
-       (*it)->ReleaseLabel();
-       partition_->GetTablePartition()->Notify((*it)->route());
+    McastForwarderList current = forwarder->tree_links();
+    for (McastForwarderList::iterator it = current.begin();
+         it != current.end(); ++it) {
+        if (std::find(links.begin(), links.end(), *it) != links.end())
+            continue;
+        forwarder->RemoveLink(*it);
+        (*it)->RemoveLink(forwarder);
+        dirty_.insert(forwarder);
+        dirty_.insert(*it);
     }
 
-    // Don't need to build a tree unless we have at least 2 McastForwarders.
-    if (forwarders_.size() <= 1)
-        return;
+    for (McastForwarderList::iterator it = links.begin();
+         it != links.end(); ++it) {
+        if (forwarder->FindLink(*it))
+            continue;
+        forwarder->AddLink(*it);
+        (*it)->AddLink(forwarder);
+        dirty_.insert(forwarder);
+        dirty_.insert(*it);
+    }
 
+    if (forwarder->label() == 0) {
+        forwarder->AllocateLabel(partition_->part_id());
+        dirty_.insert(forwarder);
+        dirty_.insert(links.begin(), links.end());
+    }
+}
 
-    // Create a vector of pointers to the McastForwarders in sorted order. We
-    // resort to this because std:set doesn't support random access iterators.
-    McastForwarderList vec;
-    vec.reserve(forwarders_.size());
-    for (ForwarderSet::iterator it = forwarders_.begin();
-         it != forwarders_.end(); ++it) {
-        vec.push_back(*it);
+//
+// Take the given McastForwarder out of the distribution tree by flushing its
+// links and releasing its label.  Used when it's the only McastForwarder.
+//
+void McastSGEntry::ReleaseForwarder(McastForwarder *forwarder) {
+    if (forwarder->empty() && forwarder->label() == 0)
+        return;
+    for (McastForwarderList::const_iterator it =
+         forwarder->tree_links().begin();
+         it != forwarder->tree_links().end(); ++it) {
+        dirty_.insert(*it);
     }
+    forwarder->FlushLinks();
+    forwarder->ReleaseLabel();
+    dirty_.insert(forwarder);
+}
 
-    // Go through each McastForwarder in the vector and link it to it's parent
-    // McastForwarder in the k-ary tree. We also add a link from the parent to
-    // the entry in question.
-    for (McastForwarderList::iterator it = vec.begin(); it != vec.end(); ++it) {
-        (*it)->AllocateLabel();
-        int idx = it - vec.begin();
-        if (idx == 0)
+//
+// Update the distribution tree for this McastSGEntry.  The McastForwarders
+// are arranged in breadth first fashion in a k-ary tree, in the order that
+// they joined.  Empty slots left behind by McastForwarders that have left
+// are filled by moving the last McastForwarder in the tree, so the tree is
+// always complete.
+//
+// Only the McastForwarders in or adjacent to a slot that changed occupant
+// need to be relinked. Existing labels are retained, and only the routes of
+// McastForwarders whose OLists changed are notified. This keeps the cost of
+// a join or leave independent of the number of McastForwarders, which is
+// deemed more important than having the same tree for a given set of
+// McastForwarders independent of the order in which they joined.
+//
+void McastSGEntry::UpdateTree() {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    // Fill empty slots in ascending order. The slot vacated by the moved
+    // McastForwarder is beyond all remaining empty slots, so it's trimmed
+    // before it's visited.
+    for (std::set<int>::iterator it = changed_slots_.begin();
+         it != changed_slots_.end(); ++it) {
+        while (!tree_.empty() && tree_.back() == NULL)
+            tree_.pop_back();
+        int idx = *it;
+        if (idx >= (int) tree_.size())
+            break;
+        if (tree_[idx] != NULL)
             continue;
+        McastForwarder *forwarder = tree_.back();
+        tree_.pop_back();
+        changed_slots_.insert(tree_.size());
+        tree_[idx] = forwarder;
+        forwarder->set_tree_index(idx);
+    }
+
+    // Don't need a tree unless we have at least 2 McastForwarders.
+    if (tree_.size() <= 1) {
+        for (McastForwarderList::iterator it = tree_.begin();
+             it != tree_.end(); ++it) {
+            ReleaseForwarder(*it);
+        }
+    } else {
+        int size = tree_.size();
+        std::set<int> affected;
+        for (std::set<int>::iterator it = changed_slots_.begin();
+             it != changed_slots_.end(); ++it) {
+            int idx = *it;
+            if (idx < size)
+                affected.insert(idx);
+            int parent_idx = (idx - 1) / McastTreeManager::kDegree;
+            if (idx > 0 && parent_idx < size)
+                affected.insert(parent_idx);
+            for (int child_idx = idx * McastTreeManager::kDegree + 1;
+                 child_idx <= (idx + 1) * McastTreeManager::kDegree &&
+                 child_idx < size; child_idx++) {
+                affected.insert(child_idx);
+            }
+        }
+        for (std::set<int>::iterator it = affected.begin();
+             it != affected.end(); ++it) {
+            LinkForwarder(tree_[*it]);
+        }
+    }
+    changed_slots_.clear();
 
-        int parent_idx = (idx - 1) / McastTreeManager::kDegree;
-        McastForwarderList::iterator parent_it = vec.begin() + parent_idx;
-        assert(parent_it != vec.end());
-        (*it)->AddLink(*parent_it);
-        (*parent_it)->AddLink(*it);
+    // Enqueue the InetMcastRoutes of dirty McastForwarders for notification.
+    // Note that DBListeners will not get invoked until after this routine is
+    // done.
+    for (DirtySet::iterator it = dirty_.begin(); it != dirty_.end(); ++it) {
+        partition_->NotifyForwarder(*it);
     }
+    dirty_.clear();
 }
 
 //
@@ -271,6 +381,7 @@ McastManagerPartition::McastManagerPartition(McastTreeManager *tree_manager,
     : tree_manager_(tree_manager),
       part_id_(part_id),
       update_count_(0),
+      notify_count_(0),
       work_queue_(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"),
               part_id_,
               boost::bind(&McastManagerPartition::ProcessSGEntry, this, _1)) {
@@ -316,6 +427,14 @@ void McastManagerPartition::EnqueueSGEntry(McastSGEntry *sg_entry) {
     sg_entry->set_on_work_queue();
 }
 
+//
+// Enqueue the InetMcastRoute for the given McastForwarder for notification.
+//
+void McastManagerPartition::NotifyForwarder(McastForwarder *forwarder) {
+    GetTablePartition()->Notify(forwarder->route());
+    notify_count_++;
+}
+
 //
 // Callback for the WorkQueue.  Get rid of the McastSGEntry if it there no
 // McastForwarders under it. Otherwise, update the distribution tree for it.
@@ -61,7 +61,12 @@ typedef std::vector<McastForwarder *> McastForwarderList;
 // the distribution tree for the McastSGEntry. Note that only a single MPLS
 // label is used for a McastForwarder in a given distribution tree.  Hence
 // the label can be stored in the McastForwarder itself and does not need
-// to be part of the link information.
+// to be part of the link information. The label is kept for as long as the
+// McastForwarder is part of a tree, so that the OLists of its neighbors do
+// not change when other McastForwarders join or leave.
+//
+// The tree index is the position of the McastForwarder in the k-ary tree
+// of the McastSGEntry.
 //
 class McastForwarder : public DBState {
 public:
@@ -75,16 +80,19 @@ public:
     void RemoveLink(McastForwarder *forwarder);
     void FlushLinks();
 
-    void AllocateLabel();
+    void AllocateLabel(size_t hint);
     void ReleaseLabel();
 
     UpdateInfo *GetUpdateInfo(InetMcastTable *table);
 
     uint32_t label() const { return label_; }
+    int tree_index() const { return tree_index_; }
+    void set_tree_index(int tree_index) { tree_index_ = tree_index; }
     Ip4Address address() const { return address_; }
     InetMcastRoute *route() { return route_; }
     RouteDistinguisher route_distinguisher() const { return rd_; }
 
+    const McastForwarderList &tree_links() const { return tree_links_; }
     bool empty() { return tree_links_.empty(); }
 
 private:
@@ -94,6 +102,7 @@ private:
     InetMcastRoute *route_;
     LabelBlockPtr label_block_;
     uint32_t label_;
+    int tree_index_;
     RouteDistinguisher rd_;
     Ip4Address address_;
     McastForwarderList tree_links_;
@@ -144,6 +153,13 @@ struct McastForwarderCompare {
 // in the McastManagerPartition when a McastForwarder is added or deleted,
 // so that the distribution tree gets updtaed.
 //
+// The distribution tree itself is kept as a vector of McastForwarders in
+// breadth first order of the k-ary tree. A joining McastForwarder is placed
+// at the end of the vector and the slot of a leaving McastForwarder is left
+// empty until the tree is updated, at which time it's filled by the last
+// McastForwarder. McastForwarders whose links or whose neighbors' labels
+// changed are kept in a set, so that only their routes get notified.
+//
 class McastSGEntry {
 public:
     McastSGEntry(McastManagerPartition *partition,
@@ -171,11 +187,18 @@ private:
     friend class ShowMulticastManagerDetailHandler;
 
     typedef std::set<McastForwarder *, McastForwarderCompare> ForwarderSet;
+    typedef std::set<McastForwarder *> DirtySet;
+
+    void LinkForwarder(McastForwarder *forwarder);
+    void ReleaseForwarder(McastForwarder *forwarder);
 
     McastManagerPartition *partition_;
     Ip4Address group_, source_;
     bool on_work_queue_;
     ForwarderSet forwarders_;
+    McastForwarderList tree_;
+    std::set<int> changed_slots_;
+    DirtySet dirty_;
 
     DISALLOW_COPY_AND_ASSIGN(McastSGEntry);
 };
@@ -231,11 +254,13 @@ public:
     McastSGEntry *FindSGEntry(Ip4Address group, Ip4Address source);
     McastSGEntry *LocateSGEntry(Ip4Address group, Ip4Address source);
     void EnqueueSGEntry(McastSGEntry *sg_entry);
+    void NotifyForwarder(McastForwarder *forwarder);
 
     DBTablePartBase *GetTablePartition();
 
     bool empty() { return sg_list_.empty(); }
     size_t size() { return sg_list_.size(); }
+    size_t part_id() const { return part_id_; }
 
 private:
     friend class BgpMulticastTest;
@@ -249,6 +274,7 @@ private:
     size_t part_id_;
     SGList sg_list_;
     int update_count_;
+    uint64_t notify_count_;
     WorkQueue<McastSGEntry *> work_queue_;
 
     DISALLOW_COPY_AND_ASSIGN(McastManagerPartition);
@@ -25,6 +25,7 @@
 #include "bgp/inet/inet_table.h"
 #include "bgp/inetmcast/inetmcast_table.h"
 #include "bgp/routing-instance/peer_manager.h"
+#include "bgp/routing-instance/routepath_replicator.h"
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/origin-vn/origin_vn.h"
 #include "bgp/security_group/security_group.h"
@@ -823,6 +824,57 @@ void ShowMulticastManagerReq::HandleRequest() const {
     RequestPipeline rp(ps);
 }
 
+class ShowRoutePathReplicatorHandler {
+public:
+    static void FillReplicatorInfo(vector<ShowRoutePathReplicator> &list,
+                                   RoutePathReplicator *replicator) {
+        if (!replicator)
+            return;
+        ShowRoutePathReplicator info;
+        info.set_family(Address::FamilyToString(replicator->family()));
+        info.set_rtgroups(replicator->GetRtGroupMap().size());
+        info.set_fanout_cache_hits(replicator->fanout_cache_hits());
+        info.set_fanout_cache_misses(replicator->fanout_cache_misses());
+        info.set_fanout_cache_entries(replicator->fanout_cache_size());
+        info.set_fanout_cache_generation(replicator->fanout_cache_generation());
+        list.push_back(info);
+    }
+
+    static bool CallbackS1(const Sandesh *sr,
+            const RequestPipeline::PipeSpec ps, int stage, int instNum,
+            RequestPipeline::InstData *data) {
+        const ShowRoutePathReplicatorReq *req =
+            static_cast<const ShowRoutePathReplicatorReq *>(
+                ps.snhRequest_.get());
+        BgpSandeshContext *bsc =
+            static_cast<BgpSandeshContext *>(req->client_context());
+
+        vector<ShowRoutePathReplicator> list;
+        FillReplicatorInfo(list, bsc->bgp_server->replicator(Address::INETVPN));
+        FillReplicatorInfo(list, bsc->bgp_server->replicator(Address::EVPN));
+
+        ShowRoutePathReplicatorResp *resp = new ShowRoutePathReplicatorResp;
+        resp->set_replicators(list);
+        resp->set_context(req->context());
+        resp->Response();
+        return true;
+    }
+};
+
+void ShowRoutePathReplicatorReq::HandleRequest() const {
+    RequestPipeline::PipeSpec ps(this);
+
+    // Request pipeline has single stage to collect replicator stats
+    // and respond to the request
+    RequestPipeline::StageSpec s1;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    s1.taskId_ = scheduler->GetTaskId("bgp::ShowCommand");
+    s1.cbFn_ = ShowRoutePathReplicatorHandler::CallbackS1;
+    s1.instances_.push_back(0);
+    ps.stages_ = list_of(s1);
+    RequestPipeline rp(ps);
+}
+
 class ShowMulticastManagerDetailHandler {
 public:
     struct MulticastManagerDetailData : public RequestPipeline::InstData {
@@ -58,9 +58,13 @@ public:
     virtual Address::Family family() const = 0;
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const = 0;
 
+    // Add or update the secondary path for path in the matching route of
+    // this table. attr is the attribute of the secondary path; it is the
+    // same for every table that a path is replicated to, so the caller
+    // locates it once.
     virtual BgpRoute *RouteReplicate(BgpServer *server, BgpTable *table, 
                                      BgpRoute *src, const BgpPath *path, 
-                                     ExtCommunityPtr community) = 0;
+                                     BgpAttrPtr attr) = 0;
 
     static bool PathSelection(const Path &path1, const Path &path2);
     UpdateInfo *GetUpdateInfo(RibOut *ribout, BgpRoute *route,
@@ -69,7 +69,7 @@ DBTableBase *EnetTable::CreateTable(DB *db, const std::string &name) {
 
 BgpRoute *EnetTable::RouteReplicate(BgpServer *server,
         BgpTable *src_table, BgpRoute *src_rt, const BgpPath *src_path,
-        ExtCommunityPtr community) {
+        BgpAttrPtr new_attr) {
     assert(src_table->family() == Address::EVPN);
 
     EnetRoute *enet= dynamic_cast<EnetRoute *>(src_rt);
@@ -96,10 +96,6 @@ BgpRoute *EnetTable::RouteReplicate(BgpServer *server,
         dest_route->ClearDelete();
     }
 
-    // Replace the extended community with the one provided.
-    BgpAttrPtr new_attr = server->attr_db()->ReplaceExtCommunityAndLocate(
-        src_path->GetAttr(), community);
-
     // Check whether peer already has a path.
     BgpPath *dest_path =
         dest_route->FindSecondaryPath(src_rt, src_path->GetPeer(), 
@@ -82,7 +82,7 @@ static RouteDistinguisher GenerateDistinguisher(
 
 BgpRoute *EvpnTable::RouteReplicate(BgpServer *server,
         BgpTable *src_table, BgpRoute *src_rt, const BgpPath *src_path,
-        ExtCommunityPtr community) {
+        BgpAttrPtr new_attr) {
     assert(src_table->family() == Address::ENET);
 
     EnetRoute *enet = dynamic_cast<EnetRoute *>(src_rt);
@@ -104,10 +104,6 @@ BgpRoute *EvpnTable::RouteReplicate(BgpServer *server,
         dest_route->ClearDelete();
     }
 
-    BgpAttrPtr new_attr =
-        server->attr_db()->ReplaceExtCommunityAndLocate(src_path->GetAttr(),
-                                                        community);
-
     // Check whether peer already has a path
     BgpPath *dest_path = dest_route->FindSecondaryPath(src_rt, 
                                    src_path->GetPeer(), src_path->GetSource());
@@ -57,7 +57,7 @@ DBTableBase *InetTable::CreateTable(DB *db, const std::string &name) {
 
 BgpRoute *InetTable::RouteReplicate(BgpServer *server,
         BgpTable *src_table, BgpRoute *src_rt, const BgpPath *path,
-        ExtCommunityPtr community) {
+        BgpAttrPtr new_attr) {
 
     InetRoute *inet= dynamic_cast<InetRoute *> (src_rt);
 
@@ -84,10 +84,6 @@ BgpRoute *InetTable::RouteReplicate(BgpServer *server,
         dest_route->ClearDelete();
     }
 
-    // Replace the extended community with the one provided.
-    BgpAttrPtr new_attr = server->attr_db()->ReplaceExtCommunityAndLocate(
-        path->GetAttr(), community);
-
     // Check whether there's already a path with the given peer and path id.
     BgpPath *dest_path = dest_route->FindSecondaryPath(src_rt, path->GetPeer(),
                                           path->GetPathId(), path->GetSource());
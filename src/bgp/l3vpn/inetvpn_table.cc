@@ -72,7 +72,7 @@ static RouteDistinguisher GenerateDistinguisher(
 
 BgpRoute *InetVpnTable::RouteReplicate(BgpServer *server,
         BgpTable *src_table, BgpRoute *src_rt, const BgpPath *src_path,
-        ExtCommunityPtr community) {
+        BgpAttrPtr new_attr) {
     assert(src_table->family()  == Address::INET);
 
     InetRoute *inet = dynamic_cast<InetRoute *> (src_rt);
@@ -95,10 +95,6 @@ BgpRoute *InetVpnTable::RouteReplicate(BgpServer *server,
         dest_route->ClearDelete();
     }
 
-    BgpAttrPtr new_attr = 
-        server->attr_db()->ReplaceExtCommunityAndLocate(src_path->GetAttr(),
-                                                        community);
-
     // Check whether there's already a path with the given peer and path id.
     BgpPath *dest_path =
         dest_route->FindSecondaryPath(src_rt, src_path->GetPeer(), 
@@ -36,7 +36,7 @@ public:
 
     virtual BgpRoute *RouteReplicate(BgpServer *server, BgpTable *src_table, 
                                      BgpRoute *src_rt, const BgpPath *path,
-                                     ExtCommunityPtr ptr);
+                                     BgpAttrPtr attr);
 
     virtual bool Export(RibOut *ribout, Route *route,
                         const RibPeerSet &peerset,
@@ -4,6 +4,8 @@
 
 #include "bgp/routing-instance/routepath_replicator.h"
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
@@ -24,6 +26,7 @@
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/routing-instance/rtarget_group.h"
 #include "bgp/routing-instance/routing_instance_analytics_types.h"
+#include "db/db.h"
 #include "db/db_table_partition.h"
 #include "db/db_table_walker.h"
 
@@ -70,7 +73,9 @@ RoutePathReplicator::RoutePathReplicator(
           unreg_trigger_(new TaskTrigger(
           boost::bind(&RoutePathReplicator::UnregisterTables, this),
               TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0)),
-          trace_buf_(SandeshTraceBufferCreate("RoutePathReplicator", 500)) {
+          trace_buf_(SandeshTraceBufferCreate("RoutePathReplicator", 500)),
+          fanout_cache_(DB::PartitionCount()),
+          fanout_generation_(0) {
 }
 
 RoutePathReplicator::~RoutePathReplicator() {
@@ -219,6 +224,7 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
         group->AddExportTable(table);
 
     RPR_TRACE(TableJoin, table->name(), rt.ToString(), import);
+    FlushFanoutCache();
     if (import) {
         BOOST_FOREACH(BgpTable *bgptable, group->GetExportTables()) {
             RequestWalk(bgptable);
@@ -253,6 +259,7 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
     assert(group);
 
     RPR_TRACE(TableLeave, table->name(), rt.ToString(), import);
+    FlushFanoutCache();
 
     if (import) {
         group->RemoveImportTable(table);
@@ -386,6 +393,110 @@ static ExtCommunityPtr UpdateExtCommunity(BgpServer *server,
     return ExtCommunityPtr(ext_community);
 }
 
+void RoutePathReplicator::FlushFanoutCache() {
+    CHECK_CONCURRENCY("bgp::Config");
+    for (size_t i = 0; i < fanout_cache_.size(); i++) {
+        fanout_cache_[i].map.clear();
+    }
+    fanout_generation_++;
+}
+
+uint64_t RoutePathReplicator::fanout_cache_hits() const {
+    uint64_t hits = 0;
+    for (size_t i = 0; i < fanout_cache_.size(); i++) {
+        hits += fanout_cache_[i].hits;
+    }
+    return hits;
+}
+
+uint64_t RoutePathReplicator::fanout_cache_misses() const {
+    uint64_t misses = 0;
+    for (size_t i = 0; i < fanout_cache_.size(); i++) {
+        misses += fanout_cache_[i].misses;
+    }
+    return misses;
+}
+
+size_t RoutePathReplicator::fanout_cache_size() const {
+    size_t size = 0;
+    for (size_t i = 0; i < fanout_cache_.size(); i++) {
+        size += fanout_cache_[i].map.size();
+    }
+    return size;
+}
+
+//
+// Fill in the list of tables that import any of the RouteTargets in the
+// ExtCommunity, sorted and without duplicates.
+//
+void RoutePathReplicator::BuildFanout(const ExtCommunity *ext_community,
+                                      FanoutEntry *entry) {
+    entry->tables.clear();
+    BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm,
+                  ext_community->communities()) {
+        if (!ExtCommunity::is_route_target(comm))
+            continue;
+        RtGroup *rtgroup = GetRtGroup(comm);
+        if (rtgroup) {
+            entry->tables.insert(entry->tables.end(),
+                                 rtgroup->GetImportTables().begin(),
+                                 rtgroup->GetImportTables().end());
+        }
+    }
+    std::sort(entry->tables.begin(), entry->tables.end());
+    entry->tables.erase(
+        std::unique(entry->tables.begin(), entry->tables.end()),
+        entry->tables.end());
+}
+
+//
+// Get the updated ExtCommunity and the destination tables for a path with
+// the given ExtCommunity in an instance. Returns NULL if the updated path
+// has no extended communities.
+//
+const RoutePathReplicator::FanoutEntry *RoutePathReplicator::GetFanout(
+        int part_id, const RoutingInstance *rtinstance,
+        const ExtCommunity *ext_community) {
+    FanoutCache &cache = fanout_cache_[part_id];
+
+    ExtCommunityPtr updated;
+    FanoutKey key(rtinstance, ext_community);
+    if (rtinstance->IsDefaultRoutingInstance()) {
+        updated = UpdateExtCommunity(server(), rtinstance, ext_community,
+                                     ExtCommunity::ExtCommunityList());
+        if (!updated)
+            return NULL;
+        key = FanoutKey(NULL, updated.get());
+    }
+
+    FanoutMap::iterator loc = cache.map.find(key);
+    if (loc != cache.map.end()) {
+        cache.hits++;
+        return &loc->second;
+    }
+    cache.misses++;
+
+    if (!updated) {
+        // Add the RouteTargets exported by the instance.
+        ExtCommunity::ExtCommunityList export_list;
+        BOOST_FOREACH(RouteTarget rtarget, rtinstance->GetExportList()) {
+            export_list.push_back(rtarget.GetExtCommunity());
+        }
+        updated = UpdateExtCommunity(server(), rtinstance, ext_community,
+                                     export_list);
+        if (!updated)
+            return NULL;
+    }
+
+    if (cache.map.size() >= kMaxFanoutCacheEntries)
+        cache.map.clear();
+    FanoutEntry &entry = cache.map[key];
+    entry.ext_community = ext_community;
+    entry.updated = updated;
+    BuildFanout(updated.get(), &entry);
+    return &entry;
+}
+
 // concurrency: db-partition
 // This function handles
 //   1. Table Notification for route replication
@@ -425,14 +536,6 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         rt->SetState(table, id, dbstate);
     }
 
-    // Get the export route target list from the routing instance
-    ExtCommunity::ExtCommunityList export_list;
-    if (!rtinstance->IsDefaultRoutingInstance()) {
-        BOOST_FOREACH(RouteTarget rtarget, rtinstance->GetExportList()) {
-            export_list.push_back(rtarget.GetExtCommunity());
-        }
-    }
-
     // Replicate all feasible and non replicated paths.
     for (Route::PathList::iterator it = rt->GetPathList().begin(); 
         it != rt->GetPathList().end(); it++) {
@@ -444,43 +547,29 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         if (rt->BestPath()->PathCompare(*path, true)) break;
 
         const BgpAttr *attr = path->GetAttr();
-        const ExtCommunity *ext_community = attr->ext_community();
 
-        ExtCommunityPtr extcomm_ptr =
-            UpdateExtCommunity(server(), rtinstance, ext_community, export_list);
-        ext_community = extcomm_ptr.get();
-        if (!ext_community)
+        // Get the list of tables to replicate to, based on the RouteTarget
+        // extended communities.
+        const FanoutEntry *fanout =
+            GetFanout(root->index(), rtinstance, attr->ext_community());
+        if (!fanout || fanout->tables.empty())
             continue;
 
-        RtGroup::RtGroupMemberList super_set;
-
-        // For each RouteTarget extended community, get the list of tables to
-        // replicate to.
-        BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm, 
-                      ext_community->communities()) {
-            if (!ExtCommunity::is_route_target(comm))
-                continue;
-            RtGroup *rtgroup = GetRtGroup(comm);
-            if (rtgroup) {
-                super_set.insert(super_set.end(), 
-                                 rtgroup->GetImportTables().begin(),
-                                 rtgroup->GetImportTables().end());
-            }
-        }
-
-        if (super_set.empty()) continue;
-
-        // Duplicate tables to be removed
-        super_set.sort();
-        super_set.unique();
+        // The secondary paths in all destination tables share the attribute,
+        // so locate it once instead of once per table.
+        BgpAttrPtr new_attr;
 
         // To all destination tables.. call replicate
-        BOOST_FOREACH(BgpTable *dest, super_set) {
+        BOOST_FOREACH(BgpTable *dest, fanout->tables) {
             // same as source table... skip
             if (dest == table) continue;
 
+            if (!new_attr) {
+                new_attr = server()->attr_db()->ReplaceExtCommunityAndLocate(
+                    attr, fanout->updated);
+            }
             BgpRoute *replicated = dest->RouteReplicate(server(), table,
-                                        rt, path, extcomm_ptr);
+                                        rt, path, new_attr);
             if (replicated) {
                 RtReplicated::SecondaryRouteInfo rtinfo(dest, path->GetPeer(),
                             path->GetPathId(), path->GetSource(), replicated);
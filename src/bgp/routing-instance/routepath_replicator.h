@@ -6,6 +6,8 @@
 #define ctrlplane_routepath_replicator_h
 
 #include <list>
+#include <map>
+#include <vector>
 
 #include <boost/ptr_container/ptr_map.hpp>
 #include <tbb/mutex.h>
@@ -18,6 +20,7 @@
 
 class BgpRoute;
 class BgpServer;
+class RoutingInstance;
 class RtGroup;
 class RouteTarget;
 class TaskTrigger;
@@ -187,11 +190,50 @@ public:
 
     bool UnregisterTables();
 
+    uint64_t fanout_cache_hits() const;
+    uint64_t fanout_cache_misses() const;
+    size_t fanout_cache_size() const;
+    uint64_t fanout_cache_generation() const { return fanout_generation_; }
+
 private:
     typedef std::map<BgpTable *, TableState *> RtGroupTableState;
     typedef std::map<BgpTable *, BulkSyncState *> BulkSyncOrders;
     typedef std::set<BgpTable *> UnregTableList;
 
+    static const size_t kMaxFanoutCacheEntries = 4096;
+
+    // Destination tables of the paths with a given ExtCommunity, along with
+    // the ExtCommunity updated with the export targets of the instance.
+    // The ExtCommunity of the path is held so that its address, used in the
+    // key, is not reused while the entry exists.
+    struct FanoutEntry {
+        ExtCommunityPtr ext_community;
+        ExtCommunityPtr updated;
+        std::vector<BgpTable *> tables;
+    };
+
+    // Keyed by the instance and the ExtCommunity of the path for non-default
+    // instances, whose export targets change only through Join and Leave.
+    // Keyed by the updated ExtCommunity, with a NULL instance, for the
+    // default instance since the OriginVn it adds depends on other config.
+    typedef std::pair<const RoutingInstance *, const ExtCommunity *> FanoutKey;
+    typedef std::map<FanoutKey, FanoutEntry> FanoutMap;
+
+    // One cache per DB partition, accessed only from that partition's
+    // listener and walker, so no lock is needed.
+    struct FanoutCache {
+        FanoutCache() : hits(0), misses(0) {}
+        FanoutMap map;
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    const FanoutEntry *GetFanout(int part_id,
+                                 const RoutingInstance *rtinstance,
+                                 const ExtCommunity *ext_community);
+    void BuildFanout(const ExtCommunity *ext_community, FanoutEntry *entry);
+    void FlushFanoutCache();
+
     bool StartWalk();
 
     void DeleteSecondaryPath(BgpTable  *table, BgpRoute *rt,
@@ -212,6 +254,10 @@ private:
     boost::scoped_ptr<TaskTrigger> walk_trigger_;
     boost::scoped_ptr<TaskTrigger> unreg_trigger_;
     SandeshTraceBufferPtr trace_buf_;
+    // Flushed on every Join and Leave, which run in bgp::Config and hence
+    // never concurrently with the table listeners
+    std::vector<FanoutCache> fanout_cache_;
+    uint64_t fanout_generation_;
 };
 
 #endif // ctrlplane_routepath_replicator_h
@@ -41,7 +41,13 @@ ServiceChain::ServiceChain(RoutingInstance *src, RoutingInstance *dest,
         error_code ec;
         Ip4Prefix ipam_subnet = Ip4Prefix::FromString(*it, &ec);
         assert(ec == 0);
-        prefix_to_routelist_map_[ipam_subnet] = RouteList();
+        if (!prefix_to_routelist_map_.insert(
+                std::make_pair(ipam_subnet, RouteList())).second) {
+            continue;
+        }
+        AggregateNode *node = new AggregateNode(ipam_subnet);
+        aggregate_nodes_.push_back(node);
+        aggregate_tree_.Insert(node);
     }
 }
 
@@ -190,30 +196,34 @@ bool ServiceChain::Match(BgpServer *server, BgpTable *table,
 
 bool ServiceChain::is_more_specific(BgpRoute *route, 
                                     Ip4Prefix *aggregate_match) {
-    unsigned long broadcast = 0xFFFFFFFF;
     InetRoute *inet_route = dynamic_cast<InetRoute *>(route);
-    Ip4Address address = inet_route->GetPrefix().ip4_addr();
-    for(PrefixToRouteListMap::iterator it = prefix_to_route_list_map()->begin();
-        it != prefix_to_route_list_map()->end(); it++) {
-        unsigned long shift_mask = (32 - it->first.prefixlen());
-        if ((it->first.prefixlen() != inet_route->GetPrefix().prefixlen()) &&
-            ((address.to_ulong() & (broadcast << shift_mask)) == 
-             (it->first.ip4_addr().to_ulong() & (broadcast << shift_mask)))) {
-            *aggregate_match = it->first;
-            return true;
-        }
+    return FindAggregateMatch(inet_route->GetPrefix(), aggregate_match);
+}
+
+//
+// Looks up the aggregate tree with the prefix shortened by one bit, so that
+// the aggregate is strictly less specific than the prefix. Only the first
+// prefixlen bits of the lookup key are compared, so the address need not be
+// masked.
+//
+bool ServiceChain::FindAggregateMatch(const Ip4Prefix &prefix,
+                                      Ip4Prefix *aggregate_match) {
+    if (prefix.prefixlen() == 0) {
+        return false;
+    }
+    AggregateNode key(Ip4Prefix(prefix.ip4_addr(), prefix.prefixlen() - 1));
+    AggregateNode *node = aggregate_tree_.LPMFind(&key);
+    if (node == NULL) {
+        return false;
     }
-    return false;
+    *aggregate_match = node->prefix;
+    return true;
 }
 
 bool ServiceChain::is_aggregate(BgpRoute *route) {
     InetRoute *inet_route = dynamic_cast<InetRoute *>(route);
-    for (PrefixToRouteListMap::iterator it = prefix_to_route_list_map()->begin();
-        it != prefix_to_route_list_map()->end(); it++) {
-        if (it->first == inet_route->GetPrefix())
-            return true;
-    }
-    return false;
+    return (prefix_to_routelist_map_.find(inet_route->GetPrefix()) !=
+            prefix_to_routelist_map_.end());
 }
 
 // RemoveServiceChainRoute
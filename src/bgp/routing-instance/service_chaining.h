@@ -9,7 +9,9 @@
 #include <map>
 #include <set>
 
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/shared_ptr.hpp>
+#include <base/patricia.h>
 #include <base/queue_task.h>
 
 #include <sandesh/sandesh_types.h>
@@ -143,6 +145,10 @@ public:
     virtual bool Match(BgpServer *server, BgpTable *table, 
                        BgpRoute *route, bool deleted);
 
+    // Find the longest aggregate prefix that is less specific than prefix
+    bool FindAggregateMatch(const Ip4Prefix &prefix,
+                            Ip4Prefix *aggregate_match);
+
     void FillServiceChainInfo(ShowServicechainInfo &info) const; 
 
     void src_table_unregistered() {
@@ -190,12 +196,41 @@ public:
     }
 
 private:
+    //
+    // Node in the longest prefix match index of the aggregate prefixes
+    //
+    struct AggregateNode {
+        explicit AggregateNode(const Ip4Prefix &prefix) : prefix(prefix) {
+        }
+
+        class Key {
+        public:
+            static std::size_t Length(AggregateNode *node) {
+                return node->prefix.prefixlen();
+            }
+            static char ByteValue(AggregateNode *node, std::size_t i) {
+                const Ip4Address::bytes_type &addr_bytes =
+                    node->prefix.ip4_addr().to_bytes();
+                return static_cast<char>(addr_bytes[i]);
+            }
+        };
+
+        Ip4Prefix prefix;
+        Patricia::Node node;
+    };
+    typedef Patricia::Tree<AggregateNode, &AggregateNode::node,
+                           AggregateNode::Key> AggregateTree;
+
     RoutingInstance *src_;
     RoutingInstance *dest_;
     ConnectedPathIdList connected_path_ids_;
     BgpRoute *connected_route_;
     IpAddress service_chain_addr_;
     PrefixToRouteListMap prefix_to_routelist_map_;
+    // Index of the keys of prefix_to_routelist_map_, which do not change
+    // after the chain is created
+    boost::ptr_vector<AggregateNode> aggregate_nodes_;
+    AggregateTree aggregate_tree_;
     // List of routes from Destination VN for external connectivity
     ExtConnectRouteList ext_connect_routes_;
     bool src_table_unregistered_;
@@ -530,6 +530,93 @@ TEST_F(BgpConditionListenerTest, ChangeNotify) {
     task_util::WaitForIdle();
 }
 
+//
+// Match conditions added together share one walk of the table, and the walk
+// does not match the routes again against conditions added earlier.
+//
+TEST_F(BgpConditionListenerTest, CoalescedWalk) {
+    static const int kMatchCount = 64;
+    AddRoutingInstance("blue");
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < 16; i++) {
+        ostringstream route;
+        route << "192.168.1." << i << "/32";
+        AddInetRoute("blue", route.str());
+    }
+    AddMatchCondition("blue", "192.168.1.0/24");
+    task_util::WaitForIdle();
+    TestConditionMatch *match =
+        static_cast<TestConditionMatch *>(match_.get());
+    TASK_UTIL_EXPECT_EQ(16, match->matched_routes_size());
+
+    BgpConditionListener *listener = bgp_server_->condition_listener();
+    uint64_t walk_count = listener->walk_count();
+    uint64_t walk_request_count = listener->walk_request_count();
+    uint64_t walk_match_count = listener->walk_match_count();
+
+    RoutingInstance *rti =
+        bgp_server_->routing_instance_mgr()->GetRoutingInstance("blue");
+    BgpTable *table = rti->GetTable(Address::INET);
+    vector<ConditionMatchPtr> matches;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+    {
+        ConcurrencyScope scope("bgp::Config");
+        for (int i = 0; i < kMatchCount; i++) {
+            Ip4Prefix prefix = Ip4Prefix::FromString("192.168.1.0/24");
+            ConditionMatchPtr obj(new TestConditionMatch(prefix, false));
+            listener->AddMatchCondition(table, obj.get(),
+                                        BgpConditionListener::RequestDoneCb());
+            matches.push_back(obj);
+        }
+    }
+    scheduler->Start();
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_EQ(walk_count + 1, listener->walk_count());
+    TASK_UTIL_EXPECT_EQ(walk_request_count + kMatchCount,
+                        listener->walk_request_count());
+    TASK_UTIL_EXPECT_EQ(walk_match_count + kMatchCount,
+                        listener->walk_match_count());
+    BOOST_FOREACH(ConditionMatchPtr obj, matches) {
+        TestConditionMatch *test_obj =
+            static_cast<TestConditionMatch *>(obj.get());
+        TASK_UTIL_EXPECT_EQ(16, test_obj->matched_routes_size());
+    }
+    TASK_UTIL_EXPECT_EQ(1, GetMatchState("blue", "192.168.1.1/32")->seen());
+
+    scheduler->Stop();
+    {
+        ConcurrencyScope scope("bgp::Config");
+        BgpConditionListener::RequestDoneCb callback =
+            boost::bind(&BgpConditionListenerTest::DeleteDone, this, _1, _2);
+        BOOST_FOREACH(ConditionMatchPtr obj, matches) {
+            listener->RemoveMatchCondition(table, obj.get(), callback);
+        }
+    }
+    scheduler->Start();
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_EQ(walk_count + 2, listener->walk_count());
+    BOOST_FOREACH(ConditionMatchPtr obj, matches) {
+        TestConditionMatch *test_obj =
+            static_cast<TestConditionMatch *>(obj.get());
+        TASK_UTIL_EXPECT_TRUE(test_obj->matched_routes_empty());
+    }
+    TASK_UTIL_EXPECT_EQ(16, match->matched_routes_size());
+
+    RemoveMatchCondition("blue");
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(match->matched_routes_empty());
+    for (RouteMap::iterator it = routes_added_.begin(), next;
+         it != routes_added_.end(); it = next) {
+        next = it;
+        next++;
+        DeleteInetRoute(it->first, it->second);
+    }
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
@@ -29,6 +29,7 @@
 #include "ifmap/ifmap_server_parser.h"
 #include "ifmap/test/ifmap_test_util.h"
 #include "io/event_manager.h"
+#include "io/test/event_manager_test.h"
 #include "net/mac_address.h"
 #include "schema/vnc_cfg_types.h"
 #include "testing/gunit.h"
@@ -948,6 +949,87 @@ TEST_F(BgpConfigTest, Instances) {
     TASK_UTIL_EXPECT_EQ(0, db_graph_.vertex_count());
 }
 
+//
+// Add and remove a burst of instances with two targets each, with and without
+// coalescing of config changes. Both modes converge to the same instances;
+// coalescing defers the burst and processes it in fewer batches. The event
+// manager runs so that the defer timer can fire.
+//
+TEST_F(BgpConfigTest, InstancesBurst) {
+    static const int kInstanceCount = 256;
+    BgpConfigManager *config_manager = server_.config_manager();
+    RoutingInstanceMgr *mgr = server_.routing_instance_mgr();
+    ServerThread thread(&evm_);
+    thread.Start();
+    uint64_t batches[2];
+    uint64_t defers[2];
+
+    for (int mode = 0; mode < 2; mode++) {
+        config_manager->set_coalesce_changes(mode == 1);
+        uint64_t batch_count = config_manager->change_batch_count();
+        uint64_t delta_count = config_manager->change_delta_count();
+        uint64_t defer_count = config_manager->change_defer_count();
+        uint64_t start = UTCTimestampUsec();
+
+        for (int idx = 0; idx < kInstanceCount; idx++) {
+            string instance = "vrf" + integerToString(idx);
+            string target = "target:1:" + integerToString(idx + 1);
+            ifmap_test_util::IFMapMsgLink(&config_db_,
+                                          "routing-instance", instance,
+                                          "route-target", target,
+                                          "instance-target");
+            ifmap_test_util::IFMapMsgLink(&config_db_,
+                                          "routing-instance", instance,
+                                          "route-target", "target:64512:1",
+                                          "instance-target");
+        }
+        task_util::WaitForIdle();
+        uint64_t add_usec = UTCTimestampUsec() - start;
+
+        TASK_UTIL_EXPECT_EQ(kInstanceCount + 1, mgr->count());
+        for (int idx = 0; idx < kInstanceCount; idx++) {
+            string instance = "vrf" + integerToString(idx);
+            RoutingInstance *rti = mgr->GetRoutingInstance(instance);
+            TASK_UTIL_ASSERT_TRUE(rti != NULL);
+            TASK_UTIL_EXPECT_EQ(2, rti->GetImportList().size());
+            TASK_UTIL_EXPECT_EQ(2, rti->GetExportList().size());
+        }
+        batches[mode] = config_manager->change_batch_count() - batch_count;
+        defers[mode] = config_manager->change_defer_count() - defer_count;
+
+        LOG(DEBUG, (mode ? "Coalesced" : "Default") << " config of "
+            << kInstanceCount << " instances: "
+            << batches[mode] << " batches, " << defers[mode] << " defers, "
+            << config_manager->change_delta_count() - delta_count
+            << " deltas, " << add_usec << " usec, last batch converged in "
+            << config_manager->last_convergence_usec() << " usec");
+
+        for (int idx = 0; idx < kInstanceCount; idx++) {
+            string instance = "vrf" + integerToString(idx);
+            string target = "target:1:" + integerToString(idx + 1);
+            ifmap_test_util::IFMapMsgUnlink(&config_db_,
+                                            "routing-instance", instance,
+                                            "route-target", target,
+                                            "instance-target");
+            ifmap_test_util::IFMapMsgUnlink(&config_db_,
+                                            "routing-instance", instance,
+                                            "route-target", "target:64512:1",
+                                            "instance-target");
+        }
+        task_util::WaitForIdle();
+        TASK_UTIL_EXPECT_EQ(1, mgr->count());
+        TASK_UTIL_EXPECT_EQ(0, db_graph_.vertex_count());
+    }
+
+    config_manager->set_coalesce_changes(false);
+    evm_.Shutdown();
+    thread.Join();
+
+    EXPECT_EQ(0, defers[0]);
+    EXPECT_LT(0, defers[1]);
+    EXPECT_LT(batches[1], batches[0]);
+}
+
 TEST_F(BgpConfigTest, Instances2) {
     string content = FileRead("src/bgp/testdata/config_test_6.xml");
     EXPECT_TRUE(parser_.Parse(content));
@@ -339,6 +339,58 @@ protected:
         return total;
     }
 
+    uint64_t VerifyTreeNotifyCount(McastTreeManager *tm) {
+        uint64_t total = 0;
+        for (int idx = 0; idx < DB::PartitionCount(); idx++) {
+            total += tm->partitions_[idx]->notify_count_;
+        }
+
+        return total;
+    }
+
+    McastSGEntry *FindSGEntry(McastTreeManager *tm, string group_str) {
+        boost::system::error_code ec;
+        Ip4Address group = Ip4Address::from_string(group_str.c_str(), ec);
+        Ip4Address source = Ip4Address::from_string("0.0.0.0", ec);
+        for (McastTreeManager::PartitionList::iterator it =
+                tm->partitions_.begin();
+             it != tm->partitions_.end(); ++it) {
+            McastSGEntry *sg_entry = (*it)->FindSGEntry(group, source);
+            if (sg_entry)
+                return sg_entry;
+        }
+        return NULL;
+    }
+
+    // Verify that the links of all forwarders form a tree and return the
+    // labels of the forwarders, keyed by route distinguisher.
+    map<string, uint32_t> VerifyTreeLinks(McastTreeManager *tm,
+            string group_str) {
+        map<string, uint32_t> labels;
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        EXPECT_TRUE(sg_entry != NULL);
+        if (!sg_entry)
+            return labels;
+
+        size_t link_count = 0;
+        for (McastSGEntry::ForwarderSet::iterator it =
+             sg_entry->forwarders_.begin();
+             it != sg_entry->forwarders_.end(); ++it) {
+            McastForwarder *forwarder = *it;
+            for (McastForwarderList::iterator link_it =
+                 forwarder->tree_links_.begin();
+                 link_it != forwarder->tree_links_.end(); ++link_it) {
+                EXPECT_TRUE((*link_it)->FindLink(forwarder) != NULL);
+            }
+            link_count += forwarder->tree_links_.size();
+            labels.insert(make_pair(
+                forwarder->route_distinguisher().ToString(),
+                forwarder->label()));
+        }
+        EXPECT_EQ(2 * (sg_entry->forwarders_.size() - 1), link_count);
+        return labels;
+    }
+
     EventManager evm_;
     BgpServer server_;
     InetMcastTable *red_table_;
@@ -683,6 +735,59 @@ TEST_F(BgpMulticastTest, TreeUpdateCompression) {
     TASK_UTIL_EXPECT_EQ(2, VerifyTreeUpdateCount(red_tm_));
 }
 
+//
+// Each forwarder in turn leaves and rejoins the tree. Only the routes of the
+// forwarders adjacent to the changed slots should be notified, and all other
+// forwarders should keep their labels.
+//
+TEST_F(BgpMulticastTest, TreeChurn) {
+    AddRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+
+    uint64_t leave_notify_count = 0, join_notify_count = 0;
+    for (int idx = 0; idx < kPeerCount; idx++) {
+        string rd = peers_[idx]->ToString() + ":65535";
+        map<string, uint32_t> labels =
+            VerifyTreeLinks(red_tm_, "192.168.1.255");
+        uint64_t notify_count = VerifyTreeNotifyCount(red_tm_);
+
+        peers_[idx]->DelRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount - 1);
+        uint64_t leave_count = VerifyTreeNotifyCount(red_tm_) - notify_count;
+        EXPECT_LE(leave_count, uint64_t(McastTreeManager::kDegree + 3));
+        leave_notify_count += leave_count;
+
+        map<string, uint32_t> leave_labels =
+            VerifyTreeLinks(red_tm_, "192.168.1.255");
+        labels.erase(rd);
+        EXPECT_TRUE(labels == leave_labels);
+
+        notify_count = VerifyTreeNotifyCount(red_tm_);
+        peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+        uint64_t join_count = VerifyTreeNotifyCount(red_tm_) - notify_count;
+        EXPECT_EQ(2U, join_count);
+        join_notify_count += join_count;
+
+        map<string, uint32_t> join_labels =
+            VerifyTreeLinks(red_tm_, "192.168.1.255");
+        join_labels.erase(rd);
+        EXPECT_TRUE(labels == join_labels);
+    }
+
+    LOG(DEBUG, "Tree of " << kPeerCount << " forwarders: "
+        << leave_notify_count << " notifications for " << kPeerCount
+        << " leaves, " << join_notify_count << " notifications for "
+        << kPeerCount << " joins");
+
+    DelRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifySGCount(red_tm_, 0);
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
@@ -947,6 +947,127 @@ TEST_F(ReplicationTest, ConnectNetwork) {
     VERIFY_EQ(0, RouteCount("green"));
 }
 
+// Routes with the same targets share the cached list of destination tables
+TEST_F(ReplicationTest, FanoutCache) {
+    vector<string> instance_names = list_of("blue")("red")("green");
+    multimap<string, string> connections = map_list_of("blue", "red");
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    RoutePathReplicator *replicator =
+        bgp_server_->replicator(Address::INETVPN);
+    uint64_t hits = replicator->fanout_cache_hits();
+    uint64_t misses = replicator->fanout_cache_misses();
+
+    // VPN routes with target "blue".
+    static const int kRouteCount = 64;
+    for (int i = 0; i < kRouteCount; i++) {
+        ostringstream prefix;
+        prefix << "192.168.0.1:1:10.0.1." << i << "/32";
+        AddVPNRoute(peers_[0], prefix.str(), 100, list_of("blue"));
+    }
+    task_util::WaitForIdle();
+    VERIFY_EQ(kRouteCount, RouteCount("blue"));
+    VERIFY_EQ(kRouteCount, RouteCount("red"));
+
+    // At most one miss per partition.
+    uint64_t new_misses = replicator->fanout_cache_misses() - misses;
+    uint64_t new_hits = replicator->fanout_cache_hits() - hits;
+    EXPECT_LE(new_misses, (uint64_t) DB::PartitionCount());
+    EXPECT_GE(new_hits + new_misses, (uint64_t) kRouteCount);
+
+    // A new connection flushes the cache and the routes are imported.
+    uint64_t generation = replicator->fanout_cache_generation();
+    ifmap_test_util::IFMapMsgLink(&config_db_,
+                                    "routing-instance", "blue",
+                                    "routing-instance", "green",
+                                    "connection");
+    task_util::WaitForIdle();
+    EXPECT_LT(generation, replicator->fanout_cache_generation());
+    VERIFY_EQ(kRouteCount, RouteCount("green"));
+
+    for (int i = 0; i < kRouteCount; i++) {
+        ostringstream prefix;
+        prefix << "192.168.0.1:1:10.0.1." << i << "/32";
+        DeleteVPNRoute(peers_[0], prefix.str());
+    }
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("blue"));
+    VERIFY_EQ(0, RouteCount("red"));
+    VERIFY_EQ(0, RouteCount("green"));
+}
+
+// Scale: a route with one target is imported in 1000 instances
+TEST_F(ReplicationTest, ScaleImport) {
+    static const int kInstanceCount = 1000;
+    vector<string> instance_names = list_of("blue");
+    multimap<string, string> connections;
+    for (int i = 0; i < kInstanceCount; i++) {
+        ostringstream name;
+        name << "vrf" << i;
+        instance_names.push_back(name.str());
+        connections.insert(make_pair(string("blue"), name.str()));
+    }
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    uint64_t start = UTCTimestampUsec();
+    AddVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.1/32", 100, list_of("blue"));
+    task_util::WaitForIdle();
+    uint64_t add_usec = UTCTimestampUsec() - start;
+
+    VERIFY_EQ(1, RouteCount("blue"));
+    for (int i = 1; i <= kInstanceCount; i++) {
+        VERIFY_EQ(1, RouteCount(instance_names[i]));
+    }
+
+    // One secondary path per importing instance, all with the same attr.
+    BgpRoute *rt = VPNRouteLookup("192.168.0.1:1:10.0.1.1/32");
+    ASSERT_TRUE(rt != NULL);
+    BgpTable *table = static_cast<BgpTable *>(
+        bgp_server_->database()->FindTable("bgp.l3vpn.0"));
+    const RtReplicated *rts =
+        bgp_server_->replicator(Address::INETVPN)->GetReplicationState(
+            table, rt);
+    ASSERT_TRUE(rts != NULL);
+    EXPECT_EQ(kInstanceCount + 1U, rts->GetList().size());
+    BgpRoute *rt_first = InetRouteLookup(instance_names[1], "10.0.1.1/32");
+    BgpRoute *rt_last =
+        InetRouteLookup(instance_names[kInstanceCount], "10.0.1.1/32");
+    ASSERT_TRUE(rt_first != NULL && rt_last != NULL);
+    EXPECT_EQ(rt_first->BestPath()->GetAttr(), rt_last->BestPath()->GetAttr());
+
+    // Update the secondary paths
+    start = UTCTimestampUsec();
+    AddVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.1/32", 200, list_of("blue"));
+    task_util::WaitForIdle();
+    uint64_t update_usec = UTCTimestampUsec() - start;
+    VERIFY_EQ(200,
+        InetRouteLookup(instance_names[kInstanceCount], "10.0.1.1/32")->
+            BestPath()->GetAttr()->local_pref());
+
+    start = UTCTimestampUsec();
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.1/32");
+    task_util::WaitForIdle();
+    uint64_t delete_usec = UTCTimestampUsec() - start;
+    VERIFY_EQ(0, RouteCount("blue"));
+    for (int i = 1; i <= kInstanceCount; i++) {
+        VERIFY_EQ(0, RouteCount(instance_names[i]));
+    }
+
+    LOG(DEBUG, "Replication to " << kInstanceCount << " instances: add "
+        << add_usec << " usec, update " << update_usec << " usec, delete "
+        << delete_usec << " usec");
+}
+
 TEST_F(ReplicationTest, DeleteNetwork) {
     vector<string> instance_names = list_of("blue")("red")("green");
     multimap<string, string> connections = map_list_of("blue", "red");
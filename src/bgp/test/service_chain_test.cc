@@ -3301,6 +3301,97 @@ TEST_P(ServiceChainParamTest, DeleteConnectedWithExtConnectRoute) {
 INSTANTIATE_TEST_CASE_P(Instance, ServiceChainParamTest,
         ::testing::Combine(::testing::Bool(), ::testing::Bool()));
 
+//
+// The aggregate index returns the longest aggregate that is strictly less
+// specific than the prefix.
+//
+TEST(ServiceChainAggregateTest, NestedAggregates) {
+    vector<string> subnets = list_of("10.0.0.0/8")("10.1.0.0/16")
+        ("10.1.1.0/24")("192.168.1.0/24");
+    ServiceChainPtr chain(new ServiceChain(NULL, NULL, subnets, IpAddress()));
+    ServiceChain *info = static_cast<ServiceChain *>(chain.get());
+
+    Ip4Prefix match;
+    EXPECT_TRUE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("10.1.1.1/32"), &match));
+    EXPECT_EQ("10.1.1.0/24", match.ToString());
+    EXPECT_TRUE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("10.1.1.0/24"), &match));
+    EXPECT_EQ("10.1.0.0/16", match.ToString());
+    EXPECT_TRUE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("10.1.2.0/25"), &match));
+    EXPECT_EQ("10.1.0.0/16", match.ToString());
+    EXPECT_TRUE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("10.2.0.1/32"), &match));
+    EXPECT_EQ("10.0.0.0/8", match.ToString());
+    EXPECT_TRUE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("192.168.1.128/25"), &match));
+    EXPECT_EQ("192.168.1.0/24", match.ToString());
+
+    EXPECT_FALSE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("10.0.0.0/8"), &match));
+    EXPECT_FALSE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("10.0.0.0/7"), &match));
+    EXPECT_FALSE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("192.168.2.1/32"), &match));
+    EXPECT_FALSE(info->FindAggregateMatch(
+        Ip4Prefix::FromString("0.0.0.0/0"), &match));
+}
+
+//
+// Compare the aggregate index with a linear scan of 10K aggregates.
+//
+TEST(ServiceChainAggregateTest, Scale) {
+    static const int kAggregateCount = 10 * 1024;
+    static const int kLookupCount = 20 * 1000;
+
+    vector<string> subnets;
+    vector<Ip4Prefix> aggregates;
+    for (int i = 0; i < kAggregateCount; i++) {
+        ostringstream oss;
+        oss << "10." << (i / 256) << "." << (i % 256) << ".0/24";
+        subnets.push_back(oss.str());
+        aggregates.push_back(Ip4Prefix::FromString(oss.str()));
+    }
+    ServiceChainPtr chain(new ServiceChain(NULL, NULL, subnets, IpAddress()));
+    ServiceChain *info = static_cast<ServiceChain *>(chain.get());
+
+    // Every other lookup falls outside the aggregates
+    vector<Ip4Prefix> prefixes;
+    for (int i = 0; i < kLookupCount; i++) {
+        uint32_t subnet = (i / 2) % kAggregateCount + (i % 2) * kAggregateCount;
+        uint32_t addr = (10 << 24) + subnet * 256 + i % 256;
+        prefixes.push_back(Ip4Prefix(Ip4Address(addr), 32));
+    }
+
+    int tree_matches = 0;
+    uint64_t start = UTCTimestampUsec();
+    BOOST_FOREACH(const Ip4Prefix &prefix, prefixes) {
+        Ip4Prefix match;
+        if (info->FindAggregateMatch(prefix, &match))
+            tree_matches++;
+    }
+    uint64_t tree_usec = UTCTimestampUsec() - start;
+
+    int scan_matches = 0;
+    start = UTCTimestampUsec();
+    BOOST_FOREACH(const Ip4Prefix &prefix, prefixes) {
+        BOOST_FOREACH(const Ip4Prefix &aggregate, aggregates) {
+            if (prefix.IsMoreSpecific(aggregate)) {
+                scan_matches++;
+                break;
+            }
+        }
+    }
+    uint64_t scan_usec = UTCTimestampUsec() - start;
+
+    EXPECT_EQ(kLookupCount / 2, tree_matches);
+    EXPECT_EQ(scan_matches, tree_matches);
+    LOG(DEBUG, kLookupCount << " lookups in " << kAggregateCount
+        << " aggregates: index " << tree_usec << " usec, linear scan "
+        << scan_usec << " usec");
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "io/tcp_buffer_pool.h"
+
+using tbb::mutex;
+
+TcpBufferPool::TcpBufferPool() {
+}
+
+TcpBufferPool::~TcpBufferPool() {
+    for (int i = 0; i < kSizeClasses; i++) {
+        for (size_t j = 0; j < free_list_[i].size(); j++) {
+            delete[] free_list_[i][j];
+        }
+    }
+}
+
+// Returns the free list index for a buffer size, or -1 if buffers of this
+// size are not pooled.
+int TcpBufferPool::SizeClass(size_t size) {
+    int index = 0;
+    for (size_t bufsize = kMinBufferSize; bufsize <= kMaxBufferSize;
+         bufsize <<= 1, index++) {
+        if (bufsize == size) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+uint8_t *TcpBufferPool::Alloc(size_t size, bool *reused) {
+    int index = SizeClass(size);
+    if (index >= 0) {
+        mutex::scoped_lock lock(mutex_);
+        if (!free_list_[index].empty()) {
+            uint8_t *data = free_list_[index].back();
+            free_list_[index].pop_back();
+            *reused = true;
+            return data;
+        }
+    }
+    *reused = false;
+    return new uint8_t[size];
+}
+
+void TcpBufferPool::Free(uint8_t *data, size_t size) {
+    int index = SizeClass(size);
+    if (index >= 0) {
+        mutex::scoped_lock lock(mutex_);
+        if (free_list_[index].size() < kMaxFreeBuffers) {
+            free_list_[index].push_back(data);
+            return;
+        }
+    }
+    delete[] data;
+}
+
+size_t TcpBufferPool::FreeCount() const {
+    mutex::scoped_lock lock(mutex_);
+    size_t count = 0;
+    for (int i = 0; i < kSizeClasses; i++) {
+        count += free_list_[i].size();
+    }
+    return count;
+}
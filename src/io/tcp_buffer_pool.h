@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __TCP_BUFFER_POOL_H__
+#define __TCP_BUFFER_POOL_H__
+
+#include <stdint.h>
+#include <vector>
+#include <tbb/mutex.h>
+
+#include "base/util.h"
+
+// TcpBufferPool
+//
+// Free lists of session receive buffers, one per power of two size between
+// kMinBufferSize and kMaxBufferSize. Each TcpServer owns a pool shared by
+// all of its sessions, so a buffer released by one read is reused by the
+// next instead of going back to the heap.
+class TcpBufferPool {
+public:
+    static const size_t kMinBufferSize = 4 * 1024;
+    static const size_t kMaxBufferSize = 64 * 1024;
+    static const size_t kMaxFreeBuffers = 64;
+
+    TcpBufferPool();
+    ~TcpBufferPool();
+
+    // Returns a buffer of the given size. *reused is set if the buffer came
+    // from a free list rather than the heap.
+    uint8_t *Alloc(size_t size, bool *reused);
+    void Free(uint8_t *data, size_t size);
+
+    size_t FreeCount() const;
+
+private:
+    static const int kSizeClasses = 5;
+
+    static int SizeClass(size_t size);
+
+    mutable tbb::mutex mutex_;
+    std::vector<uint8_t *> free_list_[kSizeClasses];
+
+    DISALLOW_COPY_AND_ASSIGN(TcpBufferPool);
+};
+
+#endif // __TCP_BUFFER_POOL_H__
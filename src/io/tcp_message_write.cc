@@ -14,7 +14,8 @@ using namespace boost::system;
 using tbb::mutex;
 
 TcpMessageWriter::TcpMessageWriter(Socket *socket, TcpSession *session) :
-    socket_(socket), offset_(0), session_(session) {
+    socket_(socket), offset_(0), session_(session), corked_(false),
+    blocked_(false) {
 }
 
 TcpMessageWriter::~TcpMessageWriter() {
@@ -35,7 +36,14 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
     session_->server_->stats_.write_calls++;
     session_->server_->stats_.write_bytes += len;
 
+    if (corked_) {
+        BufferAppend(data, len);
+        return len;
+    }
+
     if (buffer_queue_.empty()) {
+        session_->stats_.write_syscalls++;
+        session_->server_->stats_.write_syscalls++;
         wrote = socket_->write_some(boost::asio::buffer(data, len), ec);
         if (TcpSession::IsSocketErrorHard(ec)) return -1;
         assert(wrote >= 0);
@@ -55,7 +63,70 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
     return wrote;
 }
 
+bool TcpMessageWriter::Uncork(error_code &ec) {
+    corked_ = false;
+
+    // A blocked writer flushes the queue once the socket is writable.
+    if (blocked_) return false;
+    if (FlushQueue(ec)) return true;
+    if (TcpSession::IsSocketErrorHard(ec)) return false;
+    DeferWrite();
+    return false;
+}
+
+// Write out the queue, up to kMaxGatherBuffers buffers per write_some.
+// Returns true if the queue was fully written.
+bool TcpMessageWriter::FlushQueue(error_code &ec) {
+    std::vector<const_buffer> buffers;
+    buffers.reserve(kMaxGatherBuffers);
+
+    while (!buffer_queue_.empty()) {
+        buffers.clear();
+        size_t total = 0;
+        for (BufferQueue::iterator iter = buffer_queue_.begin();
+             iter != buffer_queue_.end() &&
+             buffers.size() < kMaxGatherBuffers; ++iter) {
+            const uint8_t *data = buffer_cast<const uint8_t *>(*iter);
+            size_t size = buffer_size(*iter);
+            if (iter == buffer_queue_.begin()) {
+                data += offset_;
+                size -= offset_;
+            }
+            buffers.push_back(const_buffer(data, size));
+            total += size;
+        }
+
+        session_->stats_.write_syscalls++;
+        session_->server_->stats_.write_syscalls++;
+        size_t wrote = socket_->write_some(buffers, ec);
+        if (TcpSession::IsSocketErrorHard(ec)) {
+            return false;
+        }
+
+        // Release the buffers that went out completely.
+        size_t remain = wrote;
+        while (remain > 0) {
+            boost::asio::mutable_buffer head = buffer_queue_.front();
+            size_t size = buffer_size(head) - offset_;
+            if (remain < size) {
+                offset_ += remain;
+                break;
+            }
+            remain -= size;
+            offset_ = 0;
+            DeleteBuffer(head);
+            buffer_queue_.pop_front();
+        }
+
+        if (wrote != total) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void TcpMessageWriter::DeferWrite() {
+    blocked_ = true;
 
     // Update socket write block count.
     session_->stats_.write_blocked++;
@@ -89,29 +160,21 @@ void TcpMessageWriter::HandleWriteReady(TcpSessionPtr session_ptr,
     //
     if (session_->IsClosedLocked()) return;
 
-    while (!buffer_queue_.empty()) {
-        boost::asio::mutable_buffer head = buffer_queue_.front();
-        const uint8_t *data = buffer_cast<const uint8_t *>(head) + offset_;
-        int remaining = buffer_size(head) - offset_;
+    blocked_ = false;
+    if (corked_) goto done;
+
+    {
         error_code ec;
-        int wrote = socket_->write_some(buffer(data, remaining), ec);
-        if (TcpSession::IsSocketErrorHard(ec)) {
-            lock.release();
-            if (!cb_.empty()) cb_(ec);
-            return;
-        }
-        assert(wrote >= 0);
-        if (wrote != remaining) {
-            offset_ += wrote;
+        if (!FlushQueue(ec)) {
+            if (TcpSession::IsSocketErrorHard(ec)) {
+                lock.release();
+                if (!cb_.empty()) cb_(ec);
+                return;
+            }
             DeferWrite();
             return;
-        } else {
-            offset_ = 0;
-            DeleteBuffer(head);
-            buffer_queue_.pop_front();
         }
     }
-    buffer_queue_.clear();
 
 done:
     lock.release();
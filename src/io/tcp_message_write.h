@@ -6,6 +6,7 @@
 #define __MESSAGE_WRITE_H__
 
 #include <list>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/asio/buffer.hpp>
@@ -22,12 +23,21 @@ class TcpMessageWriter {
 public:
     typedef boost::asio::ip::tcp::socket Socket;
     static const int kDefaultBufferSize = 4 * 1024;
+    // Maximum number of buffers passed to a single gather write.
+    static const size_t kMaxGatherBuffers = 64;
     explicit TcpMessageWriter(Socket *, TcpSession *session);
     ~TcpMessageWriter();
 
     // return false for send  
     int Send(const uint8_t *msg, size_t len, error_code &ec);
 
+    // While corked, Send queues messages without writing them. Uncork
+    // writes the queue with gather writes. Returns false if the socket
+    // blocked or failed.
+    void Cork() { corked_ = true; }
+    bool Uncork(error_code &ec);
+    bool IsCorked() const { return corked_; }
+
     typedef boost::function<void(const error_code &ec)> SendReadyCb;
     void RegisterNotification(SendReadyCb);
 
@@ -37,6 +47,7 @@ private:
     void BufferAppend(const uint8_t *data, int len);
     void DeleteBuffer(boost::asio::mutable_buffer buffer); 
     void DeferWrite();
+    bool FlushQueue(error_code &ec);
     void HandleWriteReady(TcpSessionPtr session_ref, const error_code &ec,
                           uint64_t block_start_time);
 
@@ -45,6 +56,8 @@ private:
     Socket *socket_;
     int offset_;
     TcpSession *session_;
+    bool corked_;
+    bool blocked_;
 };
 
 #endif
@@ -16,6 +16,7 @@
 #endif
 
 #include "base/util.h"
+#include "io/tcp_buffer_pool.h"
 
 class EventManager;
 class TcpSession;
@@ -63,6 +64,10 @@ class TcpServer {
             write_bytes = 0;
             write_blocked = 0;
             write_blocked_duration_usecs = 0;
+            write_syscalls = 0;
+            read_buffer_allocs = 0;
+            read_buffer_reuses = 0;
+            read_msg_concats = 0;
         }
 
         tbb::atomic<uint64_t> read_calls;
@@ -71,6 +76,18 @@ class TcpServer {
         tbb::atomic<uint64_t> write_bytes;
         tbb::atomic<uint64_t> write_blocked;
         tbb::atomic<uint64_t> write_blocked_duration_usecs;
+        // Socket write system calls, each possibly covering many messages.
+        tbb::atomic<uint64_t> write_syscalls;
+        // Receive buffers allocated from the heap and from the pool.
+        tbb::atomic<uint64_t> read_buffer_allocs;
+        tbb::atomic<uint64_t> read_buffer_reuses;
+        // Messages copied together from more than one receive buffer.
+        tbb::atomic<uint64_t> read_msg_concats;
+
+        double WriteSyscallsPerKB() const {
+            if (write_bytes == 0) return 0;
+            return (write_syscalls * 1024.0) / write_bytes;
+        }
     };
     const SocketStats &GetSocketStats() const { return stats_; }
 
@@ -82,6 +99,7 @@ class TcpServer {
     }
 
     EventManager *event_manager() { return evm_; }
+    TcpBufferPool *buffer_pool() { return &buffer_pool_; }
 
     // Returns true if any of the sessions on this server has read available
     // data.
@@ -111,6 +129,7 @@ class TcpServer {
   private:
     friend class TcpSession;
     friend class TcpMessageWriter;
+    friend class TcpMessageReader;
     friend void intrusive_ptr_add_ref(TcpServer *server);
     friend void intrusive_ptr_release(TcpServer *server);
     typedef boost::intrusive_ptr<TcpServer> TcpServerPtr;
@@ -138,6 +157,7 @@ class TcpServer {
     void SetName(Endpoint local_endpoint);
 
     SocketStats stats_;
+    TcpBufferPool buffer_pool_;
     EventManager *evm_;
     // mutex protects the session maps
     mutable tbb::mutex mutex_;
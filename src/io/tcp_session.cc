@@ -50,12 +50,14 @@ TcpSession::TcpSession(
     : server_(server),
       socket_(socket),
       read_on_connect_(async_read_ready),
-      buffer_size_(kDefaultBufferSize),
       established_(false),
       closed_(false),
       direction_(ACTIVE),
+      defer_reader_(false),
+      reader_stopped_(false),
       writer_(new TcpMessageWriter(socket, this)) {
     refcount_ = 0;
+    buffer_size_ = kDefaultBufferSize;
     writer_->RegisterNotification(
                  boost::bind(&TcpSession::WriteReadyInternal, this, _1));
     if (reader_task_id_ == -1) {
@@ -75,8 +77,25 @@ TcpSession::~TcpSession() {
 }
 
 mutable_buffer TcpSession::AllocateBuffer() {
-    u_int8_t *data = new u_int8_t[buffer_size_];
-    mutable_buffer buffer = mutable_buffer(data, buffer_size_);
+    int size = buffer_size_;
+
+    u_int8_t *data;
+    if (server_) {
+        bool reused;
+        data = server_->buffer_pool()->Alloc(size, &reused);
+        if (reused) {
+            stats_.read_buffer_reuses++;
+            server_->stats_.read_buffer_reuses++;
+        } else {
+            stats_.read_buffer_allocs++;
+            server_->stats_.read_buffer_allocs++;
+        }
+    } else {
+        data = new u_int8_t[size];
+        stats_.read_buffer_allocs++;
+    }
+
+    mutable_buffer buffer = mutable_buffer(data, size);
     {
         mutex::scoped_lock lock(mutex_);
         buffer_queue_.push_back(buffer);
@@ -84,6 +103,18 @@ mutable_buffer TcpSession::AllocateBuffer() {
     return buffer;
 }
 
+// Return a buffer to the server pool.
+void TcpSession::RecycleBuffer(mutable_buffer buffer) {
+    if (server_ == NULL) {
+        DeleteBuffer(buffer);
+        return;
+    }
+    server_->buffer_pool()->Free(buffer_cast<uint8_t *>(buffer),
+                                 buffer_size(buffer));
+}
+
+// Buffers still queued when the session is destroyed bypass the pool, as
+// the server may already be gone.
 void TcpSession::DeleteBuffer(mutable_buffer buffer) {
     uint8_t *data = buffer_cast<uint8_t *>(buffer);
     delete[] data;
@@ -110,7 +141,7 @@ void TcpSession::ReleaseBufferLocked(Buffer buffer) {
     for (BufferQueue::iterator iter = buffer_queue_.begin();
          iter != buffer_queue_.end(); ++iter) {
         if (BufferCmp(*iter, buffer) == 0) {
-            DeleteBuffer(*iter);
+            RecycleBuffer(*iter);
             buffer_queue_.erase(iter);
             return;
         }
@@ -125,11 +156,28 @@ void TcpSession::AsyncReadStart() {
         ReleaseBufferLocked(buffer);
         return;
     }
+    if (defer_reader_) {
+        reader_stopped_ = true;
+        ReleaseBufferLocked(buffer);
+        return;
+    }
     socket_->async_read_some(mutable_buffers_1(buffer),
         boost::bind(&TcpSession::AsyncReadHandler, TcpSessionPtr(this), buffer,
                     placeholders::error, placeholders::bytes_transferred));
 }
 
+void TcpSession::SetDeferReader(bool defer_reader) {
+    mutex::scoped_lock lock(mutex_);
+    defer_reader_ = defer_reader;
+    if (defer_reader_ || !reader_stopped_) {
+        return;
+    }
+    // No read is outstanding while the reader is stopped, restart it.
+    reader_stopped_ = false;
+    lock.release();
+    AsyncReadStart();
+}
+
 TcpSession::Endpoint TcpSession::local_endpoint() const {
     mutex::scoped_lock lock(mutex_);
     if (!established_) {
@@ -296,6 +344,28 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
     return ret;
 }
 
+void TcpSession::Cork() {
+    mutex::scoped_lock lock(mutex_);
+    writer_->Cork();
+}
+
+bool TcpSession::Uncork() {
+    mutex::scoped_lock lock(mutex_);
+    if (!established_) return false;
+
+    boost::system::error_code error;
+    bool ready = writer_->Uncork(error);
+    if (IsSocketErrorHard(error)) {
+        lock.release();
+        TCP_SESSION_LOG_INFO(this, TCP_DIR_OUT,
+            "Write failed due to error: " << error.category().name() << " "
+                                          << error.message());
+        CloseInternal(true);
+        return false;
+    }
+    return ready;
+}
+
 void TcpSession::AsyncReadHandler(
     TcpSessionPtr session, mutable_buffer buffer,
     const boost::system::error_code &error, size_t bytes_transferred) {
@@ -322,6 +392,12 @@ void TcpSession::AsyncReadHandler(
     session->server_->stats_.read_calls++;
     session->server_->stats_.read_bytes += bytes_transferred;
 
+    // Grow the receive buffer while reads fill it completely.
+    if (bytes_transferred == buffer_size(buffer) &&
+        session->buffer_size_ < kMaxBufferSize) {
+        session->buffer_size_ = session->buffer_size_ * 2;
+    }
+
     Buffer rdbuf(buffer_cast<const uint8_t *>(buffer), bytes_transferred);
     Reader *task = new Reader(
         session, boost::bind(&TcpSession::OnRead, session.get(), _1), rdbuf);
@@ -361,7 +437,8 @@ int32_t TcpSession::remote_port() const {
 
 TcpMessageReader::TcpMessageReader(TcpSession *session, 
                                    ReceiveCallback callback)
-    : session_(session), callback_(callback), offset_(0), remain_(-1) {
+    : session_(session), callback_(callback), offset_(0), remain_(-1),
+      concat_buf_size_(0) {
 }
 
 TcpMessageReader::~TcpMessageReader() {
@@ -404,6 +481,19 @@ uint8_t *TcpMessageReader::BufferConcat(uint8_t *data, Buffer buffer,
     return data;
 }
 
+// Returns a buffer of at least msglength bytes, kept across messages.
+uint8_t *TcpMessageReader::ConcatBuffer(int msglength) {
+    if (concat_buf_size_ < msglength) {
+        concat_buf_size_ = AllocBufferSize(msglength);
+        concat_buf_.reset(new uint8_t[concat_buf_size_]);
+    }
+    session_->stats_.read_msg_concats++;
+    if (session_->server_) {
+        session_->server_->stats_.read_msg_concats++;
+    }
+    return concat_buf_.get();
+}
+
 int TcpMessageReader::QueueByteLength() const {
     int total = 0;
     for (BufferQueue::const_iterator iter = queue_.begin();
@@ -487,12 +577,11 @@ void TcpMessageReader::OnRead(Buffer buffer) {
         }
 
         // concat the buffers into a contiguous message.
-        boost::scoped_array<uint8_t>
-            data(new uint8_t[AllocBufferSize(msglength)]);
-        BufferConcat(data.get(), buffer, msglength);
+        uint8_t *data = ConcatBuffer(msglength);
+        BufferConcat(data, buffer, msglength);
         assert(remain_ == -1);
         // Receive the message
-        callback_(data.get(), msglength);
+        callback_(data, msglength);
     }
 
     int avail = size - offset_;
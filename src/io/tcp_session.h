@@ -13,8 +13,10 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/function.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include <tbb/task.h>
 #ifndef _LIBCPP_VERSION
@@ -36,6 +38,9 @@ class TcpMessageWriter;
 class TcpSession {
   public:
     static const int kDefaultBufferSize = 4 * 1024;
+    // Receive buffers double in size, up to this limit, while reads keep
+    // filling them.
+    static const int kMaxBufferSize = 64 * 1024;
 
     enum Event {
         EVENT_NONE,
@@ -59,6 +64,13 @@ class TcpSession {
     // Performs a non-blocking send operation.
     virtual bool Send(const u_int8_t *data, size_t size, size_t *sent);
 
+    // Messages sent while the session is corked are queued and written
+    // together, with as few gather writes as possible, by Uncork. Uncork
+    // returns false if the socket is blocked, in which case WriteReady is
+    // invoked once the queue drains.
+    void Cork();
+    bool Uncork();
+
     // Called by TcpServer to trigger async read.
     virtual bool Connected(Endpoint remote);
     
@@ -128,6 +140,15 @@ class TcpSession {
 
     void AsyncReadStart();
 
+    // While the reader is deferred, no new read is started after the
+    // current buffer is handed to OnRead. Clearing the deferral restarts
+    // the reader if it had stopped.
+    void SetDeferReader(bool defer_reader);
+    bool IsReaderDeferred() const {
+        tbb::mutex::scoped_lock lock(mutex_);
+        return defer_reader_;
+    }
+
     const TcpServer::SocketStats &GetSocketStats() const { return stats_; }
 
   protected:
@@ -146,6 +167,7 @@ class TcpSession {
     typedef boost::intrusive_ptr<TcpSession> TcpSessionPtr;
     friend class TcpServer;
     friend class TcpMessageWriter;
+    friend class TcpMessageReader;
     friend void intrusive_ptr_add_ref(TcpSession *session);
     friend void intrusive_ptr_release(TcpSession *session);
     typedef std::list<boost::asio::mutable_buffer> BufferQueue;
@@ -171,6 +193,7 @@ class TcpSession {
     void SetName();
 
     boost::asio::mutable_buffer AllocateBuffer();
+    void RecycleBuffer(boost::asio::mutable_buffer buffer);
     void DeleteBuffer(boost::asio::mutable_buffer buffer);
     void WriteReadyInternal(const boost::system::error_code &);
 
@@ -179,7 +202,9 @@ class TcpSession {
     TcpServer *server_;
     boost::scoped_ptr<Socket> socket_;
     bool read_on_connect_;
-    int buffer_size_;
+    // Size of the next receive buffer. Only grown from the read handler,
+    // and atomic so that AllocateBuffer can read it without the mutex_.
+    tbb::atomic<int> buffer_size_;
 
     // Protects session state and buffer queue.
     mutable tbb::mutex mutex_;
@@ -190,6 +215,8 @@ class TcpSession {
     Endpoint remote_;           // Remote end-point
     Direction direction_;       // direction (active, passive)
     BufferQueue buffer_queue_;
+    bool defer_reader_;         // Do not start new reads.
+    bool reader_stopped_;       // A read was skipped due to defer_reader_.
     /**************** end protected by mutex_ ****************/
 
     // Protects observer manipulation and invocation. When this lock is
@@ -241,6 +268,7 @@ private:
 
     // Copy the queue into one contiguous buffer.
     uint8_t *BufferConcat(uint8_t *data, Buffer buffer, int msglength);
+    uint8_t *ConcatBuffer(int msglength);
 
     int QueueByteLength() const;
 
@@ -253,6 +281,9 @@ private:
     BufferQueue queue_;
     int offset_;
     int remain_;
+    // Reused for messages that span receive buffers.
+    boost::scoped_array<uint8_t> concat_buf_;
+    int concat_buf_size_;
 
     DISALLOW_COPY_AND_ASSIGN(TcpMessageReader);
 };
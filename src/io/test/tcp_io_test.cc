@@ -21,6 +21,8 @@
 #include "base/test/task_test_util.h"
 
 #include "io/event_manager.h"
+#include "io/tcp_buffer_pool.h"
+#include "io/tcp_message_write.h"
 #include "io/tcp_server.h"
 #include "io/tcp_session.h"
 #include "io/test/event_manager_test.h"
@@ -37,6 +39,7 @@ class EchoSession : public TcpSession {
     EchoSession(EchoServer *server, Socket *socket);
     int GetTotal() const { return total_; }
     void ResetTotal() { total_ = 0; }
+    void set_release(bool release) { release_ = release; }
     virtual void WriteReady(const boost::system::error_code &error) {
         called = true;
     }
@@ -51,6 +54,9 @@ class EchoSession : public TcpSession {
         const size_t len = BufferSize(buffer);
         TCP_UT_LOG_DEBUG("Received " << len << " bytes");
         total_ += len;
+        if (release_) {
+            ReleaseBuffer(buffer);
+        }
     }
   private:
     void OnEvent(TcpSession *session, Event event) {
@@ -71,6 +77,7 @@ class EchoSession : public TcpSession {
         }
     }
     int total_;
+    bool release_;
 };
 
 class EchoServer : public TcpServer {
@@ -112,7 +119,7 @@ private:
 };
 
 EchoSession::EchoSession(EchoServer *server, Socket *socket)
-    : TcpSession(server, socket), called(false), total_(0) {
+    : TcpSession(server, socket), called(false), total_(0), release_(false) {
     set_observer(boost::bind(&EchoSession::OnEvent, this, _1, _2));
 }
 
@@ -315,6 +322,113 @@ TEST_F(EchoServerTest, SendAfterClose) {
     TASK_UTIL_ASSERT_NE(0, server_->GetSession()->GetTotal());
 }
 
+// Released receive buffers are reused by later reads.
+TEST_F(EchoServerTest, BufferReuse) {
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+
+    client_->CreateSession();
+    client_->EchoServer::ConnectTest(port);
+
+    TASK_UTIL_ASSERT_TRUE((server_->GetSession() != NULL));
+    TASK_UTIL_ASSERT_TRUE(client_->GetSession()->IsEstablished());
+    server_->GetSession()->set_release(true);
+
+    char msg[4096];
+    memset(msg, 0xcd, sizeof(msg));
+    int total = 0;
+    for (int i = 0; i < 256; i++) {
+        size_t sent = 0;
+        client_->Send((const u_int8_t *) msg, sizeof(msg), &sent);
+        total += sent;
+        TASK_UTIL_ASSERT_EQ(total, server_->GetSession()->GetTotal());
+    }
+
+    const TcpServer::SocketStats &stats =
+        server_->GetSession()->GetSocketStats();
+    uint64_t reads = stats.read_calls;
+    uint64_t allocs = stats.read_buffer_allocs;
+    uint64_t reuses = stats.read_buffer_reuses;
+    TCP_UT_LOG_DEBUG("Reads: " << reads << " allocs: " << allocs
+                     << " reuses: " << reuses);
+    EXPECT_LT(0U, reuses);
+    EXPECT_GT(reads, allocs);
+}
+
+// Messages sent while corked go out in a few gather writes.
+TEST_F(EchoServerTest, Cork) {
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+
+    client_->CreateSession();
+    client_->EchoServer::ConnectTest(port);
+    client_->SetSocketOptions();
+
+    TASK_UTIL_ASSERT_TRUE((server_->GetSession() != NULL));
+    TASK_UTIL_ASSERT_TRUE(client_->GetSession()->IsEstablished());
+
+    const TcpServer::SocketStats &stats =
+        client_->GetSession()->GetSocketStats();
+    char msg[100];
+    memset(msg, 0xcd, sizeof(msg));
+    client_->GetSession()->Cork();
+    for (int i = 0; i < 200; i++) {
+        size_t sent = 0;
+        EXPECT_TRUE(client_->Send((const u_int8_t *) msg, sizeof(msg), &sent));
+        EXPECT_EQ(sizeof(msg), sent);
+    }
+    uint64_t syscalls = stats.write_syscalls;
+    EXPECT_EQ(0U, syscalls);
+
+    EXPECT_TRUE(client_->GetSession()->Uncork());
+    TASK_UTIL_ASSERT_EQ(200 * (int) sizeof(msg),
+                        server_->GetSession()->GetTotal());
+    syscalls = stats.write_syscalls;
+    EXPECT_GE(200U / TcpMessageWriter::kMaxGatherBuffers + 1, syscalls);
+    TCP_UT_LOG_DEBUG("Write syscalls per KB: " << stats.WriteSyscallsPerKB());
+}
+
+TEST(TcpBufferPoolTest, Basic) {
+    TcpBufferPool pool;
+    bool reused;
+
+    uint8_t *data = pool.Alloc(TcpBufferPool::kMinBufferSize, &reused);
+    EXPECT_FALSE(reused);
+    pool.Free(data, TcpBufferPool::kMinBufferSize);
+    EXPECT_EQ(1U, pool.FreeCount());
+
+    // Buffers are only reused for the same size
+    uint8_t *data2 = pool.Alloc(TcpBufferPool::kMinBufferSize * 2, &reused);
+    EXPECT_FALSE(reused);
+    EXPECT_EQ(data, pool.Alloc(TcpBufferPool::kMinBufferSize, &reused));
+    EXPECT_TRUE(reused);
+    pool.Free(data, TcpBufferPool::kMinBufferSize);
+    pool.Free(data2, TcpBufferPool::kMinBufferSize * 2);
+    EXPECT_EQ(2U, pool.FreeCount());
+
+    // Sizes outside the pool go to the heap
+    data = pool.Alloc(100, &reused);
+    EXPECT_FALSE(reused);
+    pool.Free(data, 100);
+    EXPECT_EQ(2U, pool.FreeCount());
+
+    // Free lists are bounded
+    vector<uint8_t *> list;
+    for (size_t i = 0; i < TcpBufferPool::kMaxFreeBuffers + 8; i++) {
+        list.push_back(pool.Alloc(TcpBufferPool::kMaxBufferSize, &reused));
+    }
+    for (size_t i = 0; i < list.size(); i++) {
+        pool.Free(list[i], TcpBufferPool::kMaxBufferSize);
+    }
+    EXPECT_EQ(TcpBufferPool::kMaxFreeBuffers + 2, pool.FreeCount());
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
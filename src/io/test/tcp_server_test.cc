@@ -221,6 +221,46 @@ TEST_F(EchoServerTest, Basic) {
     client.Close();
 }
 
+TEST_F(EchoServerTest, DeferReader) {
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();		// Must be called after initialization
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+    TcpLocalClient client(port);
+    TASK_UTIL_EXPECT_TRUE(client.Connect());
+    TASK_UTIL_EXPECT_TRUE(server_->GetSession() != NULL);
+    EchoSession *session = server_->GetSession();
+    TASK_UTIL_EXPECT_TRUE(session->IsEstablished());
+
+    // The read outstanding when the reader is deferred still completes
+    session->SetDeferReader(true);
+    EXPECT_TRUE(session->IsReaderDeferred());
+    const char msg[] = "Test Message";
+    int len = client.Send((const u_int8_t *) msg, sizeof(msg));
+    TASK_UTIL_EXPECT_EQ((int) sizeof(msg), len);
+    u_int8_t data[1024];
+    int rlen = client.Recv(data, sizeof(data));
+    TASK_UTIL_EXPECT_EQ(len, rlen);
+    TASK_UTIL_EXPECT_EQ(1U, session->GetSocketStats().read_calls);
+
+    // No new read is started until the deferral is cleared
+    len = client.Send((const u_int8_t *) msg, sizeof(msg));
+    TASK_UTIL_EXPECT_EQ((int) sizeof(msg), len);
+    usleep(100000);
+    task_util::WaitForIdle();
+    EXPECT_EQ(1U, session->GetSocketStats().read_calls);
+
+    session->SetDeferReader(false);
+    EXPECT_FALSE(session->IsReaderDeferred());
+    rlen = client.Recv(data, sizeof(data));
+    TASK_UTIL_EXPECT_EQ(len, rlen);
+    TASK_UTIL_EXPECT_EQ(0, memcmp(data, msg, rlen));
+    TASK_UTIL_EXPECT_EQ(2U, session->GetSocketStats().read_calls);
+
+    client.Close();
+}
+
 TEST_F(EchoServerTest, Connect) {
     EchoServer *client = new EchoServer(evm_.get());
 
@@ -48,6 +48,7 @@ AgentSandeshContext *KSyncSock::agent_sandesh_ctx_;
 std::vector<KSyncSock *> KSyncSock::sock_table_;
 pid_t KSyncSock::pid_;
 tbb::atomic<bool> KSyncSock::shutdown_;
+bool KSyncSock::bulk_mode_;
 
 const char* IoContext::io_wq_names[IoContext::MAX_WORK_QUEUES] = 
                                                 {"Agent::KSync", "Agent::Uve"};
@@ -159,6 +160,47 @@ void KSyncSockNetlink::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
     free(cl.cl_buf);
 }
 
+// Netlink messages are laid out back to back, each aligned to NLMSG_ALIGNTO,
+// as expected by netlink_rcv_skb() in the kernel
+uint32_t KSyncSockNetlink::EncodeBulkMsg(char *buf, uint32_t buf_len,
+                                         IoContext *ioc, const char *msg,
+                                         uint32_t msg_len) {
+    struct nl_client cl;
+    unsigned char *nl_buf;
+    uint32_t nl_buf_len;
+    int ret;
+
+    nl_init_generic_client_req(&cl, GetNetlinkFamilyId());
+    if ((ret = nl_build_header(&cl, &nl_buf, &nl_buf_len)) < 0) {
+        LOG(ERROR, "Error creating netlink message. Error : " << ret);
+        free(cl.cl_buf);
+        return 0;
+    }
+
+    uint32_t hdr_len = cl.cl_buf_offset;
+    uint32_t len = NLMSG_ALIGN(hdr_len + msg_len);
+    if (len > buf_len) {
+        free(cl.cl_buf);
+        return 0;
+    }
+
+    nl_update_header(&cl, msg_len);
+    struct nlmsghdr *nlh = (struct nlmsghdr *)cl.cl_buf;
+    nlh->nlmsg_pid = KSyncSock::GetPid();
+    nlh->nlmsg_seq = ioc->GetSeqno();
+
+    memcpy(buf, cl.cl_buf, hdr_len);
+    memcpy(buf + hdr_len, msg, msg_len);
+    memset(buf + hdr_len + msg_len, 0, len - (hdr_len + msg_len));
+    free(cl.cl_buf);
+    return len;
+}
+
+void KSyncSockNetlink::AsyncSendBulk(mutable_buffers_1 buf, HandlerCb cb) {
+    boost::asio::netlink::raw::endpoint ep;
+    sock_.async_send_to(buf, ep, cb);
+}
+
 size_t KSyncSockNetlink::SendTo(const_buffers_1 buf) {
     struct nl_client cl;
     unsigned char *nl_buf;
@@ -287,6 +329,11 @@ KSyncSock::KSyncSock() : tx_count_(0), err_count_(0) {
     }
     rx_buff_ = NULL;
     seqno_ = 0;
+    bulk_buf_ = NULL;
+    bulk_buf_len_ = 0;
+    bulk_flush_pending_ = false;
+    bulk_msg_count_ = 0;
+    bulk_send_count_ = 0;
 }
 
 KSyncSock::~KSyncSock() {
@@ -297,6 +344,11 @@ KSyncSock::~KSyncSock() {
         rx_buff_ = NULL;
     }
 
+    if (bulk_buf_) {
+        delete [] bulk_buf_;
+        bulk_buf_ = NULL;
+    }
+
     for(int i = 0; i < IoContext::MAX_WORK_QUEUES; i++) {
         work_queue_[i]->Shutdown();
         delete work_queue_[i];
@@ -423,6 +475,12 @@ void KSyncSock::WriteHandler(const boost::system::error_code& error,
     }
 }
 
+void KSyncSock::BulkWriteHandler(const boost::system::error_code& error,
+                                 size_t bytes_transferred, char *buf) {
+    delete [] buf;
+    WriteHandler(error, bytes_transferred);
+}
+
 KSyncSock *KSyncSock::Get(DBTablePartBase *partition) {
     int idx = partition->index();
     return sock_table_[idx];
@@ -478,12 +536,97 @@ void KSyncSock::SendAsyncImpl(int msg_len, char *msg,
         wait_tree_.insert(*ioc);
     }
 
+    if (bulk_mode_ && BulkSendAsync(msg_len, msg, ioc))
+        return;
+
     AsyncSendTo(ioc, buffer(msg, msg_len),
                 boost::bind(&KSyncSock::WriteHandler, this,
                             placeholders::error,
                             placeholders::bytes_transferred));
 }
 
+// Append a request to the bulk buffer. The buffer is sent when the next
+// request does not fit, or from io_service context when BulkFlush runs, so a
+// request is never held back longer than one io_service dispatch. Returns
+// false if the request must be sent on its own
+bool KSyncSock::BulkSendAsync(int msg_len, char *msg, IoContext *ioc) {
+    boost::asio::io_service *io = GetIoService();
+    if (io == NULL)
+        return false;
+
+    char *full_buf = NULL;
+    uint32_t full_len = 0;
+    bool post_flush = false;
+    {
+        tbb::mutex::scoped_lock lock(bulk_mutex_);
+        if (bulk_buf_ == NULL) {
+            bulk_buf_ = new char[kBufLen];
+            bulk_buf_len_ = 0;
+        }
+
+        uint32_t len = EncodeBulkMsg(bulk_buf_ + bulk_buf_len_,
+                                     kBufLen - bulk_buf_len_, ioc, msg,
+                                     msg_len);
+        if (len == 0 && bulk_buf_len_ != 0) {
+            // Buffer is full, send it and start a new one
+            full_buf = bulk_buf_;
+            full_len = bulk_buf_len_;
+            bulk_buf_ = new char[kBufLen];
+            bulk_buf_len_ = 0;
+            len = EncodeBulkMsg(bulk_buf_, kBufLen, ioc, msg, msg_len);
+        }
+
+        if (len != 0) {
+            bulk_buf_len_ += len;
+            bulk_msg_count_++;
+            if (bulk_flush_pending_ == false) {
+                bulk_flush_pending_ = true;
+                post_flush = true;
+            }
+        }
+
+        if (full_buf) {
+            BulkSendBuffer(full_buf, full_len);
+        }
+
+        if (len == 0) {
+            // Request larger than kBufLen, send it unbatched. Pending
+            // requests were flushed above to retain ordering
+            return false;
+        }
+    }
+
+    if (post_flush) {
+        io->post(boost::bind(&KSyncSock::BulkFlush, this));
+    }
+    return true;
+}
+
+void KSyncSock::BulkFlush() {
+    if (shutdown_)
+        return;
+
+    tbb::mutex::scoped_lock lock(bulk_mutex_);
+    bulk_flush_pending_ = false;
+    if (bulk_buf_ == NULL || bulk_buf_len_ == 0)
+        return;
+
+    char *buf = bulk_buf_;
+    uint32_t len = bulk_buf_len_;
+    bulk_buf_ = NULL;
+    bulk_buf_len_ = 0;
+    BulkSendBuffer(buf, len);
+}
+
+// Must be called with bulk_mutex_ held so that buffers go out in order
+void KSyncSock::BulkSendBuffer(char *buf, uint32_t len) {
+    bulk_send_count_++;
+    AsyncSendBulk(boost::asio::buffer(buf, len),
+                  boost::bind(&KSyncSock::BulkWriteHandler, this,
+                              placeholders::error,
+                              placeholders::bytes_transferred, buf));
+}
+
 KSyncIoContext::KSyncIoContext(KSyncEntry *sync_entry, int msg_len,
                                char *msg, uint32_t seqno,
                                KSyncEntry::KSyncEvent event) :
@@ -137,6 +137,18 @@ public:
     std::size_t BlockingSend(const char *msg, int msg_len);
     bool BlockingRecv();
 
+    // Bulk mode packs consecutive async requests into a single transport
+    // buffer of up to kBufLen bytes. Responses are still demultiplexed by
+    // sequence number, one per request. Off by default, the agent turns it
+    // on when ksync-bulk-mode is set in its config file. Only netlink
+    // supports it, other transports ignore it.
+    static void SetBulkMode(bool enable) {bulk_mode_ = enable;};
+    static bool GetBulkMode() {return bulk_mode_;};
+    // Flush the pending bulk buffer, if any. Invoked from io_service
+    void BulkFlush();
+    uint64_t GetBulkMsgCount() const {return bulk_msg_count_;};
+    uint64_t GetBulkSendCount() const {return bulk_send_count_;};
+
     static uint32_t GetPid() {return pid_;};
     static int GetNetlinkFamilyId() {return vnsw_netlink_family_id_;};
     static void SetNetlinkFamilyId(int id) {vnsw_netlink_family_id_ = id;};
@@ -168,11 +180,15 @@ private:
     // Write handler registered with boost::asio. Demux done based on seqno_
     void WriteHandler(const boost::system::error_code& error,
                       size_t bytes_transferred);
+    void BulkWriteHandler(const boost::system::error_code& error,
+                          size_t bytes_transferred, char *buf);
 
     bool ProcessKernelData(char *data);
     virtual bool Validate(char *data) = 0;
     bool ValidateAndEnqueue(char *data);
     void SendAsyncImpl(int msg_len, char *msg, IoContext *ioc);
+    bool BulkSendAsync(int msg_len, char *msg, IoContext *ioc);
+    void BulkSendBuffer(char *buf, uint32_t len);
 
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb) = 0;
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
@@ -180,6 +196,19 @@ private:
     virtual std::size_t SendTo(boost::asio::const_buffers_1) = 0;
     virtual void Receive(boost::asio::mutable_buffers_1) = 0;
 
+    // Transports supporting bulk mode override the methods below.
+    // EncodeBulkMsg frames a request at buf and returns the number of bytes
+    // used, or 0 if the request does not fit in buf_len.
+    virtual uint32_t EncodeBulkMsg(char *buf, uint32_t buf_len,
+                                   IoContext *ioc, const char *msg,
+                                   uint32_t msg_len) {
+        return 0;
+    }
+    virtual void AsyncSendBulk(boost::asio::mutable_buffers_1, HandlerCb) {
+        assert(0);
+    }
+    virtual boost::asio::io_service *GetIoService() {return NULL;};
+
     virtual uint32_t GetSeqno(char *data) = 0;
     Tree::iterator GetIoContext(char *data);
     virtual bool IsMoreData(char *data) = 0;
@@ -189,6 +218,7 @@ private:
     static int vnsw_netlink_family_id_;
     static AgentSandeshContext *agent_sandesh_ctx_;
     static tbb::atomic<bool> shutdown_;
+    static bool bulk_mode_;
 
     char *rx_buff_;
     tbb::atomic<int> seqno_;
@@ -198,6 +228,15 @@ private:
     int ack_count_;
     int err_count_;
 
+    // Bulk buffer being filled, protected by bulk_mutex_
+    tbb::mutex bulk_mutex_;
+    char *bulk_buf_;
+    uint32_t bulk_buf_len_;
+    bool bulk_flush_pending_;
+    // Updated under bulk_mutex_, read without it from stats and tests
+    tbb::atomic<uint64_t> bulk_msg_count_;
+    tbb::atomic<uint64_t> bulk_send_count_;
+
     DISALLOW_COPY_AND_ASSIGN(KSyncSock);
 };
 
@@ -217,6 +256,13 @@ public:
                              HandlerCb);
     virtual std::size_t SendTo(boost::asio::const_buffers_1);
     virtual void Receive(boost::asio::mutable_buffers_1);
+    virtual uint32_t EncodeBulkMsg(char *buf, uint32_t buf_len,
+                                   IoContext *ioc, const char *msg,
+                                   uint32_t msg_len);
+    virtual void AsyncSendBulk(boost::asio::mutable_buffers_1, HandlerCb);
+    virtual boost::asio::io_service *GetIoService() {
+        return &sock_.get_io_service();
+    }
 private:
     boost::asio::netlink::raw::socket sock_;
 };
@@ -237,6 +283,8 @@ public:
                              HandlerCb);
     virtual std::size_t SendTo(boost::asio::const_buffers_1);
     virtual void Receive(boost::asio::mutable_buffers_1);
+    // Bulk mode is not supported, since the user space vrouter parses a
+    // single message per datagram. Requests are always sent on their own.
 private:
     boost::asio::ip::udp::socket sock_;
     boost::asio::ip::udp::endpoint server_ep_;
@@ -466,6 +466,13 @@ void KSyncUserSockFlowContext::Process() {
 
         //Activate the flow-entry in flow mmap
         KSyncSockTypeMap::SetFlowEntry(req_->get_fr_index(), true);
+        vr_flow_entry *f = KSyncSockTypeMap::GetFlowEntry(req_->get_fr_index());
+        f->fe_key.key_vrf_id = req_->get_fr_flow_vrf();
+        f->fe_key.key_src_ip = req_->get_fr_flow_sip();
+        f->fe_key.key_dest_ip = req_->get_fr_flow_dip();
+        f->fe_key.key_proto = req_->get_fr_flow_proto();
+        f->fe_key.key_src_port = req_->get_fr_flow_sport();
+        f->fe_key.key_dst_port = req_->get_fr_flow_dport();
 
         // For NAT flow, don't send vr_response, instead send
         // vr_flow_req with index of reverse_flow
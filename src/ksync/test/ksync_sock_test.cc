@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <boost/bind.hpp>
+#include <tbb/atomic.h>
+
+#include "base/logging.h"
+#include "base/test/task_test_util.h"
+#include "io/event_manager.h"
+#include "io/test/event_manager_test.h"
+#include "testing/gunit.h"
+
+#include "ksync/ksync_entry.h"
+#include "ksync/ksync_sock.h"
+#include "udp_util.h"
+
+using namespace boost::asio;
+using namespace std;
+
+// Sandesh context for responses. Responses carry no payload, so none of the
+// message handlers are expected to run
+class TestSandeshContext : public AgentSandeshContext {
+public:
+    virtual void IfMsgHandler(vr_interface_req *req) { assert(0); }
+    virtual void NHMsgHandler(vr_nexthop_req *req) { assert(0); }
+    virtual void RouteMsgHandler(vr_route_req *req) { assert(0); }
+    virtual void MplsMsgHandler(vr_mpls_req *req) { assert(0); }
+    virtual int VrResponseMsgHandler(vr_response *r) { return 0; }
+    virtual void MirrorMsgHandler(vr_mirror_req *req) { assert(0); }
+    virtual void FlowMsgHandler(vr_flow_req *req) { assert(0); }
+    virtual void VrfAssignMsgHandler(vr_vrf_assign_req *req) { assert(0); }
+    virtual void VrfStatsMsgHandler(vr_vrf_stats_req *req) { assert(0); }
+    virtual void DropStatsMsgHandler(vr_drop_stats_req *req) { assert(0); }
+};
+
+class TestIoContext : public IoContext {
+public:
+    TestIoContext(char *msg, uint32_t len, uint32_t seq,
+                  AgentSandeshContext *ctx)
+        : IoContext(msg, len, seq, ctx) {
+    }
+    virtual void Handler() { ack_count_++; }
+    static tbb::atomic<int> ack_count_;
+};
+tbb::atomic<int> TestIoContext::ack_count_;
+
+// Minimal user space vrouter. Like the real one, it expects a single
+// uvr_msg_hdr and message per datagram, and acks it with an empty response
+// carrying the same seqno
+class UvrServer {
+public:
+    explicit UvrServer(boost::asio::io_service &ios)
+        : sock_(ios, ip::udp::endpoint(ip::address::from_string("127.0.0.1"),
+                                       0)),
+          rx_count_(0), error_count_(0) {
+        AsyncReceive();
+    }
+
+    int port() const { return sock_.local_endpoint().port(); }
+    int rx_count() const { return rx_count_; }
+    int error_count() const { return error_count_; }
+
+private:
+    void AsyncReceive() {
+        sock_.async_receive_from(buffer(rx_buff_, sizeof(rx_buff_)), peer_,
+            boost::bind(&UvrServer::ReadHandler, this, placeholders::error,
+                        placeholders::bytes_transferred));
+    }
+
+    void ReadHandler(const boost::system::error_code &error, size_t len) {
+        if (error)
+            return;
+
+        rx_count_++;
+        struct uvr_msg_hdr *req = (struct uvr_msg_hdr *)rx_buff_;
+        if (len < sizeof(struct uvr_msg_hdr) ||
+            len != sizeof(struct uvr_msg_hdr) + req->msg_len) {
+            error_count_++;
+            AsyncReceive();
+            return;
+        }
+
+        struct uvr_msg_hdr resp;
+        resp.seq_no = req->seq_no;
+        resp.flags = 0;
+        resp.msg_len = 0;
+        sock_.send_to(buffer(&resp, sizeof(resp)), peer_);
+        AsyncReceive();
+    }
+
+    ip::udp::socket sock_;
+    ip::udp::endpoint peer_;
+    char rx_buff_[KSyncSock::kBufLen];
+    tbb::atomic<int> rx_count_;
+    tbb::atomic<int> error_count_;
+};
+
+class KSyncSockUdpTest : public ::testing::Test {
+protected:
+    KSyncSockUdpTest() : thread_(&evm_), server_(*evm_.io_service()) {
+    }
+
+    virtual void SetUp() {
+        TestIoContext::ack_count_ = 0;
+        KSyncSock::SetAgentSandeshContext(&sandesh_ctx_);
+        KSyncSockUdp::Init(*evm_.io_service(), 1, server_.port());
+        KSyncSock::Start();
+        thread_.Start();
+    }
+
+    virtual void TearDown() {
+        KSyncSock::Shutdown();
+        KSyncSock::SetBulkMode(false);
+        evm_.Shutdown();
+        thread_.Join();
+    }
+
+    // Send count requests of msg_len bytes and wait for all acks
+    void SendRequests(int count, int msg_len) {
+        KSyncSock *sock = KSyncSock::Get(0);
+        for (int i = 0; i < count; i++) {
+            char *msg = (char *)malloc(msg_len);
+            memset(msg, i & 0xFF, msg_len);
+            TestIoContext *ioc = new TestIoContext(msg, msg_len,
+                sock->AllocSeqNo(), &sandesh_ctx_);
+            sock->GenericSend(msg_len, msg, ioc);
+        }
+        TASK_UTIL_EXPECT_EQ(count, TestIoContext::ack_count_);
+    }
+
+    EventManager evm_;
+    ServerThread thread_;
+    UvrServer server_;
+    TestSandeshContext sandesh_ctx_;
+};
+
+TEST_F(KSyncSockUdpTest, Basic) {
+    SendRequests(100, 64);
+    EXPECT_EQ(100, server_.rx_count());
+    EXPECT_EQ(0, server_.error_count());
+    EXPECT_EQ(0U, KSyncSock::Get(0)->GetBulkSendCount());
+}
+
+// Bulk mode is ignored on UDP, every request goes in its own datagram
+TEST_F(KSyncSockUdpTest, BulkModeIgnored) {
+    KSyncSock::SetBulkMode(true);
+    SendRequests(100, 64);
+    KSyncSock *sock = KSyncSock::Get(0);
+    EXPECT_EQ(100, server_.rx_count());
+    EXPECT_EQ(0, server_.error_count());
+    EXPECT_EQ(0U, sock->GetBulkMsgCount());
+    EXPECT_EQ(0U, sock->GetBulkSendCount());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    return RUN_ALL_TESTS();
+}
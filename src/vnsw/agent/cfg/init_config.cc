@@ -406,6 +406,12 @@ void AgentConfig::InitConfig(const char *init_file, AgentCmdLineParams cmd_line)
         tunnel_str = opt_str.get();
     }
 
+    // Batching of KSync requests to the vrouter is off unless enabled here
+    opt_str = agent.get_optional<string>("ksync-bulk-mode");
+    if (opt_str && opt_str.get() == "true") {
+        Agent::GetInstance()->SetKSyncBulkMode(true);
+    }
+
     // Validate vhost_name
     if (vhost_name == "") {
         LOG(ERROR, "Error in config file <" << init_file 
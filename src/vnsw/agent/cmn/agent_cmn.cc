@@ -13,8 +13,10 @@
 #include <oper/nexthop.h>
 #include <oper/mirror_table.h>
 #include <pkt/flowtable.h>
+#include <pkt/pkt_flow.h>
 #include <pkt/pkt_types.h>
 #include "uve/flow_stats.h"
+#include "uve/uve_init.h"
 #include <base/misc_utils.h>
 #include <cmn/buildinfo.h>
 
@@ -162,6 +164,20 @@ void AgentStatsReq::HandleRequest() const {
     flow->set_flow_active(AgentStats::GetInstance()->GetFlowActive());
     flow->set_flow_created(AgentStats::GetInstance()->GetFlowCreated());
     flow->set_flow_aged(AgentStats::GetInstance()->GetFlowAged());
+    FlowProto *proto = Agent::GetInstance()->GetFlowProto();
+    if (proto) {
+        vector<uint64_t> partition_pkts;
+        for (int i = 0; i < proto->PartitionCount(); i++) {
+            partition_pkts.push_back(proto->PartitionPktCount(i));
+        }
+        flow->set_partition_pkts(partition_pkts);
+    }
+    FlowStatsCollector *collector =
+        AgentUve::GetInstance()->GetFlowStatsCollector();
+    flow->set_flow_sweep_time(collector->last_sweep_time());
+    flow->set_flow_sweep_active(collector->last_sweep_active());
+    flow->set_flow_sweep_changed(collector->last_sweep_changed());
+    flow->set_flow_sweep_aged(collector->last_sweep_aged());
     flow->set_context(context());
     flow->set_more(true);
     flow->Response();
@@ -166,6 +166,7 @@ public:
     void SetPrefixLen(uint32_t plen) {prefix_len_ = plen;};
 
     bool GetRouterIdConfigured() { return router_id_configured_; }
+    bool GetKSyncBulkMode() { return ksync_bulk_mode_; }
     LifetimeManager *GetLifetimeManager() { return lifetime_manager_;};
 
     Ip4Address GetGatewayId() {return gateway_id_; };
@@ -440,6 +441,10 @@ public:
         router_id_configured_ = value;
     }
 
+    void SetKSyncBulkMode(bool value) {
+        ksync_bulk_mode_ = value;
+    }
+
     void SetEventManager(EventManager *evm) {
         event_mgr_ = evm;
     }
@@ -487,7 +492,7 @@ public:
         dns_proto_(NULL), icmp_proto_(NULL), flow_proto_(NULL),
         local_peer_(NULL), local_vm_peer_(NULL),
         mdata_vm_peer_(NULL), ifmap_parser_(NULL), router_id_configured_(false),
-        mirror_src_udp_port_(0), lifetime_manager_(NULL), test_mode_(false), 
+        ksync_bulk_mode_(false), mirror_src_udp_port_(0), lifetime_manager_(NULL), test_mode_(false), 
         mgmt_ip_("") {
 
         assert(singleton_ == NULL);
@@ -599,6 +604,7 @@ private:
     Peer *mdata_vm_peer_;
     IFMapAgentParser *ifmap_parser_;
     bool router_id_configured_;
+    bool ksync_bulk_mode_;
 
     uint16_t mirror_src_udp_port_;
     LifetimeManager *lifetime_manager_;
@@ -151,6 +151,13 @@ void VNController::DisConnect() {
     while (count < MAX_XMPP_SERVERS) {
         if ((cl = Agent::GetInstance()->GetAgentXmppClient(count)) != NULL) {
 
+            // Send the routes still batched on the channel while it is up
+            AgentXmppChannel *ch =
+                Agent::GetInstance()->GetAgentXmppChannel(count);
+            if (ch) {
+                ch->FlushRouteBatch();
+            }
+
             //shutdown triggers cleanup of routes learnt from
             //the control-node. 
             cl->Shutdown();
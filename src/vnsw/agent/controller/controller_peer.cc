@@ -4,6 +4,7 @@
 
 #include <base/util.h>
 #include <base/logging.h>
+#include <base/timer.h>
 #include <net/bgp_af.h>
 #include <sandesh/sandesh.h>
 #include <sandesh/sandesh_types.h>
@@ -33,7 +34,14 @@ using namespace autogen;
 AgentXmppChannel::AgentXmppChannel(XmppChannel *channel, std::string xmpp_server, 
                                    std::string label_range, uint8_t xs_idx) 
     : channel_(channel), xmpp_server_(xmpp_server), label_range_(label_range),
-      xs_idx_(xs_idx) {
+      xs_idx_(xs_idx), batch_add_(false), batch_size_(0),
+      batch_buf_(new uint8_t[kRouteBatchBufferSize]),
+      batch_timer_(TimerManager::CreateTimer(
+          *(Agent::GetInstance()->GetEventManager())->io_service(),
+          "Route batch timer",
+          TaskScheduler::GetInstance()->GetTaskId("db::DBTable"), 0)) {
+    route_publish_msgs_ = 0;
+    route_publish_items_ = 0;
 
     channel_->RegisterReceive(xmps::BGP, 
                               boost::bind(&AgentXmppChannel::ReceiveInternal, 
@@ -45,6 +53,8 @@ AgentXmppChannel::AgentXmppChannel(XmppChannel *channel, std::string xmpp_server
 }
 
 AgentXmppChannel::~AgentXmppChannel() {
+    batch_timer_->Cancel();
+    TimerManager::DeleteTimer(batch_timer_);
 
     BgpPeer *bgp_peer = static_cast<BgpPeer *>(bgp_peer_id_);
     DBTableBase::ListenerId id = bgp_peer->GetVrfExportListenerId();
@@ -490,6 +500,10 @@ void AgentXmppChannel::HandleXmppClientChannelEvent(AgentXmppChannel *peer,
 
     } else {
 
+        // Routes still in the batch can not be sent. They are published
+        // again by PeerNotifyRoutes once the channel is READY
+        peer->ClearRouteBatch();
+
         //Enqueue cleanup of unicast routes
         peer->GetBgpPeer()->DelPeerRoutes(
             boost::bind(&AgentXmppChannel::BgpPeerDelDone, peer));
@@ -638,6 +652,9 @@ bool AgentXmppChannel::ControllerSendSubscribe(AgentXmppChannel *peer,
     if (!peer) {
         return false;
     }      
+
+    // Routes in the VRF go out before it is unsubscribed
+    peer->FlushRouteBatch();
        
     //Build the DOM tree
     auto_ptr<XmlBase> impl(XmppStanza::AllocXmppXmlImpl());
@@ -680,17 +697,10 @@ bool AgentXmppChannel::ControllerSendRoute(AgentXmppChannel *peer,
                                            const SecurityGroupList *sg_list,
                                            bool add_route) {
 
-    static int id = 0;
     ItemType item;
-    uint8_t data_[4096];
-    size_t datalen_;
    
     if (!peer) return false;
 
-    //Build the DOM tree
-    auto_ptr<XmlBase> impl(XmppStanza::AllocXmppXmlImpl());
-    XmlPugi *pugi = reinterpret_cast<XmlPugi *>(impl.get());
-
     item.entry.nlri.af = BgpAf::IPv4; 
     item.entry.nlri.safi = BgpAf::Unicast; 
     stringstream rstr;
@@ -714,12 +724,113 @@ bool AgentXmppChannel::ControllerSendRoute(AgentXmppChannel *peer,
 
     item.entry.version = 1; //TODO
     item.entry.virtual_network = vn;
-   
+
+    return peer->EnqueueRoute(route->GetVrfEntry()->GetName(), item,
+                              add_route);
+}
+
+// Counts the bytes of an encoded document without writing them out
+class XmlSizeWriter : public pugi::xml_writer {
+public:
+    XmlSizeWriter() : size_(0) { }
+    virtual void write(const void *data, size_t size) { size_ += size; }
+    size_t size() const { return size_; }
+private:
+    size_t size_;
+};
+
+static size_t EncodedItemSize(const ItemType &item) {
+    pugi::xml_document doc;
+    pugi::xml_node node = doc.append_child("item");
+    item.Encode(&node);
+    XmlSizeWriter writer;
+    doc.save(writer, "", pugi::format_raw | pugi::format_no_declaration);
+    return writer.size();
+}
+
+// Add a route item to the pending batch. The batch is sent first if the
+// item is for a different VRF or operation, so the control node sees
+// updates in the order they were made, or if the encoded batch would no
+// longer fit in batch_buf_.
+bool AgentXmppChannel::EnqueueRoute(const std::string &vrf_name,
+                                    const ItemType &item, bool add_route) {
+    if (!channel_ || channel_->GetPeerState() != xmps::READY) {
+        return false;
+    }
+
+    size_t item_size = EncodedItemSize(item);
+    if (item_size > kRouteBatchBufferSize - kRouteBatchHeaderSize) {
+        CONTROLLER_TRACE(Trace, bgp_peer_id_->GetName(), vrf_name,
+                         "Route item too large to publish");
+        return false;
+    }
+
+    tbb::mutex::scoped_lock lock(batch_mutex_);
+    if (!batch_items_.empty() &&
+        (batch_vrf_ != vrf_name || batch_add_ != add_route ||
+         batch_size_ + item_size >
+             kRouteBatchBufferSize - kRouteBatchHeaderSize)) {
+        SendRouteBatch();
+    }
+
+    if (batch_items_.empty()) {
+        batch_vrf_ = vrf_name;
+        batch_add_ = add_route;
+    }
+    batch_items_.push_back(item);
+    batch_size_ += item_size;
+
+    if (batch_items_.size() >= kMaxRouteBatch) {
+        SendRouteBatch();
+    } else {
+        batch_timer_->Start(kRouteBatchTimeout,
+            boost::bind(&AgentXmppChannel::RouteBatchTimerExpired, this));
+    }
+    return true;
+}
+
+void AgentXmppChannel::FlushRouteBatch() {
+    tbb::mutex::scoped_lock lock(batch_mutex_);
+    SendRouteBatch();
+}
+
+void AgentXmppChannel::ClearRouteBatch() {
+    tbb::mutex::scoped_lock lock(batch_mutex_);
+    batch_timer_->Cancel();
+    batch_items_.clear();
+    batch_size_ = 0;
+}
+
+// The timer keeps running while routes are being added, so that a route
+// queued while the handler is running is not left behind.
+bool AgentXmppChannel::RouteBatchTimerExpired() {
+    tbb::mutex::scoped_lock lock(batch_mutex_);
+    if (batch_items_.empty()) {
+        return false;
+    }
+    SendRouteBatch();
+    return true;
+}
+
+// Send the pending batch as one publish with an item per route, followed by
+// one collection associate/dissociate. Called with batch_mutex_ held.
+void AgentXmppChannel::SendRouteBatch() {
+    static int id = 0;
+    int datalen_;
+
+    if (batch_items_.empty()) {
+        return;
+    }
+
+    //Build the DOM tree
+    auto_ptr<XmlBase> impl(XmppStanza::AllocXmppXmlImpl());
+    XmlPugi *pugi = reinterpret_cast<XmlPugi *>(impl.get());
+
     pugi->AddNode("iq", "");
     pugi->AddAttribute("type", "set");
     
-    pugi->AddAttribute("from", peer->channel_->FromString());
-    std::string to(peer->channel_->ToString());
+    pugi->AddAttribute("from", channel_->FromString());
+    std::string to(channel_->ToString());
     to += "/";
     to += XmppInit::kBgpPeer; 
     pugi->AddAttribute("to", to);
@@ -733,22 +844,32 @@ bool AgentXmppChannel::ControllerSendRoute(AgentXmppChannel *peer,
     pugi->AddChildNode("publish", "");
 
     stringstream ss_node;
-    ss_node << item.entry.nlri.af << "/" 
-            << item.entry.nlri.safi << "/" 
-            << route->GetVrfEntry()->GetName() << "/" 
-            << route->GetIpAddress().to_string();
+    ss_node << BgpAf::IPv4 << "/" << BgpAf::Unicast << "/" << batch_vrf_;
     std::string node_id(ss_node.str());
     pugi->AddAttribute("node", node_id);
-    pugi->AddChildNode("item", "");
-
-    pugi::xml_node node = pugi->FindNode("item");
 
-    //Call Auto-generated Code to encode the struct
-    item.Encode(&node);
+    pugi::xml_node publish = pugi->FindNode("publish");
+    for (std::vector<ItemType>::iterator it = batch_items_.begin();
+         it != batch_items_.end(); ++it) {
+        pugi::xml_node node = publish.append_child("item");
+        //Call Auto-generated Code to encode the struct
+        it->Encode(&node);
+    }
 
-    datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
+    datalen_ = XmppProto::EncodeMessage(impl.get(), batch_buf_.get(),
+                                        kRouteBatchBufferSize);
+    if (datalen_ <= 0) {
+        CONTROLLER_TRACE(Trace, bgp_peer_id_->GetName(), batch_vrf_,
+                         "Error encoding route publish");
+        batch_items_.clear();
+        batch_size_ = 0;
+        return;
+    }
+    assert(static_cast<size_t>(datalen_) <= kRouteBatchBufferSize);
     // send data
-    peer->SendUpdate(data_,datalen_);
+    SendUpdate(batch_buf_.get(), datalen_);
+    route_publish_msgs_++;
+    route_publish_items_ += batch_items_.size();
 
     pugi->DeleteNode("pubsub");
     pugi->ReadNode("iq");
@@ -760,17 +881,22 @@ bool AgentXmppChannel::ControllerSendRoute(AgentXmppChannel *peer,
     pugi->AddAttribute("xmlns", "http://jabber.org/protocol/pubsub");
     pugi->AddChildNode("collection", "");
 
-    pugi->AddAttribute("node", route->GetVrfEntry()->GetName());
-    if (add_route) {
+    pugi->AddAttribute("node", batch_vrf_);
+    if (batch_add_) {
         pugi->AddChildNode("associate", "");
     } else {
         pugi->AddChildNode("dissociate", "");
     }
     pugi->AddAttribute("node", node_id);
 
-    datalen_ = XmppProto::EncodeMessage(impl.get(), data_, sizeof(data_));
+    datalen_ = XmppProto::EncodeMessage(impl.get(), batch_buf_.get(),
+                                        kRouteBatchBufferSize);
     // send data
-    return (peer->SendUpdate(data_,datalen_));
+    if (datalen_ > 0) {
+        SendUpdate(batch_buf_.get(), datalen_);
+    }
+    batch_items_.clear();
+    batch_size_ = 0;
 }
 
 bool AgentXmppChannel::ControllerSendMcastRoute(AgentXmppChannel *peer,
@@ -783,6 +909,7 @@ bool AgentXmppChannel::ControllerSendMcastRoute(AgentXmppChannel *peer,
     size_t datalen_;
    
     if (!peer) return false;
+    peer->FlushRouteBatch();
     if (add_route && (Agent::GetInstance()->GetControlNodeMulticastBuilder() != peer)) {
         CONTROLLER_TRACE(Trace, peer->GetBgpPeer()->GetName(),
                          route->GetVrfEntry()->GetName(),
@@ -7,19 +7,34 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/function.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/system/error_code.hpp>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
 #include "xmpp/xmpp_channel.h"
 #include "xmpp_unicast_types.h"
 
 class Inet4Route;
 class Peer;
+class Timer;
 class VrfEntry;
 class XmlPugi;
 
 class AgentXmppChannel {
 public:
+    // Unicast route updates for the same VRF are batched into a single
+    // publish/collection pair. A batch is sent when it has kMaxRouteBatch
+    // routes, when kRouteBatchTimeout msec have passed since its first
+    // route, or before any other update is sent on the channel.
+    static const size_t kMaxRouteBatch = 32;
+    static const int kRouteBatchTimeout = 10;
+    static const size_t kRouteBatchBufferSize = 64 * 1024;
+    // Room left in the buffer for the iq/pubsub/publish wrapper
+    static const size_t kRouteBatchHeaderSize = 1024;
+
     explicit AgentXmppChannel(XmppChannel *channel);
     AgentXmppChannel(XmppChannel *channel, std::string xmpp_server, 
                      std::string label_range, uint8_t xs_idx);
@@ -44,6 +59,10 @@ public:
                                     bool add_route);
     static bool ControllerSendMcastRoute(AgentXmppChannel *peer,
                                          Inet4Route *route, bool add_route);
+    void FlushRouteBatch();
+    void ClearRouteBatch();
+    uint64_t route_publish_msgs() const { return route_publish_msgs_; }
+    uint64_t route_publish_items() const { return route_publish_items_; }
     Peer *GetBgpPeer() { return bgp_peer_id_; }
     std::string GetXmppServer() { return xmpp_server_; }
     uint8_t GetXmppServerIdx() { return xs_idx_; }
@@ -61,11 +80,27 @@ private:
                         autogen::ItemType *item);
     void AddEcmpRoute(std::string vrf_name, Ip4Address ip, uint32_t plen, 
                       autogen::ItemType *item);
+    bool EnqueueRoute(const std::string &vrf_name,
+                      const autogen::ItemType &item, bool add_route);
+    void SendRouteBatch();
+    bool RouteBatchTimerExpired();
+
     XmppChannel *channel_;
     std::string xmpp_server_;
     std::string label_range_;
     uint8_t xs_idx_;
     Peer *bgp_peer_id_;
+
+    tbb::mutex batch_mutex_;
+    std::string batch_vrf_;
+    bool batch_add_;
+    std::vector<autogen::ItemType> batch_items_;
+    // Encoded size of batch_items_
+    size_t batch_size_;
+    boost::scoped_array<uint8_t> batch_buf_;
+    Timer *batch_timer_;
+    tbb::atomic<uint64_t> route_publish_msgs_;
+    tbb::atomic<uint64_t> route_publish_items_;
 };
 
 #endif // __CONTROLLER_PEER_H__
@@ -57,6 +57,8 @@ void AgentXmppConnectionStatusReq::HandleRequest() const {
 
 		data.set_rx_proto_stats(rx_proto_stats); 
                 data.set_tx_proto_stats(tx_proto_stats); 
+                data.set_route_publish_msgs(ch->route_publish_msgs());
+                data.set_route_publish_items(ch->route_publish_items());
             }
 
 	    std::vector<AgentXmppData> &list =
@@ -106,6 +106,7 @@ DBEntry *AclTable::Add(const DBRequest *req) {
          ++it) {
         acl->AddAclEntry(*it, acl->acl_entries_);
     }
+    acl->RebuildClassifier();
     return acl;
 }
 
@@ -115,6 +116,7 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
 
     if (data->ace_id_to_del_) {
         acl->DeleteAclEntry(data->ace_id_to_del_);
+        acl->RebuildClassifier();
         return true;
     }
 
@@ -137,6 +139,7 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
         acl->DeleteAllAclEntries();
         acl->SetAclEntries(entries);
     }
+    acl->RebuildClassifier();
     return true;
 }
 
@@ -144,6 +147,7 @@ void AclTable::Delete(DBEntry *entry, const DBRequest *req) {
     AclDBEntry *acl = static_cast<AclDBEntry *>(entry);
     ACL_TRACE(Info, "Delete " + UuidToString(acl->GetUuid()));
     acl->DeleteAllAclEntries();
+    acl->RebuildClassifier();
 }
 
 void AclTable::ActionInit() {
@@ -617,37 +621,80 @@ void AclDBEntry::DeleteAllAclEntries()
     return;
 }
 
+void AclDBEntry::RebuildClassifier()
+{
+    std::vector<const AclEntry *> entries;
+    entries.reserve(acl_entries_.size());
+    AclEntries::const_iterator iter;
+    for (iter = acl_entries_.begin(); iter != acl_entries_.end(); ++iter) {
+        entries.push_back(iter.operator->());
+    }
+    classifier_.Build(entries);
+}
+
+// Accumulate the actions of a matching entry. Returns true if the entry
+// is terminal
+bool AclDBEntry::ApplyAclEntry(const AclEntry *entry, MatchAclParams &m_acl)
+{
+    const AclEntry::ActionList &al = entry->Actions();
+    AclEntry::ActionList::const_iterator al_it;
+    for (al_it = al.begin(); al_it != al.end(); ++al_it) {
+        TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
+        m_acl.action_info.action |= 1 << ta->GetAction();
+        if (ta->GetActionType() == TrafficAction::MIRROR_ACTION) {
+            MirrorAction *a = static_cast<MirrorAction *>(*al_it.operator->());
+            MirrorActionSpec as;
+            as.ip = a->GetIp();
+            as.port = a->GetPort();
+            as.vrf_name = a->GetVrfName();
+            as.analyzer_name = a->GetAnalyzerName();
+            as.encap = a->GetEncap();
+            m_acl.action_info.mirror_l.push_back(as);
+        }
+    }
+    m_acl.ace_id_list.push_back((int32_t)(entry->id()));
+    if (entry->IsTerminal()) {
+        m_acl.terminal_rule = true;
+        return true;
+    }
+    return false;
+}
+
+struct AclClassifierMatch {
+    AclClassifierMatch(MatchAclParams &m_acl) : m_acl(m_acl), match(false) {
+    }
+    bool operator()(const AclEntry *entry) {
+        match = true;
+        return !AclDBEntry::ApplyAclEntry(entry, m_acl);
+    }
+    MatchAclParams &m_acl;
+    bool match;
+};
+
 bool AclDBEntry::PacketMatch(const PacketHeader &packet_header, 
 			     MatchAclParams &m_acl) const
+{
+    m_acl.terminal_rule = false;
+    m_acl.action_info.action = 0;
+    AclClassifierMatch cb(m_acl);
+    classifier_.Match(packet_header, cb);
+    return cb.match;
+}
+
+bool AclDBEntry::PacketMatchLinear(const PacketHeader &packet_header,
+                                   MatchAclParams &m_acl) const
 {
     AclEntries::const_iterator iter;
     bool ret_val = false;
     m_acl.terminal_rule = false;
-	m_acl.action_info.action = 0;
+    m_acl.action_info.action = 0;
     for (iter = acl_entries_.begin();
          iter != acl_entries_.end();
          ++iter) {
         const AclEntry::ActionList &al = iter->PacketMatch(packet_header);
-	AclEntry::ActionList::const_iterator al_it;
-	for (al_it = al.begin(); al_it != al.end(); ++al_it) {
-	     TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
-	     m_acl.action_info.action |= 1 << ta->GetAction();
-	     if (ta->GetActionType() == TrafficAction::MIRROR_ACTION) {
-	         MirrorAction *a = static_cast<MirrorAction *>(*al_it.operator->());
-                 MirrorActionSpec as;
-		 as.ip = a->GetIp();
-		 as.port = a->GetPort();
-                 as.vrf_name = a->GetVrfName();
-                 as.analyzer_name = a->GetAnalyzerName();
-                 as.encap = a->GetEncap();
-                 m_acl.action_info.mirror_l.push_back(as);
-	     }
-	}
         if (!(al.empty())) {
             ret_val = true;
-            m_acl.ace_id_list.push_back((int32_t)(iter->id()));
-            if (iter->IsTerminal()) {
-	        m_acl.terminal_rule = true;
+            if (ApplyAclEntry(iter.operator->(), m_acl)) {
                 return ret_val;
             }
         }
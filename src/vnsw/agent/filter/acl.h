@@ -7,6 +7,7 @@
 
 #include "vnsw/agent/filter/acl_entry.h"
 #include "vnsw/agent/filter/acl_entry_spec.h"
+#include "vnsw/agent/filter/acl_classifier.h"
 
 #include <boost/intrusive/list.hpp>
 #include <boost/uuid/uuid.hpp>
@@ -127,12 +128,20 @@ public:
     // Packet Match
     bool PacketMatch(const PacketHeader &packet_header, 
 		     MatchAclParams &m_acl) const;
+    // Walks all the entries in order. Reference for the classifier
+    bool PacketMatchLinear(const PacketHeader &packet_header,
+                           MatchAclParams &m_acl) const;
+    const AclClassifier &classifier() const { return classifier_; }
 private:
     friend class AclTable;
+    friend struct AclClassifierMatch;
+    void RebuildClassifier();
+    static bool ApplyAclEntry(const AclEntry *entry, MatchAclParams &m_acl);
     uuid uuid_;
     bool dynamic_acl_;
     std::string name_;
     AclEntries acl_entries_;
+    AclClassifier classifier_;
     DISALLOW_COPY_AND_ASSIGN(AclDBEntry);
 };
 
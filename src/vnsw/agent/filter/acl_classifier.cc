@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include "vnsw/agent/filter/acl_classifier.h"
+#include "vnsw/agent/filter/packet_header.h"
+
+AclClassifier::AclClassifier() {
+}
+
+AclClassifier::~AclClassifier() {
+}
+
+void AclClassifier::Clear() {
+    rules_.clear();
+    wildcard_.clear();
+    buckets_.clear();
+    bucket_index_.clear();
+}
+
+void AclClassifier::Build(const std::vector<const AclEntry *> &entries) {
+    Clear();
+    for (std::vector<const AclEntry *>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+        const AclEntry *entry = *it;
+        // An entry without actions never contributes to a match
+        if (entry->Actions().empty()) {
+            continue;
+        }
+        uint32_t index = rules_.size();
+        rules_.push_back(entry);
+
+        const AclEntryMatchData::RangeList &protocol =
+            entry->match_data().protocol;
+        uint32_t span = 0;
+        for (AclEntryMatchData::RangeList::const_iterator r_it =
+             protocol.begin(); r_it != protocol.end(); ++r_it) {
+            if (r_it->first > r_it->second || r_it->first > 0xFF) {
+                continue;
+            }
+            span += std::min(r_it->second, (uint16_t)0xFF) - r_it->first + 1;
+        }
+        if (protocol.empty() || span > kMaxProtocolSpan) {
+            wildcard_.push_back(index);
+            continue;
+        }
+
+        if (bucket_index_.empty()) {
+            bucket_index_.resize(0x100, kNoBucket);
+        }
+        for (AclEntryMatchData::RangeList::const_iterator r_it =
+             protocol.begin(); r_it != protocol.end(); ++r_it) {
+            for (uint32_t proto = r_it->first;
+                 proto <= r_it->second && proto <= 0xFF; proto++) {
+                if (bucket_index_[proto] == kNoBucket) {
+                    bucket_index_[proto] = buckets_.size();
+                    buckets_.push_back(RuleIndexList());
+                }
+                RuleIndexList &bucket = buckets_[bucket_index_[proto]];
+                // Overlapping ranges of the same rule add it only once
+                if (bucket.empty() || bucket.back() != index) {
+                    bucket.push_back(index);
+                }
+            }
+        }
+    }
+}
+
+bool AclClassifier::MatchAddress(const AclEntryMatchData::Address &addr,
+                                 uint32_t ip, const std::string *policy_id,
+                                 const SecurityGroupList *sg_l) {
+    switch (addr.type) {
+    case AddressMatch::IP_ADDR:
+        return (addr.v4 && ((addr.mask & ip) == addr.ip));
+    case AddressMatch::NETWORK_ID:
+        if (addr.any) {
+            return true;
+        }
+        return (policy_id && addr.policy_id.compare(*policy_id) == 0);
+    case AddressMatch::SG:
+        if (!sg_l) {
+            return false;
+        }
+        if (addr.sg_id == AddressMatch::kAny) {
+            return true;
+        }
+        for (SecurityGroupList::const_iterator it = sg_l->begin();
+             it != sg_l->end(); ++it) {
+            if (*it == addr.sg_id) return true;
+        }
+        return false;
+    default:
+        // No address match configured
+        return true;
+    }
+}
+
+bool AclClassifier::MatchRange(const AclEntryMatchData::RangeList &ranges,
+                               uint16_t value) {
+    if (ranges.empty()) {
+        return true;
+    }
+    for (AclEntryMatchData::RangeList::const_iterator it = ranges.begin();
+         it != ranges.end(); ++it) {
+        if (value >= it->first && value <= it->second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AclClassifier::RuleMatch(uint32_t index,
+                              const PacketHeader &packet_header) const {
+    const AclEntryMatchData &data = rules_[index]->match_data();
+    return (MatchRange(data.protocol, packet_header.protocol) &&
+            MatchRange(data.dst_port, packet_header.dst_port) &&
+            MatchRange(data.src_port, packet_header.src_port) &&
+            MatchAddress(data.src, packet_header.src_ip,
+                         packet_header.src_policy_id,
+                         packet_header.src_sg_id_l) &&
+            MatchAddress(data.dst, packet_header.dst_ip,
+                         packet_header.dst_policy_id,
+                         packet_header.dst_sg_id_l));
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __AGENT_ACL_CLASSIFIER_H__
+#define __AGENT_ACL_CLASSIFIER_H__
+
+#include <vector>
+#include "vnsw/agent/filter/acl_entry.h"
+
+struct PacketHeader;
+
+// Compiled form of the entries of an ACL, rebuilt whenever the entries
+// change. Rules are bucketed on the protocols they match, so a packet is
+// only checked against the rules that can apply to its protocol, and each
+// rule is checked with inline address, protocol and port comparisons.
+// Rules are visited in ACL order, so first match and terminal semantics
+// are the same as walking the entries.
+class AclClassifier {
+public:
+    // Rules matching more protocols than this are kept in the wildcard
+    // list instead of being added to each protocol bucket
+    static const uint32_t kMaxProtocolSpan = 8;
+    static const uint16_t kNoBucket = 0xFFFF;
+
+    AclClassifier();
+    ~AclClassifier();
+
+    // Entries must be in ACL order
+    void Build(const std::vector<const AclEntry *> &entries);
+    void Clear();
+
+    // Invokes cb for each matching entry, in ACL order, until cb returns
+    // false
+    template <typename MatchCb>
+    void Match(const PacketHeader &packet_header, MatchCb &cb) const;
+
+    uint32_t rule_count() const { return rules_.size(); }
+    uint32_t wildcard_count() const { return wildcard_.size(); }
+    uint32_t bucket_count() const { return buckets_.size(); }
+
+private:
+    typedef std::vector<uint32_t> RuleIndexList;
+
+    static bool MatchAddress(const AclEntryMatchData::Address &addr,
+                             uint32_t ip, const std::string *policy_id,
+                             const SecurityGroupList *sg_l);
+    static bool MatchRange(const AclEntryMatchData::RangeList &ranges,
+                           uint16_t value);
+    bool RuleMatch(uint32_t index, const PacketHeader &packet_header) const;
+
+    std::vector<const AclEntry *> rules_;
+    RuleIndexList wildcard_;
+    std::vector<RuleIndexList> buckets_;
+    std::vector<uint16_t> bucket_index_;
+
+    DISALLOW_COPY_AND_ASSIGN(AclClassifier);
+};
+
+template <typename MatchCb>
+void AclClassifier::Match(const PacketHeader &packet_header,
+                          MatchCb &cb) const {
+    static const RuleIndexList kEmptyList;
+    const RuleIndexList *bucket = &kEmptyList;
+    if (!bucket_index_.empty() &&
+        bucket_index_[packet_header.protocol] != kNoBucket) {
+        bucket = &buckets_[bucket_index_[packet_header.protocol]];
+    }
+
+    // Merge the protocol bucket with the wildcard rules in ACL order
+    RuleIndexList::const_iterator b_it = bucket->begin();
+    RuleIndexList::const_iterator w_it = wildcard_.begin();
+    while (b_it != bucket->end() || w_it != wildcard_.end()) {
+        uint32_t index;
+        if (w_it == wildcard_.end() ||
+            (b_it != bucket->end() && *b_it < *w_it)) {
+            index = *b_it++;
+        } else {
+            index = *w_it++;
+        }
+        if (RuleMatch(index, packet_header) && !cb(rules_[index])) {
+            return;
+        }
+    }
+}
+
+#endif
@@ -13,6 +13,33 @@
 
 AclEntry::ActionList AclEntry::kEmptyActionList;
 
+static void SetMatchAddress(AclEntryMatchData::Address &addr,
+                            AddressMatch::AddressType type,
+                            const IpAddress &ip, const IpAddress &mask,
+                            const std::string &policy_id, int sg_id) {
+    addr.type = type;
+    if (type == AddressMatch::IP_ADDR) {
+        addr.v4 = ip.is_v4();
+        if (addr.v4) {
+            addr.ip = ip.to_v4().to_ulong();
+            addr.mask = mask.to_v4().to_ulong();
+        }
+    } else if (type == AddressMatch::NETWORK_ID) {
+        addr.policy_id = policy_id;
+        addr.any = (policy_id.compare("any") == 0);
+    } else if (type == AddressMatch::SG) {
+        addr.sg_id = sg_id;
+    }
+}
+
+static void SetMatchRanges(AclEntryMatchData::RangeList &ranges,
+                           const std::vector<RangeSpec> &spec) {
+    for (std::vector<RangeSpec>::const_iterator it = spec.begin();
+         it != spec.end(); it++) {
+        ranges.push_back(std::make_pair((*it).min, (*it).max));
+    }
+}
+
 AclEntry::~AclEntry() {
     // Clean up Matches
     std::vector<AclEntryMatch *>::iterator it;
@@ -99,6 +126,18 @@ void AclEntry::PopulateAclEntry(const AclEntrySpec &acl_entry_spec)
         matches_.push_back(port);
     }
 
+    SetMatchAddress(match_data_.src, acl_entry_spec.src_addr_type,
+                    acl_entry_spec.src_ip_addr, acl_entry_spec.src_ip_mask,
+                    acl_entry_spec.src_policy_id_str,
+                    acl_entry_spec.src_sg_id);
+    SetMatchAddress(match_data_.dst, acl_entry_spec.dst_addr_type,
+                    acl_entry_spec.dst_ip_addr, acl_entry_spec.dst_ip_mask,
+                    acl_entry_spec.dst_policy_id_str,
+                    acl_entry_spec.dst_sg_id);
+    SetMatchRanges(match_data_.protocol, acl_entry_spec.protocol);
+    SetMatchRanges(match_data_.src_port, acl_entry_spec.src_port);
+    SetMatchRanges(match_data_.dst_port, acl_entry_spec.dst_port);
+
     if (acl_entry_spec.action_l.size() > 0) {
         std::vector<ActionSpec>::const_iterator it;
         for (it = acl_entry_spec.action_l.begin();
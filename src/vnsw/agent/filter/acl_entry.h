@@ -126,6 +126,31 @@ private:
     bool SGMatch(const SecurityGroupList *sg_l, int id) const;
 };
 
+// Flattened copy of the matches of an AclEntry. AclClassifier matches
+// packets against it with inline checks instead of the virtual
+// AclEntryMatch objects.
+struct AclEntryMatchData {
+    typedef std::vector<std::pair<uint16_t, uint16_t> > RangeList;
+
+    struct Address {
+        Address() : type(AddressMatch::UNKNOWN_TYPE), any(false), v4(false),
+            ip(0), mask(0), sg_id(0) { }
+        AddressMatch::AddressType type;
+        bool any;
+        bool v4;
+        uint32_t ip;
+        uint32_t mask;
+        std::string policy_id;
+        int sg_id;
+    };
+
+    Address src;
+    Address dst;
+    RangeList protocol;
+    RangeList src_port;
+    RangeList dst_port;
+};
+
 class AclEntry {
 public:
     enum AclType {
@@ -158,6 +183,7 @@ public:
     bool IsTerminal() const;
 
     uint32_t id() const { return id_; }
+    const AclEntryMatchData &match_data() const { return match_data_; }
 
     boost::intrusive::list_member_hook<> acl_list_node;
 
@@ -167,6 +193,7 @@ private:
     std::vector<AclEntryMatch *> matches_;
     ActionList actions_;
     MirrorEntryRef mirror_entry_;
+    AclEntryMatchData match_data_;
 
     DISALLOW_COPY_AND_ASSIGN(AclEntry);
 };
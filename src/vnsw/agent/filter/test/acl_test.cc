@@ -339,6 +339,121 @@ TEST_F(AclTest, Config) {
     delete packet1;
 }
 
+static void AddScaleAcl(const uuid &acl_id, int rules) {
+    AclSpec acl_spec;
+    acl_spec.acl_id = acl_id;
+    for (int i = 0; i < rules; i++) {
+        AclEntrySpec ae_spec;
+        ae_spec.id = i + 1;
+        ae_spec.terminal = ((i % 4) == 3);
+        if (i % 3) {
+            ae_spec.src_addr_type = AddressMatch::IP_ADDR;
+            ae_spec.src_ip_addr = Ip4Address(0x0A000000 | ((i % 64) << 8));
+            ae_spec.src_ip_mask = Ip4Address(0xFFFFFF00);
+        }
+        RangeSpec proto;
+        switch (i % 5) {
+        case 0:
+            proto.min = 6;
+            proto.max = 6;
+            ae_spec.protocol.push_back(proto);
+            break;
+        case 1:
+            proto.min = 17;
+            proto.max = 17;
+            ae_spec.protocol.push_back(proto);
+            break;
+        case 2:
+            proto.min = 0;
+            proto.max = 255;
+            ae_spec.protocol.push_back(proto);
+            break;
+        default:
+            break;
+        }
+        RangeSpec port;
+        port.min = (i * 7) % 1000;
+        port.max = port.min + (i % 50);
+        ae_spec.dst_port.push_back(port);
+        ActionSpec action;
+        action.ta_type = TrafficAction::SIMPLE_ACTION;
+        action.simple_action = (i % 2) ? TrafficAction::PASS :
+                                         TrafficAction::DENY;
+        ae_spec.action_l.push_back(action);
+        acl_spec.acl_entry_specs_.push_back(ae_spec);
+    }
+
+    DBRequest req;
+    req.key.reset(new AclKey(acl_id));
+    req.data.reset(new AclData(acl_spec));
+    req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+    Agent::GetInstance()->GetAclTable()->Enqueue(&req);
+    client->WaitForIdle();
+}
+
+static void DelScaleAcl(const uuid &acl_id) {
+    DBRequest req;
+    req.key.reset(new AclKey(acl_id));
+    req.oper = DBRequest::DB_ENTRY_DELETE;
+    Agent::GetInstance()->GetAclTable()->Enqueue(&req);
+    client->WaitForIdle();
+}
+
+// Compare the classifier with the linear walk of the entries and report
+// the flow setup match rate of both at 10, 100 and 1000 rules
+TEST_F(AclTest, ClassifierScale) {
+    static const int kPackets = 10000;
+    static const uint8_t kProtocols[] = {1, 6, 17, 47};
+    boost::uuids::string_generator gen;
+    uuid acl_id = gen("00000000-0000-0000-0000-000000000013");
+    AclTable *table = Agent::GetInstance()->GetAclTable();
+
+    for (int rules = 10; rules <= 1000; rules *= 10) {
+        AddScaleAcl(acl_id, rules);
+        AclKey key(acl_id);
+        AclDBEntry *acl =
+            static_cast<AclDBEntry *>(table->FindActiveEntry(&key));
+        ASSERT_TRUE(acl != NULL);
+        EXPECT_EQ((uint32_t)rules, acl->classifier().rule_count());
+
+        std::vector<PacketHeader> packets(kPackets);
+        for (int i = 0; i < kPackets; i++) {
+            packets[i].src_ip = 0x0A000000 | ((i % 80) << 8) | (i % 256);
+            packets[i].dst_ip = 0x0B000001;
+            packets[i].protocol = kProtocols[i % 4];
+            packets[i].src_port = i % 65536;
+            packets[i].dst_port = (i * 13) % 1100;
+        }
+
+        uint64_t start = UTCTimestampUsec();
+        for (int i = 0; i < kPackets; i++) {
+            MatchAclParams m_acl;
+            acl->PacketMatchLinear(packets[i], m_acl);
+        }
+        uint64_t linear_time = UTCTimestampUsec() - start;
+
+        start = UTCTimestampUsec();
+        for (int i = 0; i < kPackets; i++) {
+            MatchAclParams m_acl;
+            acl->PacketMatch(packets[i], m_acl);
+        }
+        uint64_t classifier_time = UTCTimestampUsec() - start;
+
+        for (int i = 0; i < kPackets; i++) {
+            MatchAclParams linear;
+            MatchAclParams compiled;
+            EXPECT_EQ(acl->PacketMatchLinear(packets[i], linear),
+                      acl->PacketMatch(packets[i], compiled));
+            EXPECT_EQ(linear.action_info.action, compiled.action_info.action);
+            EXPECT_EQ(linear.terminal_rule, compiled.terminal_rule);
+            EXPECT_TRUE(linear.ace_id_list == compiled.ace_id_list);
+        }
+        LOG(DEBUG, "ACL with " << rules << " rules: linear " << linear_time
+            << " usec, classifier " << classifier_time << " usec for "
+            << kPackets << " packets");
+    }
+    DelScaleAcl(acl_id);
+}
 
 } //namespace
 
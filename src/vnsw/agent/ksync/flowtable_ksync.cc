@@ -466,8 +466,8 @@ bool FlowTableKSyncObject::AuditProcess(FlowTableKSyncObject *obj) {
             FlowEntryPtr flow(FlowTable::GetFlowTableObject()->Allocate(key));
             flow->flow_handle = flow_idx;
             flow->short_flow = true;
-            flow->data.source_vn = *FlowHandler::UnknownVn();
-            flow->data.dest_vn = *FlowHandler::UnknownVn();
+            flow->data.SetVn(*FlowHandler::UnknownVn(),
+                             *FlowHandler::UnknownVn());
             SecurityGroupList empty_sg_id_l;
             flow->data.source_sg_id_l = empty_sg_id_l;
             flow->data.dest_sg_id_l = empty_sg_id_l;
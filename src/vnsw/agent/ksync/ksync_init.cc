@@ -78,6 +78,7 @@ void KSync::NetlinkInit() {
     boost::asio::io_service &io = *event_mgr->io_service();
 
     KSyncSockNetlink::Init(io, DB::PartitionCount(), NETLINK_GENERIC);
+    KSyncSock::SetBulkMode(Agent::GetInstance()->GetKSyncBulkMode());
     KSyncSock::SetAgentSandeshContext(new KSyncSandeshContext);
 
     GenericNetlinkInit();
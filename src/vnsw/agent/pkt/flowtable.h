@@ -241,7 +241,15 @@ struct FlowData {
         intf_entry(NULL), vm_entry(NULL), mirror_vrf(VrfEntry::kInvalidIndex),
         reverse_flow(), dest_vrf(), ingress(false), ecmp(false),
         component_nh_idx((uint32_t)CompositeNH::kInvalidComponentNHIdx),
-        bytes(0), packets(0) {};
+        bytes(0), packets(0), source_vn_id(-1), dest_vn_id(-1) {};
+
+    // Set the VN names. The cached ids refer to the old names, reset them.
+    void SetVn(const std::string &source, const std::string &dest) {
+        source_vn = source;
+        dest_vn = dest;
+        source_vn_id = -1;
+        dest_vn_id = -1;
+    }
 
     std::string source_vn;
     std::string dest_vn;
@@ -268,6 +276,11 @@ struct FlowData {
     // Stats
     uint64_t bytes;
     uint64_t packets;
+
+    // Ids of source_vn and dest_vn in InterVnStatsCollector. -1 until the
+    // first stats update. Set the names with SetVn() to reset them.
+    int source_vn_id;
+    int dest_vn_id;
 };
 
 class FlowEntry {
@@ -465,6 +478,10 @@ public:
     bool DeleteNatFlow(FlowKey &key, bool del_nat_flow);
     bool DeleteRevFlow(FlowKey &key, bool del_reverse_flow);
 
+    // Flow setup runs in several FlowProto partitions. Changes to the table
+    // from the packet path are made with this mutex held.
+    tbb::mutex &mutex() { return mutex_; }
+
     size_t Size() {return flow_entry_map_.size();};
     size_t VnFlowSize(const VnEntry *vn);
 
@@ -483,6 +500,7 @@ public:
     friend class Inet4RouteUpdate;
 private:
     static FlowTable* singleton_;
+    tbb::mutex mutex_;
     FlowEntryMap flow_entry_map_;
 
     AclFlowTree acl_flow_tree_;
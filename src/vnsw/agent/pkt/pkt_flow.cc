@@ -36,6 +36,73 @@ void FlowHandler::Shutdown() {
     FlowProto::Shutdown();
 }
 
+FlowProto::FlowProto(boost::asio::io_service &io, int partition_count) :
+    Proto<FlowHandler>("Agent::FlowHandler", PktHandler::FLOW, io) {
+    if (partition_count > kMaxPartitions)
+        partition_count = kMaxPartitions;
+    if (partition_count < 1)
+        partition_count = 1;
+
+    int task_id = TaskScheduler::GetInstance()->GetTaskId("Agent::FlowHandler");
+    for (int i = 0; i < partition_count; i++) {
+        partitions_.push_back(new PartitionQueue(task_id, i,
+                boost::bind(&FlowProto::ProcessProto, this, _1)));
+    }
+}
+
+FlowProto::~FlowProto() {
+    for (std::vector<PartitionQueue *>::iterator it = partitions_.begin();
+         it != partitions_.end(); ++it) {
+        (*it)->Shutdown();
+        delete *it;
+    }
+    partitions_.clear();
+}
+
+void FlowProto::Init(boost::asio::io_service &io) {
+    Agent::GetInstance()->SetFlowProto(new FlowProto(io,
+            TaskScheduler::GetInstance()->HardwareThreadCount()));
+}
+
+void FlowProto::Shutdown() {
+    delete Agent::GetInstance()->GetFlowProto();
+    Agent::GetInstance()->SetFlowProto(NULL);
+}
+
+// Hash of the 5-tuple that is the same for a packet and for one with the
+// source and destination swapped. The VRF is left out since the reverse flow
+// may be in another VRF. Packets in the reverse direction of a NAT flow carry
+// the translated addresses and can hash to a different partition, they are
+// moved to kNatPartition once found to need NAT.
+uint32_t FlowProto::FlowHash(const PktInfo *msg) {
+    uint64_t ep1 = ((uint64_t)msg->ip_saddr << 16) | (msg->sport & 0xFFFF);
+    uint64_t ep2 = ((uint64_t)msg->ip_daddr << 16) | (msg->dport & 0xFFFF);
+    if (ep1 > ep2) {
+        std::swap(ep1, ep2);
+    }
+
+    uint64_t hash = (ep1 * 0x9E3779B97F4A7C15ULL) ^ ep2 ^ msg->ip_proto;
+    hash *= 0xC2B2AE3D27D4EB4FULL;
+    return (uint32_t)(hash >> 32);
+}
+
+bool FlowProto::EnqueueMessage(PktInfo *msg) {
+    int partition = FlowHash(msg) % partitions_.size();
+    stats_[partition].pkts++;
+    return partitions_[partition]->Enqueue(msg);
+}
+
+bool FlowProto::MoveToNatPartition(PktInfo *msg) {
+    PartitionQueue *queue = partitions_[kNatPartition];
+    Task *task = Task::Running();
+    if (task && task->GetTaskId() == queue->GetTaskId() &&
+        task->GetTaskInstance() == queue->GetTaskInstance()) {
+        return false;
+    }
+    queue->Enqueue(msg);
+    return true;
+}
+
 static void LogError(const PktInfo *pkt, const char *str) {
     FLOW_TRACE(DetailErr, pkt->agent_hdr.cmd_param, pkt->agent_hdr.ifindex,
                pkt->agent_hdr.vrf, pkt->ip_saddr, pkt->ip_daddr, str);
@@ -721,6 +788,7 @@ bool PktFlowInfo::Process(const PktInfo *pkt, PktControlInfo *in,
 
 void PktFlowInfo::Add(const PktInfo *pkt, PktControlInfo *in,
                       PktControlInfo *out) {
+    tbb::mutex::scoped_lock lock(FlowTable::GetFlowTableObject()->mutex());
     FlowKey key(pkt->vrf, pkt->ip_saddr, pkt->ip_daddr,
                 pkt->ip_proto, pkt->sport, pkt->dport);
     FlowEntryPtr flow(FlowTable::GetFlowTableObject()->Allocate(key));
@@ -766,6 +834,7 @@ void PktFlowInfo::RewritePktInfo(uint32_t flow_index) {
     ostr << "ECMP Resolve for flow index " << flow_index;
     PKTFLOW_TRACE(Err,ostr.str());
 
+    tbb::mutex::scoped_lock lock(FlowTable::GetFlowTableObject()->mutex());
     FlowKey key;
     if (!FlowTableKSyncObject::GetKSyncObject()->GetFlowKey(flow_index, key)) {
         std::ostringstream ostr;
@@ -808,6 +877,14 @@ bool FlowHandler::Run() {
         info.short_flow = true;
     }
 
+    // The directions of a NAT flow can hash to different partitions, set up
+    // all NAT flows on one partition so they don't race each other
+    if (info.nat_done &&
+        Agent::GetInstance()->GetFlowProto()->MoveToNatPartition(pkt_info_)) {
+        pkt_info_ = NULL;
+        return true;
+    }
+
     if (in.rt_) {
         const AgentPath *path = in.rt_->GetActivePath();
         info.source_sg_id_l = &(path->GetSecurityGroupList());
@@ -884,8 +961,7 @@ void PktFlowInfo::InitFwdFlow(FlowEntry *flow, const PktInfo *pkt,
     flow->intf_in = pkt->GetAgentHdr().ifindex;
 
     flow->data.ingress = ingress;
-    flow->data.source_vn = *(source_vn);
-    flow->data.dest_vn = *(dest_vn);
+    flow->data.SetVn(*(source_vn), *(dest_vn));
     flow->data.source_sg_id_l = *(source_sg_id_l);
     flow->data.dest_sg_id_l = *(dest_sg_id_l);
     flow->data.flow_source_vrf = flow_source_vrf;
@@ -916,8 +992,7 @@ void PktFlowInfo::InitRevFlow(FlowEntry *flow, const PktInfo *pkt,
     if (ctrl->intf_) {
         flow->data.ingress = ComputeDirection(ctrl->intf_);
     }
-    flow->data.source_vn = *(dest_vn);
-    flow->data.dest_vn = *(source_vn);
+    flow->data.SetVn(*(dest_vn), *(source_vn));
     flow->data.source_sg_id_l = *(dest_sg_id_l);
     flow->data.dest_sg_id_l = *(source_sg_id_l);
     flow->data.flow_source_vrf = flow_dest_vrf;
@@ -6,6 +6,8 @@
 #define vnsw_agent_pkt_flow_hpp
 
 #include <net/if.h>
+#include <vector>
+#include <tbb/atomic.h>
 #include "cmn/agent_cmn.h"
 #include "base/queue_task.h"
 #include "pkt/proto.h"
@@ -27,21 +29,31 @@ public:
 private:
 };
 
+// Flow setup is split into partitions, each with its own work queue served
+// by a separate instance of the Agent::FlowHandler task. A packet goes to
+// the partition picked by a symmetric hash of its 5-tuple, so packets of a
+// flow and of its reverse flow are handled in order by one partition as
+// long as the reverse flow uses the same addresses and ports. That does not
+// hold for NAT flows, whose reverse key carries the translated addresses.
+// Whether a packet needs NAT is only known after its lookups, so a NAT
+// packet found on another partition is handed to kNatPartition, and both
+// directions of every NAT flow are set up there one after the other.
+// FlowTable updates are made under the FlowTable mutex either way.
 class FlowProto : public Proto<FlowHandler> {
 public:
-    FlowProto(boost::asio::io_service &io) :
-        Proto<FlowHandler>("Agent::FlowHandler", PktHandler::FLOW, io) {};
+    static const int kMaxPartitions = 16;
+    static const int kNatPartition = 0;
 
-    virtual ~FlowProto() {};
+    struct PartitionStats {
+        PartitionStats() { pkts = 0; }
+        tbb::atomic<uint64_t> pkts;
+    };
 
-    static void Init(boost::asio::io_service &io) {
-        Agent::GetInstance()->SetFlowProto(new FlowProto(io));
-    }
+    FlowProto(boost::asio::io_service &io, int partition_count);
+    virtual ~FlowProto();
 
-    static void Shutdown() {
-        delete Agent::GetInstance()->GetFlowProto();
-        Agent::GetInstance()->SetFlowProto(NULL);
-    }
+    static void Init(boost::asio::io_service &io);
+    static void Shutdown();
 
     bool Validate(PktInfo *msg) {
         if (msg->ip == NULL) {
@@ -57,6 +69,23 @@ public:
     bool RemovePktBuff() {
         return true;
     }
+
+    bool EnqueueMessage(PktInfo *msg);
+    // Returns false if the caller already runs on kNatPartition, otherwise
+    // queues msg to it.
+    bool MoveToNatPartition(PktInfo *msg);
+
+    static uint32_t FlowHash(const PktInfo *msg);
+    int PartitionCount() const { return partitions_.size(); }
+    uint64_t PartitionPktCount(int partition) const {
+        return stats_[partition].pkts;
+    }
+
+private:
+    typedef WorkQueue<PktInfo *> PartitionQueue;
+
+    std::vector<PartitionQueue *> partitions_;
+    PartitionStats stats_[kMaxPartitions];
 };
 
 extern SandeshTraceBufferPtr PktFlowTraceBuf;
@@ -34,7 +34,8 @@ const std::size_t PktTrace::pkt_trace_size;
 
 PktHandler::PktHandler(DB *db, const std::string &if_name,
                        boost::asio::io_service &io_serv, bool run_with_vrouter) 
-                      : stats_(), db_(db) {
+                      : stats_(), rate_start_(UTCTimestampUsec()), db_(db) {
+    memset(rate_count_, 0, sizeof(rate_count_));
     if (run_with_vrouter)
         tap_ = new TapInterface(if_name, io_serv, 
                    boost::bind(&PktHandler::HandleRcvPkt, this, _1, _2));
@@ -173,6 +174,7 @@ void PktHandler::HandleRcvPkt(uint8_t *ptr, std::size_t len) {
 
 enqueue:
     stats_.PktRcvd(mod);
+    UpdateRate(mod);
     pkt_trace_.at(mod).AddPktTrace(PktTrace::In, 
             pkt_info->len, pkt_info->pkt);
 
@@ -447,6 +449,22 @@ uint32_t PktHandler::GetModuleStats(ModuleName mod) {
     return 0;
 }
 
+// Called for every packet received. The per module rates are refreshed
+// once kRateInterval has passed since the last refresh.
+void PktHandler::UpdateRate(ModuleName mod) {
+    rate_count_[mod]++;
+    uint64_t now = UTCTimestampUsec();
+    uint64_t elapsed = now - rate_start_;
+    if (elapsed < kRateInterval) {
+        return;
+    }
+    for (int i = 0; i < MAX_MODULES; i++) {
+        stats_.rcvd_pps[i] = (uint64_t)rate_count_[i] * 1000000 / elapsed;
+        rate_count_[i] = 0;
+    }
+    rate_start_ = now;
+}
+
 void PktHandler::PktStats::PktRcvd(ModuleName mod) {
     total_rcvd++;
     switch(mod) {
@@ -20,6 +20,7 @@
 #include <filter/acl.h>
 #include <oper/mirror_table.h>
 #include "tap_itf.h"
+#include "pkt_pool.h"
 #include "vr_defs.h"
 #define ALL_ONES_IP_ADDR "255.255.255.255"
 #define GW_IP_ADDR       "169.254.1.1"
@@ -148,7 +149,22 @@ struct PktInfo {
     }
 
     virtual ~PktInfo() {
-        if (pkt) delete [] pkt;
+        PktBufferPool::Free(pkt);
+    }
+
+    // PktInfo objects are recycled through PktInfoPool
+    static void *operator new(std::size_t size) {
+        if (size != sizeof(PktInfo))
+            return ::operator new(size);
+        return PktInfoPool::Alloc(size);
+    }
+
+    static void operator delete(void *ptr, std::size_t size) {
+        if (size != sizeof(PktInfo)) {
+            ::operator delete(ptr);
+            return;
+        }
+        PktInfoPool::Free(ptr);
     }
 
     const AgentHdr &GetAgentHdr() const {return agent_hdr;};
@@ -232,6 +248,9 @@ public:
         MAX_MODULES
     };
 
+    // Interval over which packets per second are computed, in usec
+    static const uint64_t kRateInterval = 1000000;
+
     struct PktStats {
         uint32_t total_rcvd;
         uint32_t flow_rcvd;
@@ -247,10 +266,12 @@ public:
         uint32_t dns_sent;
         uint32_t icmp_sent;
         uint32_t diag_sent;
+        uint32_t rcvd_pps[MAX_MODULES];
         void Reset() {
             total_rcvd = dhcp_rcvd = arp_rcvd = dns_rcvd = flow_rcvd = dropped =
             dhcp_sent = arp_sent = dns_sent = icmp_rcvd = icmp_sent = 0;
             total_sent = 0;
+            memset(rcvd_pps, 0, sizeof(rcvd_pps));
         }
         PktStats() { Reset(); }
         void PktRcvd(ModuleName mod);
@@ -307,6 +328,7 @@ public:
     bool IsGwPacket(const Interface *intf, PktInfo *pkt_info);
 
     PktStats GetStats() { return stats_; }
+    uint32_t GetModuleRate(ModuleName mod) { return stats_.rcvd_pps[mod]; }
     uint32_t GetModuleStats(ModuleName mod);
     void ClearStats() { stats_.Reset(); }
     void PktTraceIterate(ModuleName mod, PktTraceCallback cb) {
@@ -334,11 +356,15 @@ private:
     int ParseMPLSoGRE(PktInfo *pkt_info, uint8_t *pkt);
     int ParseMPLSoUDP(PktInfo *pkt_info, uint8_t *pkt);
     bool IsDHCPPacket(PktInfo *pkt_info);
+    void UpdateRate(ModuleName mod);
 
     // handlers for each module type
     boost::array<RcvQueueFunc, MAX_MODULES> enqueue_cb_;
 
     PktStats stats_;
+    // Packets received per module since rate_start_, for rcvd_pps
+    uint64_t rate_start_;
+    uint32_t rate_count_[MAX_MODULES];
     boost::array<PktTrace, MAX_MODULES> pkt_trace_;
 
     DB *db_;
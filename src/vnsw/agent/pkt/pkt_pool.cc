@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "pkt/pkt_pool.h"
+
+using tbb::mutex;
+
+const std::size_t PktBufferPool::kBufferCount;
+const std::size_t PktBufferPool::kBufferSize;
+const std::size_t PktInfoPool::kMaxFree;
+
+PktBufferPool PktBufferPool::pool_;
+PktInfoPool PktInfoPool::pool_;
+
+PktBufferPool::PktBufferPool() : slab_(NULL) {
+    heap_allocs_ = 0;
+}
+
+PktBufferPool::~PktBufferPool() {
+    delete [] slab_;
+}
+
+uint8_t *PktBufferPool::Alloc() {
+    {
+        mutex::scoped_lock lock(pool_.mutex_);
+        if (pool_.slab_ == NULL) {
+            pool_.slab_ = new uint8_t[kBufferCount * kBufferSize];
+            pool_.free_list_.reserve(kBufferCount);
+            for (std::size_t i = kBufferCount; i > 0; i--) {
+                pool_.free_list_.push_back(pool_.slab_ + (i - 1) * kBufferSize);
+            }
+        }
+        if (!pool_.free_list_.empty()) {
+            uint8_t *buf = pool_.free_list_.back();
+            pool_.free_list_.pop_back();
+            return buf;
+        }
+    }
+    pool_.heap_allocs_++;
+    return new uint8_t[kBufferSize];
+}
+
+void PktBufferPool::Free(uint8_t *buf) {
+    if (buf == NULL) {
+        return;
+    }
+    {
+        mutex::scoped_lock lock(pool_.mutex_);
+        if (pool_.InSlab(buf)) {
+            pool_.free_list_.push_back(buf);
+            return;
+        }
+    }
+    delete [] buf;
+}
+
+std::size_t PktBufferPool::FreeCount() {
+    mutex::scoped_lock lock(pool_.mutex_);
+    if (pool_.slab_ == NULL) {
+        return kBufferCount;
+    }
+    return pool_.free_list_.size();
+}
+
+PktInfoPool::~PktInfoPool() {
+    for (std::vector<void *>::iterator it = free_list_.begin();
+         it != free_list_.end(); ++it) {
+        ::operator delete(*it);
+    }
+}
+
+void *PktInfoPool::Alloc(std::size_t size) {
+    {
+        mutex::scoped_lock lock(pool_.mutex_);
+        if (!pool_.free_list_.empty()) {
+            void *ptr = pool_.free_list_.back();
+            pool_.free_list_.pop_back();
+            return ptr;
+        }
+    }
+    return ::operator new(size);
+}
+
+void PktInfoPool::Free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    {
+        mutex::scoped_lock lock(pool_.mutex_);
+        if (pool_.free_list_.size() < kMaxFree) {
+            pool_.free_list_.push_back(ptr);
+            return;
+        }
+    }
+    ::operator delete(ptr);
+}
+
+std::size_t PktInfoPool::FreeCount() {
+    mutex::scoped_lock lock(pool_.mutex_);
+    return pool_.free_list_.size();
+}
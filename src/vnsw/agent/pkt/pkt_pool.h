@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_pkt_pool_hpp
+#define vnsw_agent_pkt_pool_hpp
+
+#include <stdint.h>
+#include <vector>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
+#include <base/util.h>
+
+// Fixed pool of receive buffers for packets trapped to the agent.
+//
+// The buffers are carved out of one slab allocated on first use. A buffer
+// handed out by Alloc() may travel with its PktInfo to any module and be
+// freed from there, so every place that releases a packet buffer calls
+// Free(), which returns slab buffers to the pool and deletes any other
+// buffer. When the pool is empty Alloc() falls back to the heap.
+class PktBufferPool {
+public:
+    static const std::size_t kBufferCount = 1024;
+    static const std::size_t kBufferSize = 9060;
+
+    static uint8_t *Alloc();
+    static void Free(uint8_t *buf);
+
+    static std::size_t FreeCount();
+    static uint64_t HeapAllocs() { return pool_.heap_allocs_; }
+
+private:
+    PktBufferPool();
+    ~PktBufferPool();
+
+    bool InSlab(const uint8_t *buf) const {
+        return (slab_ != NULL && buf >= slab_ &&
+                buf < slab_ + kBufferCount * kBufferSize);
+    }
+
+    static PktBufferPool pool_;
+
+    tbb::mutex mutex_;
+    uint8_t *slab_;
+    std::vector<uint8_t *> free_list_;
+    tbb::atomic<uint64_t> heap_allocs_;
+
+    DISALLOW_COPY_AND_ASSIGN(PktBufferPool);
+};
+
+// Free list of PktInfo objects, used by the PktInfo allocation operators.
+// Only objects of one size may be pooled.
+class PktInfoPool {
+public:
+    static const std::size_t kMaxFree = 1024;
+
+    static void *Alloc(std::size_t size);
+    static void Free(void *ptr);
+    static std::size_t FreeCount();
+
+private:
+    PktInfoPool() { }
+    ~PktInfoPool();
+
+    static PktInfoPool pool_;
+
+    tbb::mutex mutex_;
+    std::vector<void *> free_list_;
+
+    DISALLOW_COPY_AND_ASSIGN(PktInfoPool);
+};
+
+#endif // vnsw_agent_pkt_pool_hpp
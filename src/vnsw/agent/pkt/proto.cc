@@ -125,7 +125,7 @@ void ProtoHandler::Send(uint16_t len, uint16_t itf, uint16_t vrf,
     len += IPC_HDR_LEN;
 
     if (PktHandler::GetPktHandler() == NULL)  {
-        delete [] pkt_info_->pkt;
+        PktBufferPool::Free(pkt_info_->pkt);
     } else {
         PktHandler::GetPktHandler()->Send(pkt_info_->pkt, len, mod);
     }
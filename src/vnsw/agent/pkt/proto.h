@@ -51,8 +51,7 @@ public:
         }
 
         if (RemovePktBuff()) {
-            if (msg->pkt)
-                delete [] msg->pkt;
+            PktBufferPool::Free(msg->pkt);
             msg->pkt = NULL;
             msg->eth = NULL;
             msg->arp = NULL;
@@ -61,9 +60,13 @@ public:
             msg->data = NULL;
         }
 
-        return work_queue_.Enqueue(msg);
+        return EnqueueMessage(msg);
     };
 
+    virtual bool EnqueueMessage(PktInfo *msg) {
+        return work_queue_.Enqueue(msg);
+    }
+
     bool ProcessProto(PktInfo *msg_info) {
         Handler *handler = new Handler(msg_info, io_);
         if (handler->Run())
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <assert.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -14,6 +15,8 @@
 #include <linux/if_tun.h>
 #include <linux/if_packet.h>
 
+#include <boost/static_assert.hpp>
+
 #include "base/logging.h"
 #include "cmn/agent_cmn.h"
 #include "tap_itf.h"
@@ -23,6 +26,8 @@
 #include "pkt/pkt_types.h"
 #include "pkt_init.h"
 
+BOOST_STATIC_ASSERT(PktBufferPool::kBufferSize >= TapInterface::max_packet_size);
+
 #define TUN_INTF_CLONE_DEV "/dev/net/tun"
 
 #define TAP_TRACE(obj, ...)                                              \
@@ -40,9 +45,17 @@ TapInterface::TapInterface(const std::string &name,
     input_.assign(tap_.Id(), ec);
     assert(ec == 0);
 
+    // Needed by ReadBatch to drain the descriptor without blocking
+    int flags = fcntl(tap_.Id(), F_GETFL, 0);
+    fcntl(tap_.Id(), F_SETFL, flags | O_NONBLOCK);
+
     AsyncRead();
 }
 
+TapInterface::~TapInterface() {
+    PktBufferPool::Free(read_buf_);
+}
+
 void TapInterface::AsyncWrite(uint8_t *buf, std::size_t len) {
     input_.async_write_some(boost::asio::buffer(buf, len), 
                             boost::bind(&TapInterface::WriteHandler, this,
@@ -56,13 +69,29 @@ void TapInterface::WriteHandler(const boost::system::error_code &error,
     if (error)
         TAP_TRACE(Err, 
                   "Packet Tap Error <" + error.message() + "> sending packet");
-    delete [] buf;
+    PktBufferPool::Free(buf);
+}
+
+// Hand up the packets already queued on the descriptor, up to
+// kMaxReadBatch, before going back to the io_service for the next one.
+void TapInterface::ReadBatch() {
+    for (int i = 0; i < kMaxReadBatch; i++) {
+        uint8_t *buf = PktBufferPool::Alloc();
+        ssize_t length = read(tap_.Id(), buf, max_packet_size);
+        if (length <= 0) {
+            PktBufferPool::Free(buf);
+            break;
+        }
+        pkt_handler_(buf, length);
+    }
 }
 
 void TapInterface::ReadHandler(const boost::system::error_code &error,
                               std::size_t length) {
     if (!error) {
         pkt_handler_(read_buf_, length);
+        read_buf_ = NULL;
+        ReadBatch();
     } else  {
         TAP_TRACE(Err, 
                   "Packet Tap Error <" + error.message() + "> reading packet");
@@ -75,7 +104,9 @@ void TapInterface::ReadHandler(const boost::system::error_code &error,
 }
 
 void TapInterface::AsyncRead() {
-    read_buf_ = new uint8_t[max_packet_size];
+    if (read_buf_ == NULL) {
+        read_buf_ = PktBufferPool::Alloc();
+    }
     input_.async_read_some(
             boost::asio::buffer(read_buf_, max_packet_size), 
             boost::bind(&TapInterface::ReadHandler, this,
@@ -10,6 +10,8 @@
 #include <boost/function.hpp>
 #include <boost/asio.hpp>
 
+#include "pkt/pkt_pool.h"
+
 #define MAC_ALEN 6
 
 class TapDescriptor {
@@ -26,15 +28,13 @@ private:
 class TapInterface {
 public:
     enum { max_packet_size = 9060 };
+    // Packets read without blocking after each asynchronous read completes
+    static const int kMaxReadBatch = 32;
     typedef boost::function<void(uint8_t*, std::size_t)> PktReadCallback;
 
     TapInterface(const std::string &name, boost::asio::io_service &io, 
                  PktReadCallback cb);
-    virtual ~TapInterface() { 
-        if (read_buf_) {
-            delete [] read_buf_;
-        }
-    }
+    virtual ~TapInterface();
 
     virtual void AsyncWrite(uint8_t *buf, std::size_t len);
     unsigned char *MacAddr() { return tap_.MacAddr(); }
@@ -44,6 +44,7 @@ protected:
     void SetupTap(const std::string& name);
     void AsyncRead();
     void ReadHandler(const boost::system::error_code &err, std::size_t length);
+    void ReadBatch();
     void WriteHandler(const boost::system::error_code &err, std::size_t length,
 		              uint8_t *buf);
 
@@ -154,7 +155,7 @@ private:
                 err.message() << "> sending packet");
             assert(0);
         }
-        delete [] buf;
+        PktBufferPool::Free(buf);
     }
     uint32_t agent_rcv_port_;
     boost::system::error_code ec_;
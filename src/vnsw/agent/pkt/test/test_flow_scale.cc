@@ -74,6 +74,64 @@ TEST_F(FlowTest, FlowScaling_1) {
              (count == flow_count + FlowTable::GetFlowTableObject()->Size()));
 }
 
+// Packets of a flow and its reverse flow go to the same partition
+TEST_F(FlowTest, FlowPartitionHash) {
+    PktInfo fwd;
+    fwd.ip_saddr = 0x01010101;
+    fwd.ip_daddr = 0x05000001;
+    fwd.ip_proto = IPPROTO_UDP;
+    fwd.sport = 1000;
+    fwd.dport = 2000;
+
+    PktInfo rev;
+    rev.ip_saddr = fwd.ip_daddr;
+    rev.ip_daddr = fwd.ip_saddr;
+    rev.ip_proto = fwd.ip_proto;
+    rev.sport = fwd.dport;
+    rev.dport = fwd.sport;
+    EXPECT_EQ(FlowProto::FlowHash(&fwd), FlowProto::FlowHash(&rev));
+
+    rev.sport = fwd.sport;
+    rev.dport = fwd.dport;
+    EXPECT_NE(FlowProto::FlowHash(&fwd), FlowProto::FlowHash(&rev));
+}
+
+// Flow setup rate for packets spread across all partitions
+TEST_F(FlowTest, FlowSetupRate) {
+    char env[100];
+    int count = 1000;
+    if (getenv("AGENT_FLOW_SCALE_COUNT")) {
+        strcpy(env, getenv("AGENT_FLOW_SCALE_COUNT"));
+        count = strtoul(env, NULL, 0);
+    }
+    FlowProto *proto = Agent::GetInstance()->GetFlowProto();
+    uint64_t pkts = 0;
+    for (int i = 0; i < proto->PartitionCount(); i++) {
+        pkts += proto->PartitionPktCount(i);
+    }
+
+    uint64_t start = UTCTimestampUsec();
+    for (int i = 0; i < count; i++) {
+        Ip4Address addr(0x05000000 + (i >> 8));
+        TxUdpPacket(vnet->GetInterfaceId(), vnet_addr,
+                    addr.to_string().c_str(), 1024 + (i & 0xFF), 80);
+    }
+    WAIT_FOR(count * 2, 10000,
+             ((size_t)count * 2 == FlowTable::GetFlowTableObject()->Size()));
+    uint64_t usec = UTCTimestampUsec() - start;
+
+    uint64_t new_pkts = 0;
+    for (int i = 0; i < proto->PartitionCount(); i++) {
+        new_pkts += proto->PartitionPktCount(i);
+        LOG(DEBUG, "Partition " << i << " packets "
+            << proto->PartitionPktCount(i));
+    }
+    EXPECT_EQ((uint64_t)count, new_pkts - pkts);
+    LOG(DEBUG, count << " flows setup in " << usec << " usec with "
+        << proto->PartitionCount() << " partitions, "
+        << (usec ? (count * 1000000ULL / usec) : 0) << " flows/sec");
+}
+
 int main(int argc, char *argv[]) {
     int ret = 0;
 
@@ -226,8 +226,7 @@ public:
         t->InitFlowKey(&key);
         FlowEntry *flow = FlowTable::GetFlowTableObject()->Allocate(key);
 
-        flow->data.source_vn = *t->svn_;
-        flow->data.dest_vn = *t->dvn_;
+        flow->data.SetVn(*t->svn_, *t->dvn_);
         flow->data.vn_entry = VnGet(t->vn_);
         flow->data.intf_entry = VmPortGet(t->ifindex_);
         flow->data.vm_entry = VmGet(t->vm_);
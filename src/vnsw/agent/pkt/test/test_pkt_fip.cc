@@ -580,6 +580,34 @@ TEST_F(FlowTest, FipFabricToVm_1) {
                                 "vn2", "vn2"));
 }
 
+// Both directions of NAT flows trapped together. The reverse packets carry
+// the floating-ip and can hash to another flow partition than the forward
+// packets, both must still set up the same flow pair.
+TEST_F(FlowTest, FipBothDirections_1) {
+    const int kFlowCount = 32;
+    EXPECT_EQ(0U, FlowTable::GetFlowTableObject()->Size());
+
+    for (int i = 0; i < kFlowCount; i++) {
+        TxTcpPacket(vnet[1]->GetInterfaceId(), vnet_addr[1], vnet_addr[3],
+                    1000 + i, 80, 2 * i + 1);
+        TxTcpPacket(vnet[3]->GetInterfaceId(), vnet_addr[3], "2.1.1.100",
+                    80, 1000 + i, 2 * i + 2);
+    }
+    client->WaitForIdle();
+    EXPECT_EQ((size_t)(2 * kFlowCount),
+              FlowTable::GetFlowTableObject()->Size());
+
+    for (int i = 0; i < kFlowCount; i++) {
+        EXPECT_TRUE(NatValidateFlow(-1, vnet[1]->GetVrf()->GetName().c_str(),
+                                    vnet_addr[1], vnet_addr[3], IPPROTO_TCP,
+                                    1000 + i, 80, 1,
+                                    vnet[3]->GetVrf()->GetName().c_str(),
+                                    "2.1.1.100", vnet_addr[3], 1000 + i, 80,
+                                    "vn2", "vn2"));
+    }
+    EXPECT_EQ(0U, FlowTable::GetFlowTableObject()->Size());
+}
+
 // NAT Flow aging
 TEST_F(FlowTest, FlowAging_1) {
     EXPECT_EQ(0U, FlowTable::GetFlowTableObject()->Size());
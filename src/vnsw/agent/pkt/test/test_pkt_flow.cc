@@ -723,6 +723,88 @@ TEST_F(FlowTest, FlowAge_2) {
         GetFlowStatsCollector()->SetFlowAgeTime(bkp_age_time);
 }
 
+// Stats of flows in the kernel table are picked up by the index sweep
+TEST_F(FlowTest, FlowAge_Sweep) {
+    FlowStatsCollector *collector =
+        AgentUve::GetInstance()->GetFlowStatsCollector();
+
+    TestFlow flow[] = {
+        {
+            TestFlowPkt(vm1_ip, vm2_ip, 1, 0, 0, "vrf5", 
+                    flow0->GetInterfaceId(), 1),
+            { }
+        },
+        {
+            TestFlowPkt(vm2_ip, vm1_ip, 1, 0, 0, "vrf5", 
+                    flow1->GetInterfaceId(), 2),
+            { }
+        }
+    };
+
+    CreateFlow(flow, 2);
+    EXPECT_EQ(2U, FlowTable::GetFlowTableObject()->Size());
+    client->EnqueueFlowAge();
+    client->WaitForIdle();
+
+    KSyncSockTypeMap::IncrFlowStats(1, 1, 30);
+    client->EnqueueFlowAge();
+    client->WaitForIdle();
+
+    //Each run sweeps the whole test flow table
+    EXPECT_LE(2U, collector->last_sweep_active());
+    EXPECT_LE(1U, collector->last_sweep_changed());
+    EXPECT_EQ(0U, collector->last_sweep_aged());
+    EXPECT_TRUE(FlowStatsMatch("vrf5", vm1_ip, vm2_ip, 1, 0, 0, 2, 60));
+    EXPECT_TRUE(FlowStatsMatch("vrf5", vm2_ip, vm1_ip, 1, 0, 0, 1, 30));
+
+    client->EnqueueFlowFlush();
+    client->WaitForIdle();
+    EXPECT_EQ(0U, FlowTable::GetFlowTableObject()->Size());
+}
+
+// Flow records are batched when the export batch size is set
+TEST_F(FlowTest, FlowExportBatch) {
+    FlowStatsCollector *collector =
+        AgentUve::GetInstance()->GetFlowStatsCollector();
+    collector->SetFlowExportConfig(64, 1000 * 1000, 1);
+    uint64_t records = collector->export_records();
+    uint64_t msgs = collector->export_msgs();
+
+    TestFlow flow[] = {
+        {
+            TestFlowPkt(vm1_ip, vm2_ip, 1, 0, 0, "vrf5", 
+                    flow0->GetInterfaceId(), 1),
+            { }
+        },
+        {
+            TestFlowPkt(vm2_ip, vm1_ip, 1, 0, 0, "vrf5", 
+                    flow1->GetInterfaceId(), 2),
+            { }
+        }
+    };
+
+    CreateFlow(flow, 2);
+    EXPECT_EQ(2U, FlowTable::GetFlowTableObject()->Size());
+    EXPECT_LT(records, collector->export_records());
+    EXPECT_EQ(msgs, collector->export_msgs());
+
+    // Changing the batch size sends the records batched so far
+    collector->SetFlowExportConfig(32, 1000 * 1000, 1);
+    EXPECT_EQ(msgs + 1, collector->export_msgs());
+    collector->SetFlowExportConfig(32, 1000 * 1000, 1);
+    EXPECT_EQ(msgs + 1, collector->export_msgs());
+
+    // Nothing is left to flush
+    collector->FlushFlowExport();
+    EXPECT_EQ(msgs + 1, collector->export_msgs());
+
+    client->EnqueueFlowFlush();
+    client->WaitForIdle();
+    EXPECT_EQ(0U, FlowTable::GetFlowTableObject()->Size());
+    collector->SetFlowExportConfig(FlowStatsCollector::FlowExportBatchSize,
+                                   FlowStatsCollector::FlowExportDelay, 1);
+}
+
 // Aging with more than 2 entries
 TEST_F(FlowTest, FlowAge_3) {
     int tmp_age_time = 10 * 1000;
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <vector>
+
+#include "base/logging.h"
+#include "pkt/pkt_pool.h"
+
+#include "testing/gunit.h"
+
+struct TestPkt {
+    TestPkt() : data() { }
+    static void *operator new(std::size_t size) {
+        return PktInfoPool::Alloc(size);
+    }
+    static void operator delete(void *ptr) {
+        PktInfoPool::Free(ptr);
+    }
+    char data[256];
+};
+
+class PktPoolTest : public ::testing::Test {
+};
+
+TEST_F(PktPoolTest, Buffers) {
+    std::size_t free_count = PktBufferPool::FreeCount();
+    uint64_t heap_allocs = PktBufferPool::HeapAllocs();
+
+    // Buffers come back to the pool and are reused
+    uint8_t *buf = PktBufferPool::Alloc();
+    EXPECT_EQ(free_count - 1, PktBufferPool::FreeCount());
+    PktBufferPool::Free(buf);
+    EXPECT_EQ(free_count, PktBufferPool::FreeCount());
+    EXPECT_EQ(buf, PktBufferPool::Alloc());
+    PktBufferPool::Free(buf);
+
+    // Once the pool is empty buffers come from the heap
+    std::vector<uint8_t *> bufs;
+    for (std::size_t i = 0; i < PktBufferPool::kBufferCount + 8; i++) {
+        bufs.push_back(PktBufferPool::Alloc());
+    }
+    EXPECT_EQ(0U, PktBufferPool::FreeCount());
+    EXPECT_EQ(heap_allocs + 8, PktBufferPool::HeapAllocs());
+    for (std::size_t i = 0; i < bufs.size(); i++) {
+        PktBufferPool::Free(bufs[i]);
+    }
+    EXPECT_EQ(PktBufferPool::kBufferCount, PktBufferPool::FreeCount());
+
+    // Buffers not from the pool are deleted
+    PktBufferPool::Free(new uint8_t[64]);
+    EXPECT_EQ(PktBufferPool::kBufferCount, PktBufferPool::FreeCount());
+}
+
+TEST_F(PktPoolTest, PktInfo) {
+    TestPkt *pkt = new TestPkt();
+    std::size_t free_count = PktInfoPool::FreeCount();
+    delete pkt;
+    EXPECT_EQ(free_count + 1, PktInfoPool::FreeCount());
+    TestPkt *pkt2 = new TestPkt();
+    EXPECT_EQ(pkt, pkt2);
+    EXPECT_EQ(free_count, PktInfoPool::FreeCount());
+    delete pkt2;
+}
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    return RUN_ALL_TESTS();
+}
@@ -263,7 +263,7 @@ bool ArpHandler::HandlePacket() {
             } else {
                 entry = new ArpEntry(io_, this, arp_tpa_, vrf);
                 arp_proto->Add(entry->Key(), entry);
-                delete[] pkt_info_->pkt;
+                PktBufferPool::Free(pkt_info_->pkt);
                 pkt_info_->pkt = NULL;
                 entry->HandleArpRequest();
                 return false;
@@ -287,7 +287,7 @@ bool ArpHandler::HandlePacket() {
                 entry = new ArpEntry(io_, this, arp_tpa_, vrf);
                 entry->HandleArpReply(arp_->arp_sha);
                 arp_proto->Add(entry->Key(), entry);
-                delete[] pkt_info_->pkt;
+                PktBufferPool::Free(pkt_info_->pkt);
                 pkt_info_->pkt = NULL;
                 return false;
             }
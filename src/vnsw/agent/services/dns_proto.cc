@@ -108,6 +108,7 @@ void DnsProto::IpamUpdate(IFMapNode *node) {
 }
 
 void DnsProto::VdnsUpdate(IFMapNode *node) {
+    FlushCache(node->name());
     CheckForUpdate(node->name(), node->IsDeleted());
 }
 
@@ -246,6 +247,107 @@ inline uint16_t DnsProto::GetTransId() {
     return (++xid_ == 0 ? ++xid_ : xid_);
 }
 
+// Cache a successful response to a single question query. The entry lives
+// for the smallest TTL among the records in the response.
+void DnsProto::AddCacheEntry(const std::string &vdns, const DnsItem &ques,
+                             dns_flags flags, const std::vector<DnsItem> &ans,
+                             const std::vector<DnsItem> &auth,
+                             const std::vector<DnsItem> &add) {
+    if (flags.ret != DNS_ERR_NO_ERROR || ans.empty())
+        return;
+
+    uint32_t ttl = ans[0].ttl;
+    for (unsigned int i = 0; i < ans.size(); ++i)
+        ttl = std::min(ttl, ans[i].ttl);
+    for (unsigned int i = 0; i < auth.size(); ++i)
+        ttl = std::min(ttl, auth[i].ttl);
+    for (unsigned int i = 0; i < add.size(); ++i)
+        ttl = std::min(ttl, add[i].ttl);
+    if (!ttl)
+        return;
+
+    tbb::mutex::scoped_lock lock(cache_mutex_);
+    uint64_t now = UTCTimestampUsec();
+    if (cache_.size() >= kDnsCacheMaxEntries) {
+        PurgeCache(now);
+        if (cache_.size() >= kDnsCacheMaxEntries)
+            return;
+    }
+
+    DnsCacheEntry &entry = cache_[DnsCacheKey(vdns, ques.name, ques.type)];
+    entry.flags = flags;
+    entry.ans = ans;
+    entry.auth = auth;
+    entry.add = add;
+    entry.added = now;
+    entry.expiry = now + ttl * 1000000ULL;
+}
+
+// Returns the cached response to a question, with the TTLs of the records
+// reduced by the time spent in the cache.
+bool DnsProto::FindCacheEntry(const std::string &vdns, const DnsItem &ques,
+                              dns_flags &flags, std::vector<DnsItem> &ans,
+                              std::vector<DnsItem> &auth,
+                              std::vector<DnsItem> &add) {
+    tbb::mutex::scoped_lock lock(cache_mutex_);
+    DnsCacheMap::iterator it =
+        cache_.find(DnsCacheKey(vdns, ques.name, ques.type));
+    if (it == cache_.end())
+        return false;
+
+    uint64_t now = UTCTimestampUsec();
+    DnsCacheEntry &entry = it->second;
+    if (now >= entry.expiry) {
+        cache_.erase(it);
+        return false;
+    }
+
+    uint32_t elapsed = (now - entry.added) / 1000000;
+    flags = entry.flags;
+    ans = entry.ans;
+    auth = entry.auth;
+    add = entry.add;
+    for (unsigned int i = 0; i < ans.size(); ++i)
+        ans[i].ttl -= elapsed;
+    for (unsigned int i = 0; i < auth.size(); ++i)
+        auth[i].ttl -= elapsed;
+    for (unsigned int i = 0; i < add.size(); ++i)
+        add[i].ttl -= elapsed;
+    return true;
+}
+
+// Remove the entries of a virtual DNS server, whose records have changed
+void DnsProto::FlushCache(const std::string &vdns) {
+    // entries are keyed by the name as used in queries to the server
+    std::string vdns_name(vdns);
+    BindUtil::RemoveSpecialChars(vdns_name);
+    tbb::mutex::scoped_lock lock(cache_mutex_);
+    DnsCacheMap::iterator it =
+        cache_.lower_bound(DnsCacheKey(vdns_name, "", 0));
+    while (it != cache_.end() && it->first.vdns == vdns_name)
+        cache_.erase(it++);
+}
+
+void DnsProto::ClearCache() {
+    tbb::mutex::scoped_lock lock(cache_mutex_);
+    cache_.clear();
+}
+
+uint32_t DnsProto::GetCacheSize() {
+    tbb::mutex::scoped_lock lock(cache_mutex_);
+    return cache_.size();
+}
+
+// Called with cache_mutex_ held
+void DnsProto::PurgeCache(uint64_t now) {
+    for (DnsCacheMap::iterator it = cache_.begin(); it != cache_.end();) {
+        if (now >= it->second.expiry)
+            cache_.erase(it++);
+        else
+            ++it;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 DnsHandler::DnsHandler(PktInfo *info, boost::asio::io_service &io) : 
@@ -506,11 +608,27 @@ bool DnsHandler::HandleVirtualDnsRequest(const VmPortInterface *vmitf) {
             dns_resp_size_ = BindUtil::ParseDnsQuery((uint8_t *)dns_, items_);
             resp_ptr_ = (uint8_t *)dns_ + dns_resp_size_;
             UpdateQueryNames();
-            xid_ = dns_proto->GetTransId();
-            action_ = DnsHandler::DNS_QUERY;
             BindUtil::BuildDnsHeader(dns_, ntohs(dns_->xid), DNS_QUERY_RESPONSE, 
                                      DNS_OPCODE_QUERY, 0, 1, ret, 
                                      ntohs(dns_->ques_rrcount));
+            if (items_.size() == 1) {
+                dns_flags flags;
+                std::vector<DnsItem> ques, ans, auth, add;
+                if (dns_proto->FindCacheEntry(ipam_type_.ipam_dns_server.
+                                              virtual_dns_server_name,
+                                              items_[0], flags, ans, auth,
+                                              add)) {
+                    dns_proto->IncrStatsCacheHit();
+                    DNS_BIND_TRACE(DnsBindTrace, "Query answered from cache : "
+                                   "xid = " << dns_->xid << ";" <<
+                                   DnsItemsToString(ans) << ";");
+                    Resolve(flags, ques, ans, auth, add);
+                    break;
+                }
+                dns_proto->IncrStatsCacheMiss();
+            }
+            xid_ = dns_proto->GetTransId();
+            action_ = DnsHandler::DNS_QUERY;
             if (SendDnsQuery())
                 return false;
             break;
@@ -633,6 +751,14 @@ bool DnsHandler::HandleBindResponse() {
         BindUtil::ParseDnsQuery(ipc->resp, xid, flags, ques, ans, auth, add);
         switch(handler->action_) {
             case DnsHandler::DNS_QUERY:
+                // cache before Resolve() rewrites the items for this VM
+                if (handler->items_.size() == 1) {
+                    dns_proto->AddCacheEntry(handler->ipam_type_.
+                                             ipam_dns_server.
+                                             virtual_dns_server_name,
+                                             handler->items_[0], flags,
+                                             ans, auth, add);
+                }
                 handler->Resolve(flags, ques, ans, auth, add);
                 if (flags.ret) {
                     DNS_BIND_TRACE(DnsBindError, "Query failed : " << 
@@ -865,6 +991,7 @@ void DnsHandler::UpdateGWAddress(DnsItem &item) {
 void DnsHandler::Update(DnsUpdateIpc *update) {
     bool free_update = true;
     DnsProto *dns_proto = Agent::GetInstance()->GetDnsProto();
+    dns_proto->FlushCache(update->xmpp_data->virtual_dns);
     DnsUpdateIpc *update_req = dns_proto->FindUpdateRequest(update);
     if (update_req) {
         DnsUpdateData *data = update_req->xmpp_data;
@@ -907,6 +1034,7 @@ void DnsHandler::DelUpdate(DnsUpdateIpc *update) {
     DnsProto *dns_proto = Agent::GetInstance()->GetDnsProto();
     DnsUpdateIpc *update_req = dns_proto->FindUpdateRequest(update);
     while (update_req) {
+        dns_proto->FlushCache(update_req->xmpp_data->virtual_dns);
         for (DnsItems::iterator item = update_req->xmpp_data->items.begin(); 
              item != update_req->xmpp_data->items.end(); ++item) {
             // in case of delete, set the class to NONE and ttl to 0
@@ -182,6 +182,7 @@ class DnsProto : public Proto<DnsHandler> {
 public:
     static const uint32_t kDnsTimeout = 2000;   // milli seconds
     static const uint32_t kDnsMaxRetries = 2;
+    static const uint32_t kDnsCacheMaxEntries = 1024;
 
     typedef std::map<uint32_t, DnsHandler *> DnsBindQueryMap;
     typedef std::pair<uint32_t, DnsHandler *> DnsBindQueryPair;
@@ -198,13 +199,44 @@ public:
         uint32_t unsupported;
         uint32_t fail;
         uint32_t drop;
+        uint32_t cache_hits;
+        uint32_t cache_misses;
 
         void Reset() {
             requests = resolved = retransmit_reqs = unsupported = fail = drop = 0;
+            cache_hits = cache_misses = 0;
         }
         DnsStats() { Reset(); }
     };
 
+    // Responses from the DNS server are cached per virtual DNS server,
+    // keyed by the name and type of the (single) question in the query.
+    struct DnsCacheKey {
+        std::string vdns;
+        std::string name;
+        uint16_t type;
+
+        DnsCacheKey(const std::string &v, const std::string &n, uint16_t t)
+            : vdns(v), name(n), type(t) {}
+        bool operator<(const DnsCacheKey &rhs) const {
+            if (vdns != rhs.vdns)
+                return vdns < rhs.vdns;
+            if (name != rhs.name)
+                return name < rhs.name;
+            return type < rhs.type;
+        }
+    };
+
+    struct DnsCacheEntry {
+        dns_flags flags;
+        std::vector<DnsItem> ans;
+        std::vector<DnsItem> auth;
+        std::vector<DnsItem> add;
+        uint64_t added;     // usec
+        uint64_t expiry;    // usec
+    };
+    typedef std::map<DnsCacheKey, DnsCacheEntry> DnsCacheMap;
+
     static void Init(boost::asio::io_service &io);
     static void ConfigInit();
     static void Shutdown();
@@ -262,15 +294,29 @@ public:
     void IncrStatsUnsupp() { stats_.unsupported++; }
     void IncrStatsFail() { stats_.fail++; }
     void IncrStatsDrop() { stats_.drop++; }
+    void IncrStatsCacheHit() { stats_.cache_hits++; }
+    void IncrStatsCacheMiss() { stats_.cache_misses++; }
     DnsStats GetStats() { return stats_; }
     void ClearStats() { stats_.Reset(); }
 
+    void AddCacheEntry(const std::string &vdns, const DnsItem &ques,
+                       dns_flags flags, const std::vector<DnsItem> &ans,
+                       const std::vector<DnsItem> &auth,
+                       const std::vector<DnsItem> &add);
+    bool FindCacheEntry(const std::string &vdns, const DnsItem &ques,
+                        dns_flags &flags, std::vector<DnsItem> &ans,
+                        std::vector<DnsItem> &auth, std::vector<DnsItem> &add);
+    void FlushCache(const std::string &vdns);
+    void ClearCache();
+    uint32_t GetCacheSize();
+
 private:
     DnsProto(boost::asio::io_service &io);
     void ItfUpdate(DBEntryBase *entry);
     void VnUpdate(DBEntryBase *entry);
     void CheckForUpdate(std::string name, bool is_deleted);
     std::string GetVdnsName(const VmPortInterface *vmitf);
+    void PurgeCache(uint64_t now);
 
     uint16_t xid_;
     DnsUpdateSet update_set_;
@@ -279,6 +325,9 @@ private:
     DnsStats stats_;
     uint32_t timeout_;   // milli seconds
     uint32_t max_retries_;
+    // updated from the services task, flushed from DB task on config change
+    DnsCacheMap cache_;
+    tbb::mutex cache_mutex_;
 
     VmDataMap all_vms_;
     DBTableBase::ListenerId lid_;
@@ -121,6 +121,11 @@ void ServicesSandesh::PktStatsSandesh(std::string ctxt, bool more) {
     resp->set_arp_sent(stats.arp_sent);
     resp->set_dns_sent(stats.dns_sent);
     resp->set_icmp_sent(stats.icmp_sent);
+    resp->set_flow_rcvd_pps(stats.rcvd_pps[PktHandler::FLOW]);
+    resp->set_arp_rcvd_pps(stats.rcvd_pps[PktHandler::ARP]);
+    resp->set_dhcp_rcvd_pps(stats.rcvd_pps[PktHandler::DHCP]);
+    resp->set_dns_rcvd_pps(stats.rcvd_pps[PktHandler::DNS]);
+    resp->set_icmp_rcvd_pps(stats.rcvd_pps[PktHandler::ICMP]);
     resp->set_context(ctxt);
     resp->set_more(more);
     resp->Response();
@@ -165,13 +170,17 @@ void ServicesSandesh::ArpStatsSandesh(std::string ctxt, bool more) {
 
 void ServicesSandesh::DnsStatsSandesh(std::string ctxt, bool more) {
     DnsStats *dns = new DnsStats();
-    DnsProto::DnsStats nstats = Agent::GetInstance()->GetDnsProto()->GetStats();
+    DnsProto *dns_proto = Agent::GetInstance()->GetDnsProto();
+    DnsProto::DnsStats nstats = dns_proto->GetStats();
     dns->set_dns_requests(nstats.requests);
     dns->set_dns_resolved(nstats.resolved);
     dns->set_dns_retransmit_reqs(nstats.retransmit_reqs);
     dns->set_dns_unsupported(nstats.unsupported);
     dns->set_dns_failures(nstats.fail);
     dns->set_dns_drops(nstats.drop);
+    dns->set_dns_cache_hits(nstats.cache_hits);
+    dns->set_dns_cache_misses(nstats.cache_misses);
+    dns->set_dns_cache_entries(dns_proto->GetCacheSize());
     dns->set_context(ctxt);
     dns->set_more(more);
     dns->Response();
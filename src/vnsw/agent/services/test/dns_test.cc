@@ -406,6 +406,8 @@ TEST_F(DnsTesting, VirtualDnsReqTest) {
     CHECK_CONDITION(stats.fail < 1);
     CHECK_STATS(stats, 8, 4, 2, 1, 1, 0);
 
+    // the first query was cached; clear it so that this one goes out
+    Agent::GetInstance()->GetDnsProto()->ClearCache();
     Agent::GetInstance()->GetDnsProto()->SetTimeout(30);
     Agent::GetInstance()->GetDnsProto()->SetMaxRetries(1);
     SendDnsReq(DNS_OPCODE_QUERY, GetItfId(0), 1, a_items);
@@ -441,6 +443,110 @@ TEST_F(DnsTesting, VirtualDnsReqTest) {
     Agent::GetInstance()->GetDnsProto()->ClearStats();
 }
 
+TEST_F(DnsTesting, VirtualDnsCacheTest) {
+    struct PortInfo input[] = {
+        {"vnet1", 1, "1.1.1.1", "00:00:00:01:01:01", 1, 1},
+    };
+    IpamInfo ipam_info[] = {
+        {"1.2.3.128", 27, "1.2.3.129"},
+        {"7.8.9.0", 24, "7.8.9.12"},
+        {"1.1.1.0", 24, "1.1.1.200"},
+    };
+
+    char vdns_attr[] = 
+        "<virtual-DNS-data>\
+            <domain-name>test.contrail.juniper.net</domain-name>\
+            <dynamic-records-from-client>true</dynamic-records-from-client>\
+            <record-order>fixed</record-order>\
+            <default-ttl-seconds>120</default-ttl-seconds>\
+        </virtual-DNS-data>\n";
+    char ipam_attr[] = "<network-ipam-mgmt>\n <ipam-dns-method>virtual-dns-server</ipam-dns-method>\n <ipam-dns-server><virtual-dns-server-name>vdns1</virtual-dns-server-name></ipam-dns-server>\n </network-ipam-mgmt>\n";
+
+    CreateVmportEnv(input, 1, 0);
+    client->WaitForIdle();
+    client->Reset();
+    AddVDNS("vdns1", vdns_attr);
+    client->WaitForIdle();
+    AddIPAM("vn1", ipam_info, 3, ipam_attr, "vdns1");
+    client->WaitForIdle();
+
+    IntfCfgAdd(input, 0);
+    WaitForItfUpdate(1);
+
+    DnsProto *dns_proto = Agent::GetInstance()->GetDnsProto();
+    DnsProto::DnsStats stats;
+    int count = 0;
+
+    // first query goes to the server and the response is cached
+    SendDnsReq(DNS_OPCODE_QUERY, GetItfId(0), 1, &a_items[1]);
+    g_xid++;
+    usleep(1000);
+    client->WaitForIdle();
+    SendDnsResp(1, &a_items[1], 1, auth_items, 1, add_items);
+    CHECK_CONDITION(stats.resolved < 1);
+    CHECK_STATS(stats, 1, 1, 0, 0, 0, 0);
+    EXPECT_EQ(0U, stats.cache_hits);
+    EXPECT_EQ(1U, stats.cache_misses);
+    EXPECT_EQ(1U, dns_proto->GetCacheSize());
+
+    // same query is answered from the cache
+    SendDnsReq(DNS_OPCODE_QUERY, GetItfId(0), 1, &a_items[1]);
+    CHECK_CONDITION(stats.resolved < 2);
+    CHECK_STATS(stats, 2, 2, 0, 0, 0, 0);
+    EXPECT_EQ(1U, stats.cache_hits);
+    EXPECT_EQ(1U, stats.cache_misses);
+
+    // queries with more than one question are not cached
+    SendDnsReq(DNS_OPCODE_QUERY, GetItfId(0), 2, a_items);
+    g_xid++;
+    usleep(1000);
+    client->WaitForIdle();
+    SendDnsResp(2, a_items, 0, NULL, 0, NULL);
+    CHECK_CONDITION(stats.resolved < 3);
+    CHECK_STATS(stats, 3, 3, 0, 0, 0, 0);
+    EXPECT_EQ(1U, stats.cache_hits);
+    EXPECT_EQ(1U, stats.cache_misses);
+    EXPECT_EQ(1U, dns_proto->GetCacheSize());
+
+    // an update to the virtual DNS flushes its entries
+    SendDnsReq(DNS_OPCODE_UPDATE, GetItfId(0), 1, a_items, true);
+    client->WaitForIdle();
+    CHECK_CONDITION(stats.resolved < 4);
+    CHECK_STATS(stats, 4, 4, 0, 0, 0, 0);
+    EXPECT_EQ(0U, dns_proto->GetCacheSize());
+
+    SendDnsReq(DNS_OPCODE_QUERY, GetItfId(0), 1, &a_items[1]);
+    g_xid++;
+    usleep(1000);
+    client->WaitForIdle();
+    SendDnsResp(1, &a_items[1], 1, auth_items, 1, add_items);
+    CHECK_CONDITION(stats.resolved < 5);
+    CHECK_STATS(stats, 5, 5, 0, 0, 0, 0);
+    EXPECT_EQ(1U, stats.cache_hits);
+    EXPECT_EQ(2U, stats.cache_misses);
+    EXPECT_EQ(1U, dns_proto->GetCacheSize());
+
+    SendDnsReq(DNS_OPCODE_UPDATE, GetItfId(0), 1, a_items, false);
+    client->WaitForIdle();
+    CHECK_CONDITION(stats.resolved < 6);
+    EXPECT_EQ(0U, dns_proto->GetCacheSize());
+
+    client->Reset();
+    DelIPAM("vn1", "vdns1"); 
+    client->WaitForIdle();
+    DelVDNS("vdns1"); 
+    client->WaitForIdle();
+
+    client->Reset();
+    DeleteVmportEnv(input, 1, 1, 0); 
+    client->WaitForIdle();
+
+    IntfCfgDel(input, 0);
+    WaitForItfUpdate(0);
+    dns_proto->ClearCache();
+    dns_proto->ClearStats();
+}
+
 TEST_F(DnsTesting, DnsXmppTest) {
     struct PortInfo input[] = {
         {"vnet1", 1, "1.1.1.1", "00:00:00:01:01:01", 1, 1},
@@ -35,22 +35,22 @@ class StatsTestMock : public ::testing::Test {
 public:
     bool InterVnStatsMatch(string svn, string dvn, uint32_t pkts, 
                                   uint32_t bytes, bool out) {
-        InterVnStatsCollector::VnStatsSet *stats_set = 
-                AgentUve::GetInstance()->GetInterVnStatsCollector()->Find(svn);
-
-        if (!stats_set) {
+        InterVnStatsCollector::VnStatsList stats_list;
+        if (!AgentUve::GetInstance()->GetInterVnStatsCollector()->Find(svn,
+                                                             &stats_list)) {
             return false;
         }
-        VnStats key(dvn, 0, 0, false);
-        InterVnStatsCollector::VnStatsSet::iterator it = stats_set->find(&key);
-        if (it == stats_set->end()) {
+        InterVnStatsCollector::VnStatsList::iterator it = stats_list.begin();
+        while (it != stats_list.end() && it->dst_vn != dvn) {
+            it++;
+        }
+        if (it == stats_list.end()) {
             return false; 
         }
-        VnStats *stats = *it;
-        if (out && stats->out_bytes == bytes && stats->out_pkts == pkts) {
+        if (out && it->out_bytes == bytes && it->out_pkts == pkts) {
             return true;
         }
-        if (!out && stats->in_bytes == bytes && stats->in_pkts == pkts) {
+        if (!out && it->in_bytes == bytes && it->in_pkts == pkts) {
             return true;
         }
         return false;
@@ -108,11 +108,36 @@ private:
 
 class ControlNodeMockBgpXmppPeer {
 public:
-    ControlNodeMockBgpXmppPeer() : channel_ (NULL), rx_count_(0) {
+    ControlNodeMockBgpXmppPeer() : channel_ (NULL), rx_count_(0),
+        publish_count_(0), publish_items_(0), max_publish_items_(0) {
     }
 
     void ReceiveUpdate(const XmppStanza::XmppMessage *msg) {
         rx_count_++;
+        if (msg->type != XmppStanza::IQ_STANZA) {
+            return;
+        }
+
+        const XmppStanza::XmppMessageIq *iq =
+            static_cast<const XmppStanza::XmppMessageIq *>(msg);
+        if (iq->action == "publish") {
+            XmlPugi *pugi = static_cast<XmlPugi *>(msg->dom.get());
+            xml_node publish = pugi->FindNode("publish");
+            size_t items = 0;
+            for (xml_node item = publish.child("item"); item;
+                 item = item.next_sibling("item")) {
+                items++;
+            }
+            publish_node_ = iq->node;
+            publish_items_ += items;
+            if (items > max_publish_items_) {
+                max_publish_items_ = items;
+            }
+            publish_count_++;
+        } else if (iq->action == "collection") {
+            collection_node_ = iq->node;
+            collection_as_node_ = iq->as_node;
+        }
     }    
 
     void HandleXmppChannelEvent(XmppChannel *channel,
@@ -142,11 +167,27 @@ public:
     }
 
     size_t Count() const { return rx_count_; }
+    size_t publish_count() const { return publish_count_; }
+    size_t publish_items() const { return publish_items_; }
+    size_t max_publish_items() const { return max_publish_items_; }
+    const std::string &publish_node() const { return publish_node_; }
+    const std::string &collection_node() const { return collection_node_; }
+    const std::string &collection_as_node() const {
+        return collection_as_node_;
+    }
+    void reset_max_publish_items() { max_publish_items_ = 0; }
+
     virtual ~ControlNodeMockBgpXmppPeer() {
     }
 private:
     XmppChannel *channel_;
     size_t rx_count_;
+    size_t publish_count_;
+    size_t publish_items_;
+    size_t max_publish_items_;
+    std::string publish_node_;
+    std::string collection_node_;
+    std::string collection_as_node_;
 };
 
 
@@ -674,6 +715,87 @@ TEST_F(AgentXmppUnitTest, ConnectionUpDown) {
     EXPECT_FALSE(VrfFind("vrf1"));
 }
 
+TEST_F(AgentXmppUnitTest, RouteBatch) {
+
+    client->Reset();
+    client->WaitForIdle();
+
+    XmppConnectionSetUp();
+    //wait for connection establishment
+    WAIT_FOR(100, 10000, (sconnection->GetStateMcState() == xmsm::ESTABLISHED));
+    WAIT_FOR(100, 10000, (cchannel->GetPeerState() == xmps::READY));
+
+    struct PortInfo input[] = {
+        {"vnet1", 1, "1.1.1.1", "00:00:00:01:01:01", 1, 1},
+    };
+
+    //Create vn,vrf,vm,vm-port and route entry in vrf1 
+    CreateVmportEnv(input, 1);
+    client->WaitForIdle();
+
+    AgentXmppChannel *ch = static_cast<AgentXmppChannel *>(bgp_peer.get());
+    WAIT_FOR(100, 10000, (ch->route_publish_items() == 1));
+    WAIT_FOR(100, 10000, (mock_peer.get()->publish_items() == 1));
+    EXPECT_EQ(1U, ch->route_publish_msgs());
+    EXPECT_EQ(1U, mock_peer.get()->publish_count());
+
+    // Routes are published on an af/safi/vrf node, which is associated
+    // with the vrf collection
+    stringstream node;
+    node << BgpAf::IPv4 << "/" << BgpAf::Unicast << "/" << "vrf1";
+    EXPECT_EQ(node.str(), mock_peer.get()->publish_node());
+    WAIT_FOR(100, 10000, (mock_peer.get()->collection_node() == "vrf1"));
+    EXPECT_EQ(node.str(), mock_peer.get()->collection_as_node());
+
+    // Updates for the vrf are batched, up to kMaxRouteBatch per publish
+    Ip4Address addr = Ip4Address::from_string("1.1.1.1");
+    Inet4UcRoute *rt = RouteGet("vrf1", addr, 32);
+    ASSERT_TRUE(rt != NULL);
+    const size_t kRouteCount = 4 * AgentXmppChannel::kMaxRouteBatch;
+    for (size_t i = 0; i < kRouteCount; i++) {
+        AgentXmppChannel::ControllerSendRoute(ch, rt, "vn1",
+                                              rt->GetMplsLabel(), NULL, true);
+    }
+    ch->FlushRouteBatch();
+    EXPECT_EQ(1U + kRouteCount, ch->route_publish_items());
+    EXPECT_LE(1U + 4, ch->route_publish_msgs());
+    EXPECT_GT(1U + kRouteCount, ch->route_publish_msgs());
+    WAIT_FOR(100, 10000,
+             (mock_peer.get()->publish_items() == 1 + kRouteCount));
+    EXPECT_EQ(ch->route_publish_msgs(), mock_peer.get()->publish_count());
+    EXPECT_GE(AgentXmppChannel::kMaxRouteBatch,
+              mock_peer.get()->max_publish_items());
+
+    // Large route items are split across publishes, so that each one fits
+    // in the encode buffer
+    SecurityGroupList sg_list;
+    for (int i = 0; i < 512; i++) {
+        sg_list.push_back(8000000 + i);
+    }
+    mock_peer.get()->reset_max_publish_items();
+    uint64_t msgs = ch->route_publish_msgs();
+    const size_t kLargeRouteCount = 8;
+    for (size_t i = 0; i < kLargeRouteCount; i++) {
+        AgentXmppChannel::ControllerSendRoute(ch, rt, "vn1",
+                                              rt->GetMplsLabel(), &sg_list,
+                                              true);
+    }
+    ch->FlushRouteBatch();
+    EXPECT_EQ(1U + kRouteCount + kLargeRouteCount, ch->route_publish_items());
+    EXPECT_LT(msgs + 1, ch->route_publish_msgs());
+    WAIT_FOR(100, 10000, (mock_peer.get()->publish_items() ==
+                          1 + kRouteCount + kLargeRouteCount));
+    EXPECT_GT(kLargeRouteCount, mock_peer.get()->max_publish_items());
+
+    //Delete vm-port and route entry in vrf1
+    DeleteVmportEnv(input, 1, true);
+    client->WaitForIdle();
+    EXPECT_FALSE(VmPortFind(input, 0));
+
+    xc->ConfigUpdate(new XmppConfigData());
+    client->WaitForIdle(5);
+}
+
 TEST_F(AgentXmppUnitTest, DISABLED_SgList) {
 
     client->Reset();
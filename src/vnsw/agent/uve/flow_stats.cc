@@ -8,6 +8,7 @@
 #include <linux/genetlink.h>
 #include <linux/if_tun.h>
 
+#include <boost/functional/hash.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
 #include <db/db.h>
@@ -48,8 +49,107 @@ void FlowStatsCollector::SourceIpOverride(FlowEntry *flow, FlowDataIpv4 &s_flow)
     }
 }
 
+// Approximate size of a record on the wire: the string fields and 8 bytes
+// for each numeric field
+size_t FlowStatsCollector::FlowRecordSize(const FlowDataIpv4 &s_flow) {
+    static const size_t kNumericFields = 14;
+    return s_flow.get_flowuuid().size() + s_flow.get_sourcevn().size() +
+        s_flow.get_destvn().size() + s_flow.get_vm().size() +
+        s_flow.get_reverse_uuid().size() + kNumericFields * sizeof(uint64_t);
+}
+
+FlowStatsCollector::~FlowStatsCollector() {
+    // Send the records still waiting in a batch
+    FlushFlowExport();
+}
+
+void FlowStatsCollector::SetFlowExportConfig(uint32_t batch_size,
+                                             uint32_t delay_msec,
+                                             uint32_t short_flow_sample) {
+    tbb::mutex::scoped_lock lock(export_mutex_);
+    // Records batched under the old batch size are sent before it changes
+    if (batch_size != export_batch_size_) {
+        SendExportBatch();
+    }
+    export_batch_size_ = batch_size;
+    export_delay_ = delay_msec;
+    short_flow_sample_ = short_flow_sample;
+}
+
+// Short flows are sampled on the flow uuid, so that either all or none of
+// the records of a flow are exported
+bool FlowStatsCollector::ShouldExport(const FlowEntry *flow) {
+    uint32_t sample = short_flow_sample_;
+    if (sample <= 1 || !flow->ShortFlow()) {
+        return true;
+    }
+    if (boost::hash<boost::uuids::uuid>()(flow->flow_uuid) % sample == 0) {
+        return true;
+    }
+    export_sampled_out_++;
+    return false;
+}
+
+void FlowStatsCollector::ExportFlowRecord(const FlowDataIpv4 &s_flow) {
+    export_records_++;
+    export_bytes_ += FlowRecordSize(s_flow);
+
+    tbb::mutex::scoped_lock lock(export_mutex_);
+    if (export_batch_size_ <= 1) {
+        export_msgs_++;
+        FLOW_DATA_IPV4_OBJECT_SEND(s_flow);
+        return;
+    }
+    if (export_batch_.empty()) {
+        export_batch_time_ = UTCTimestampUsec();
+    }
+    export_batch_.push_back(s_flow);
+    if (export_batch_.size() >= export_batch_size_) {
+        SendExportBatch();
+    }
+}
+
+// Called with export_mutex_ held
+void FlowStatsCollector::SendExportBatch() {
+    if (export_batch_.empty()) {
+        return;
+    }
+    export_msgs_++;
+    FLOW_DATA_IPV4_LIST_OBJECT_SEND(export_batch_);
+    export_batch_.clear();
+}
+
+void FlowStatsCollector::ExportBatchTimeout(uint64_t curr_time) {
+    tbb::mutex::scoped_lock lock(export_mutex_);
+    if (!export_batch_.empty() &&
+        curr_time - export_batch_time_ >= export_delay_ * 1000ULL) {
+        SendExportBatch();
+    }
+}
+
+void FlowStatsCollector::SendFlowRecord(FlowStatsCollector *collector,
+                                        const FlowDataIpv4 &s_flow) {
+    if (collector) {
+        collector->ExportFlowRecord(s_flow);
+    } else {
+        FLOW_DATA_IPV4_OBJECT_SEND(s_flow);
+    }
+}
+
+void FlowStatsCollector::FlushFlowExport() {
+    tbb::mutex::scoped_lock lock(export_mutex_);
+    SendExportBatch();
+}
+
 void FlowStatsCollector::FlowExport(FlowEntry *flow, uint64_t diff_bytes, uint64_t diff_pkts) {
     FlowDataIpv4   s_flow;
+    FlowStatsCollector *collector = NULL;
+    if (AgentUve::GetInstance()) {
+        collector = AgentUve::GetInstance()->GetFlowStatsCollector();
+    }
+    if (collector && !collector->ShouldExport(flow)) {
+        return;
+    }
 
     s_flow.set_flowuuid(to_string(flow->flow_uuid));
     s_flow.set_bytes(flow->data.bytes);
@@ -94,13 +194,13 @@ void FlowStatsCollector::FlowExport(FlowEntry *flow, uint64_t diff_bytes, uint64
          */
         s_flow.set_direction_ing(1);
         SourceIpOverride(flow, s_flow);
-        FLOW_DATA_IPV4_OBJECT_SEND(s_flow);
+        SendFlowRecord(collector, s_flow);
         s_flow.set_direction_ing(0);
         //Export local flow of egress direction with a different UUID even when
         //the flow is same. Required for analytics module to query flows
         //irrespective of direction.
         s_flow.set_flowuuid(to_string(flow->egress_uuid));
-        FLOW_DATA_IPV4_OBJECT_SEND(s_flow);
+        SendFlowRecord(collector, s_flow);
     } else {
         if (flow->data.ingress) {
             s_flow.set_direction_ing(1);
@@ -108,7 +208,7 @@ void FlowStatsCollector::FlowExport(FlowEntry *flow, uint64_t diff_bytes, uint64
         } else {
             s_flow.set_direction_ing(0);
         }
-        FLOW_DATA_IPV4_OBJECT_SEND(s_flow);
+        SendFlowRecord(collector, s_flow);
     }
 
 }
@@ -130,19 +230,152 @@ bool FlowStatsCollector::ShouldBeAged(FlowEntry *entry,
     return true;
 }
 
-bool FlowStatsCollector::Run() {
+// A flow with a reverse flow is aged only when both can be aged
+bool FlowStatsCollector::CanBeAged(FlowEntry *entry,
+                                   const vr_flow_entry *k_flow,
+                                   uint64_t curr_time) {
+    if (!ShouldBeAged(entry, k_flow, curr_time)) {
+        return false;
+    }
+
+    FlowEntry *reverse_flow = entry->data.reverse_flow.get();
+    if (reverse_flow == NULL) {
+        return true;
+    }
+    const vr_flow_entry *k_flow_rev =
+        FlowTableKSyncObject::GetKSyncObject()->GetKernelFlowEntry
+        (reverse_flow->flow_handle, false);
+    return ShouldBeAged(reverse_flow, k_flow_rev, curr_time);
+}
+
+void FlowStatsCollector::UpdateFlowStats(FlowEntry *entry,
+                                         const vr_flow_entry *k_flow,
+                                         uint64_t curr_time) {
+    if (entry->data.bytes == k_flow->fe_stats.flow_bytes) {
+        return;
+    }
+
+    uint64_t diff_bytes = k_flow->fe_stats.flow_bytes - entry->data.bytes;
+    uint64_t diff_pkts = k_flow->fe_stats.flow_packets - entry->data.packets;
+    //Update Inter-VN stats
+    AgentUve::GetInstance()->GetInterVnStatsCollector()->UpdateVnStats(entry, 
+                                                        diff_bytes, diff_pkts);
+    entry->data.bytes = k_flow->fe_stats.flow_bytes;
+    entry->data.packets = k_flow->fe_stats.flow_packets;
+    entry->last_modified_time = curr_time;
+    FlowExport(entry, diff_bytes, diff_pkts);
+}
+
+// Returns the flow programmed at a kernel index, or NULL if the index is not
+// (or no longer) used by a flow in the flow table
+FlowEntry *FlowStatsCollector::FindFlow(uint32_t index,
+                                        const vr_flow_entry *k_flow) {
+    FlowKey key(k_flow->fe_key.key_vrf_id,
+                ntohl(k_flow->fe_key.key_src_ip),
+                ntohl(k_flow->fe_key.key_dest_ip),
+                k_flow->fe_key.key_proto,
+                ntohs(k_flow->fe_key.key_src_port),
+                ntohs(k_flow->fe_key.key_dst_port));
+    FlowEntry *entry = FlowTable::GetFlowTableObject()->Find(key);
+    if (entry == NULL || entry->flow_handle != index) {
+        return NULL;
+    }
+    return entry;
+}
+
+void FlowStatsCollector::SweepFlowIndex(uint32_t index,
+                                        const vr_flow_entry *k_flow,
+                                        uint64_t curr_time) {
+    FlowStatsSlot &slot = flow_stats_[index];
+    if ((k_flow->fe_flags & VR_FLOW_FLAG_ACTIVE) == 0) {
+        slot.active = false;
+        return;
+    }
+    sweep_active_++;
+
+    bool changed = (!slot.active ||
+                    slot.bytes != k_flow->fe_stats.flow_bytes ||
+                    slot.packets != k_flow->fe_stats.flow_packets);
+    if (!changed && (curr_time - slot.time) < GetFlowAgeTime()) {
+        return;
+    }
+
+    slot.active = true;
+    slot.bytes = k_flow->fe_stats.flow_bytes;
+    slot.packets = k_flow->fe_stats.flow_packets;
+    slot.time = curr_time;
+    FlowEntry *entry = FindFlow(index, k_flow);
+    if (entry == NULL) {
+        return;
+    }
+
+    if (CanBeAged(entry, k_flow, curr_time)) {
+        FlowEntry *reverse_flow = entry->data.reverse_flow.get();
+        FlowTable::GetFlowTableObject()->DeleteRevFlow
+            (entry->key, reverse_flow != NULL? true : false);
+        sweep_aged_++;
+        return;
+    }
+
+    if (changed) {
+        sweep_changed_++;
+        UpdateFlowStats(entry, k_flow, curr_time);
+    }
+
+    // The flow is looked at again once both it and its reverse flow have
+    // been idle for the age time
+    slot.time = entry->last_modified_time;
+    FlowEntry *reverse_flow = entry->data.reverse_flow.get();
+    if (reverse_flow && reverse_flow->last_modified_time > slot.time) {
+        slot.time = reverse_flow->last_modified_time;
+    }
+}
+
+// Sweep the next FlowIndexPerPass entries of the kernel flow table
+void FlowStatsCollector::SweepKernelFlows(uint64_t curr_time) {
+    FlowTableKSyncObject *ksync = FlowTableKSyncObject::GetKSyncObject();
+    uint32_t size = ksync->GetFlowTableSize();
+    if (size == 0) {
+        return;
+    }
+    if (flow_stats_.size() != size) {
+        flow_stats_.clear();
+        flow_stats_.resize(size);
+        flow_index_ = 0;
+    }
+
+    const vr_flow_entry *k_flow_table = ksync->GetKernelFlowEntry(0, true);
+    uint32_t end = std::min(flow_index_ + FlowIndexPerPass, size);
+    for (uint32_t index = flow_index_; index < end; index++) {
+        if (index + kPrefetchDistance < size) {
+            __builtin_prefetch(&k_flow_table[index + kPrefetchDistance]);
+        }
+        SweepFlowIndex(index, &k_flow_table[index], curr_time);
+    }
+    flow_index_ = end;
+    sweep_time_ += UTCTimestampUsec() - curr_time;
+
+    if (flow_index_ == size) {
+        last_sweep_time_ = sweep_time_;
+        last_sweep_active_ = sweep_active_;
+        last_sweep_changed_ = sweep_changed_;
+        last_sweep_aged_ = sweep_aged_;
+        flow_index_ = 0;
+        sweep_time_ = 0;
+        sweep_active_ = 0;
+        sweep_changed_ = 0;
+        sweep_aged_ = 0;
+    }
+}
+
+// Walk the flow table for flows not covered by the kernel sweep
+void FlowStatsCollector::WalkFlows(uint64_t curr_time) {
     FlowTable::FlowEntryMap::iterator it;
     FlowEntry *entry = NULL, *reverse_flow;
     uint32_t count = 0;
     bool key_updation_reqd = true, deleted;
-    uint64_t diff_bytes, diff_pkts;
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
-   
-    run_counter_++;
-    if (!flow_obj->Size()) {
-        return true;
-    }
-    uint64_t curr_time = UTCTimestampUsec();
+
     it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
     if (it == flow_obj->flow_entry_map_.end()) {
         it = flow_obj->flow_entry_map_.begin();
@@ -157,29 +390,15 @@ bool FlowStatsCollector::Run() {
         const vr_flow_entry *k_flow = 
             FlowTableKSyncObject::GetKSyncObject()->GetKernelFlowEntry
             (entry->flow_handle, false);
-        // Can the flow be aged?
-        if (ShouldBeAged(entry, k_flow, curr_time)) {
+        // Flows active in the kernel are aged by the sweep
+        if (k_flow == NULL && CanBeAged(entry, NULL, curr_time)) {
             reverse_flow = entry->data.reverse_flow.get();
-            // If reverse_flow is present, wait till both are aged
-            if (reverse_flow) {
-                const vr_flow_entry *k_flow_rev;
-                k_flow_rev = 
-                    FlowTableKSyncObject::GetKSyncObject()->GetKernelFlowEntry
-                    (reverse_flow->flow_handle, false);
-                if (ShouldBeAged(reverse_flow, k_flow_rev, curr_time)) {
-                    deleted = true;
-                }
-            } else {
-                deleted = true;
-            }
-        }
-
-        if (deleted == true) {
             if (it != flow_obj->flow_entry_map_.end()) {
                 if (it->second == reverse_flow) {
                     it++;
                 }
             }
+            deleted = true;
             FlowTable::GetFlowTableObject()->DeleteRevFlow
                 (entry->key, reverse_flow != NULL? true : false);
             if (reverse_flow) {
@@ -190,20 +409,6 @@ bool FlowStatsCollector::Run() {
             }
         }
 
-        if (deleted == false && k_flow) {
-            if (entry->data.bytes != k_flow->fe_stats.flow_bytes) {
-                diff_bytes = k_flow->fe_stats.flow_bytes - entry->data.bytes;
-                diff_pkts = k_flow->fe_stats.flow_packets - entry->data.packets;
-                //Update Inter-VN stats
-                AgentUve::GetInstance()->GetInterVnStatsCollector()->UpdateVnStats(entry, 
-                                                                    diff_bytes, diff_pkts);
-                entry->data.bytes = k_flow->fe_stats.flow_bytes;
-                entry->data.packets = k_flow->fe_stats.flow_packets;
-                entry->last_modified_time = curr_time;
-                FlowExport(entry, diff_bytes, diff_pkts);
-            }
-        }
-
         if ((!deleted) && entry->ShortFlow()) {
             deleted = true;
             FlowTable::GetFlowTableObject()->DeleteRevFlow(entry->key, false);
@@ -226,5 +431,18 @@ bool FlowStatsCollector::Run() {
     if (key_updation_reqd) {
         flow_iteration_key_.Reset();
     }
+}
+
+bool FlowStatsCollector::Run() {
+    FlowTable *flow_obj = FlowTable::GetFlowTableObject();
+   
+    run_counter_++;
+    uint64_t curr_time = UTCTimestampUsec();
+    ExportBatchTimeout(curr_time);
+    if (!flow_obj->Size()) {
+        return true;
+    }
+    SweepKernelFlows(curr_time);
+    WalkFlows(curr_time);
     return true;
 }
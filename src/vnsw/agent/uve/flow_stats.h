@@ -5,6 +5,9 @@
 #ifndef vnsw_agent_flow_stats_h
 #define vnsw_agent_flow_stats_h
 
+#include <vector>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
 #include <sandesh/common/flow_types.h>
 #include <cmn/agent_cmn.h>
 #include <uve/stats_collector.h>
@@ -15,29 +18,130 @@ struct FlowEntry;
 struct PktInfo;
 struct FlowKey;
 
+// Stats and aging of flows.
+//
+// Flows programmed in the kernel are handled by a sweep of the mmapped
+// vr_flow_entry table in index order. The counters last seen for each index
+// are kept in flow_stats_, an array parallel to the kernel table, so a
+// FlowEntry is only looked up when its counters change or when the index has
+// been idle for the age time. Each run sweeps FlowIndexPerPass indices.
+//
+// Flows without an active kernel entry, and short flows, are handled by a
+// walk of the flow table, FlowCountPerPass flows per run.
+//
+// Flow records are sent one FlowDataIpv4Object per record, or, when the
+// export batch size is more than 1, batched in FlowDataIpv4ListObject
+// messages. A batch is sent when full, or from Run once its oldest record
+// is older than the export delay. Records of short flows can be sampled,
+// exporting all records of 1 in every N short flows.
 class FlowStatsCollector : public StatsCollector {
 public:
     static const uint64_t FlowAgeTime = 1000000 * 180;
     static const uint32_t FlowCountPerPass = 100;
+    static const uint32_t FlowIndexPerPass = 128 * 1024;
     static const uint32_t FlowStatsInterval = (2000); // time in milliseconds
+    static const uint32_t FlowExportBatchSize = 1;
+    static const uint32_t FlowExportDelay = 1000; // time in milliseconds
 
     FlowStatsCollector(boost::asio::io_service &io, int intvl) :
-        StatsCollector(StatsCollector::FlowStatsCollector, io, intvl, "Flow stats collector") {
+        StatsCollector(StatsCollector::FlowStatsCollector, io, intvl, "Flow stats collector"),
+        flow_index_(0), sweep_time_(0), sweep_active_(0),
+        sweep_changed_(0), sweep_aged_(0), last_sweep_time_(0),
+        last_sweep_active_(0), last_sweep_changed_(0), last_sweep_aged_(0),
+        export_batch_size_(FlowExportBatchSize),
+        export_delay_(FlowExportDelay), short_flow_sample_(1),
+        export_batch_time_(0) {
         flow_iteration_key_.Reset();
         flow_age_time_intvl_ = FlowAgeTime;
+        export_records_ = 0;
+        export_msgs_ = 0;
+        export_bytes_ = 0;
+        export_sampled_out_ = 0;
     }
-    virtual ~FlowStatsCollector() { };
+    virtual ~FlowStatsCollector();
 
     static void FlowExport(FlowEntry *flow, uint64_t diff_bytes, uint64_t diff_pkts);
     bool Run();
     uint64_t GetFlowAgeTime() { return flow_age_time_intvl_; }
     void SetFlowAgeTime(uint64_t usecs) { flow_age_time_intvl_ = usecs; }
+
+    // Export configuration. A batch size of 0 or 1 sends one message per
+    // record. A sample rate of N exports 1 in every N short flows.
+    void SetFlowExportConfig(uint32_t batch_size, uint32_t delay_msec,
+                             uint32_t short_flow_sample);
+    uint32_t export_batch_size() const { return export_batch_size_; }
+    uint32_t export_delay() const { return export_delay_; }
+    uint32_t short_flow_sample() const { return short_flow_sample_; }
+    void FlushFlowExport();
+
+    uint64_t export_records() const { return export_records_; }
+    uint64_t export_msgs() const { return export_msgs_; }
+    uint64_t export_bytes() const { return export_bytes_; }
+    uint64_t export_sampled_out() const { return export_sampled_out_; }
+
+    // Metrics of the last complete sweep of the kernel flow table. The sweep
+    // time is the time spent in the sweep, in usecs, excluding the time
+    // between runs.
+    uint64_t last_sweep_time() const { return last_sweep_time_; }
+    uint32_t last_sweep_active() const { return last_sweep_active_; }
+    uint32_t last_sweep_changed() const { return last_sweep_changed_; }
+    uint32_t last_sweep_aged() const { return last_sweep_aged_; }
 private:
+    static const uint32_t kPrefetchDistance = 8;
+
+    // Counters of a kernel flow index as of the last sweep, and the last
+    // activity seen on the flow or its reverse flow.
+    struct FlowStatsSlot {
+        FlowStatsSlot() : bytes(0), packets(0), time(0), active(false) { }
+        uint64_t bytes;
+        uint64_t packets;
+        uint64_t time;
+        bool active;
+    };
+
     bool ShouldBeAged(FlowEntry *entry, const vr_flow_entry *k_flow,
                       uint64_t curr_time);
+    bool CanBeAged(FlowEntry *entry, const vr_flow_entry *k_flow,
+                   uint64_t curr_time);
+    void UpdateFlowStats(FlowEntry *entry, const vr_flow_entry *k_flow,
+                         uint64_t curr_time);
+    FlowEntry *FindFlow(uint32_t index, const vr_flow_entry *k_flow);
+    void SweepFlowIndex(uint32_t index, const vr_flow_entry *k_flow,
+                        uint64_t curr_time);
+    void SweepKernelFlows(uint64_t curr_time);
+    void WalkFlows(uint64_t curr_time);
     static void SourceIpOverride(FlowEntry *flow, FlowDataIpv4 &s_flow);
+    static size_t FlowRecordSize(const FlowDataIpv4 &s_flow);
+    bool ShouldExport(const FlowEntry *flow);
+    static void SendFlowRecord(FlowStatsCollector *collector,
+                               const FlowDataIpv4 &s_flow);
+    void ExportFlowRecord(const FlowDataIpv4 &s_flow);
+    void SendExportBatch();
+    void ExportBatchTimeout(uint64_t curr_time);
     FlowKey flow_iteration_key_;
     uint64_t flow_age_time_intvl_;
+
+    std::vector<FlowStatsSlot> flow_stats_;
+    uint32_t flow_index_;
+    uint64_t sweep_time_;
+    uint32_t sweep_active_;
+    uint32_t sweep_changed_;
+    uint32_t sweep_aged_;
+    uint64_t last_sweep_time_;
+    uint32_t last_sweep_active_;
+    uint32_t last_sweep_changed_;
+    uint32_t last_sweep_aged_;
+
+    tbb::mutex export_mutex_;
+    uint32_t export_batch_size_;
+    uint32_t export_delay_;
+    uint32_t short_flow_sample_;
+    std::vector<FlowDataIpv4> export_batch_;
+    uint64_t export_batch_time_;
+    tbb::atomic<uint64_t> export_records_;
+    tbb::atomic<uint64_t> export_msgs_;
+    tbb::atomic<uint64_t> export_bytes_;
+    tbb::atomic<uint64_t> export_sampled_out_;
     DISALLOW_COPY_AND_ASSIGN(FlowStatsCollector);
 };
 
@@ -3,127 +3,175 @@
  */
 
 #include "inter_vn_stats.h"
+#include <algorithm>
 #include <oper/interface.h>
 #include <oper/mirror_table.h>
 
 using namespace std;
+using tbb::mutex;
+
+InterVnStatsCollector::~InterVnStatsCollector() {
+    for (size_t i = 0; i < inter_vn_stats_.size(); i++) {
+        VnStatsRow &row = inter_vn_stats_[i];
+        for (size_t j = 0; j < row.size(); j++) {
+            if (row[j]) {
+                assert(!row[j]->valid);
+                delete row[j];
+            }
+        }
+    }
+}
+
+// Returns the id of a VN name, allocating one on first use. Ids are not
+// reused, since they are cached in flows.
+int InterVnStatsCollector::VnId(const string &vn) {
+    mutex::scoped_lock lock(mutex_);
+    VnIdMap::iterator it = vn_ids_.find(vn);
+    if (it != vn_ids_.end()) {
+        return it->second;
+    }
+    int id = vn_names_.size();
+    vn_names_.push_back(vn);
+    vn_ids_.insert(make_pair(vn, id));
+    return id;
+}
 
-InterVnStatsCollector::VnStatsSet *InterVnStatsCollector::Find(string vn) {
-     VnStatsMap::iterator it = inter_vn_stats_.find(vn);
+bool InterVnStatsCollector::Find(const string &vn, VnStatsList *list) {
+    mutex::scoped_lock lock(mutex_);
+    list->clear();
+    VnIdMap::iterator it = vn_ids_.find(vn);
+    if (it == vn_ids_.end() || it->second >= (int)inter_vn_stats_.size()) {
+        return false;
+    }
 
-     if (it != inter_vn_stats_.end()) {
-         return it->second;
-     }
-     return NULL;
+    VnStatsRow &row = inter_vn_stats_[it->second];
+    for (size_t i = 0; i < row.size(); i++) {
+        VnCounters *counters = row[i];
+        if (counters == NULL || !counters->valid) {
+            continue;
+        }
+        VnStats stats(vn_names_[i], 0, 0, false);
+        stats.in_pkts = counters->in_pkts;
+        stats.in_bytes = counters->in_bytes;
+        stats.out_pkts = counters->out_pkts;
+        stats.out_bytes = counters->out_bytes;
+        list->push_back(stats);
+    }
+    sort(list->begin(), list->end(), VnStatsCmp());
+    return !list->empty();
 }
 
 void InterVnStatsCollector::PrintAll() {
-    VnStatsMap::iterator it = inter_vn_stats_.begin();
-    while(it != inter_vn_stats_.end()) {
+    VnIdMap::iterator it = vn_ids_.begin();
+    while(it != vn_ids_.end()) {
         PrintVn(it->first);
         it++;
     }
 }
 
-void InterVnStatsCollector::PrintVn(string vn) {
-
-    VnStatsSet *stats_set;
-    VnStats *stats;
+void InterVnStatsCollector::PrintVn(const string &vn) {
+    VnStatsList list;
 
     LOG(DEBUG, "...........Stats for Vn " << vn);
-    VnStatsMap::iterator it = inter_vn_stats_.find(vn);
-    if (it != inter_vn_stats_.end()) {
-        stats_set = it->second;
-
-        /* Remove all the elements of map entry value which is a set */
-        VnStatsSet::iterator stats_it = stats_set->begin();
-        while(stats_it != stats_set->end()) {
-            stats = *stats_it;
-            stats_it++;
-            LOG(DEBUG, "    Other-VN " << stats->dst_vn);
-            LOG(DEBUG, "        in_pkts " << stats->in_pkts << " in_bytes " << stats->in_bytes);
-            LOG(DEBUG, "        out_pkts " << stats->out_pkts << " out_bytes " << stats->out_bytes);
+    Find(vn, &list);
+    for (VnStatsList::iterator it = list.begin(); it != list.end(); it++) {
+        LOG(DEBUG, "    Other-VN " << it->dst_vn);
+        LOG(DEBUG, "        in_pkts " << it->in_pkts << " in_bytes " << it->in_bytes);
+        LOG(DEBUG, "        out_pkts " << it->out_pkts << " out_bytes " << it->out_bytes);
+    }
+}
+
+void InterVnStatsCollector::Remove(const string &vn) {
+    mutex::scoped_lock lock(mutex_);
+    VnIdMap::iterator it = vn_ids_.find(vn);
+    if (it == vn_ids_.end() || it->second >= (int)inter_vn_stats_.size()) {
+        return;
+    }
+
+    /* Reset the stats against all other VNs */
+    VnStatsRow &row = inter_vn_stats_[it->second];
+    for (size_t i = 0; i < row.size(); i++) {
+        VnCounters *counters = row[i];
+        if (counters == NULL) {
+            continue;
         }
+        counters->valid = false;
+        counters->in_pkts = 0;
+        counters->in_bytes = 0;
+        counters->out_pkts = 0;
+        counters->out_bytes = 0;
     }
 }
 
-void InterVnStatsCollector::Remove(string vn) {
-        
-    VnStatsSet *stats_set;
-    VnStats *stats;
-
-    VnStatsMap::iterator it = inter_vn_stats_.find(vn);
-    if (it != inter_vn_stats_.end()) {
-        stats_set = it->second;
-        /* Remove the entry from the inter_vn_stats_ map */
-        inter_vn_stats_.erase(it);
-
-        /* Remove all the elements of map entry value which is a set */
-        VnStatsSet::iterator stats_it = stats_set->begin();
-        VnStatsSet::iterator del_it;
-        while(stats_it != stats_set->end()) {
-            stats = *stats_it;
-            delete stats;
-            del_it = stats_it;
-            stats_it++;
-            stats_set->erase(del_it);
+// Returns the counters of a pair of VNs, adding them if needed. Only the
+// flow stats collector adds rows and counters, so it can look them up
+// without the mutex.
+InterVnStatsCollector::VnCounters *InterVnStatsCollector::Locate(int src_id,
+                                                                 int dst_id) {
+    if (src_id < (int)inter_vn_stats_.size()) {
+        VnStatsRow &row = inter_vn_stats_[src_id];
+        if (dst_id < (int)row.size() && row[dst_id] != NULL) {
+            return row[dst_id];
         }
-        delete stats_set;
     }
+
+    mutex::scoped_lock lock(mutex_);
+    if (src_id >= (int)inter_vn_stats_.size()) {
+        inter_vn_stats_.resize(src_id + 1);
+    }
+    VnStatsRow &row = inter_vn_stats_[src_id];
+    if (dst_id >= (int)row.size()) {
+        row.resize(dst_id + 1, NULL);
+    }
+    VnCounters *counters = new VnCounters;
+    counters->in_pkts = 0;
+    counters->in_bytes = 0;
+    counters->out_pkts = 0;
+    counters->out_bytes = 0;
+    counters->valid = false;
+    row[dst_id] = counters;
+    return counters;
 }
 
-void InterVnStatsCollector::UpdateVnStats(FlowEntry *fe, uint64_t bytes, 
+void InterVnStatsCollector::UpdateVnStats(FlowEntry *fe, uint64_t bytes,
                                           uint64_t pkts) {
-    string src_vn = fe->data.source_vn, dst_vn = fe->data.dest_vn;
-
-    if (!fe->data.source_vn.length())
-        src_vn = *FlowHandler::UnknownVn();
-    if (!fe->data.dest_vn.length())
-        dst_vn = *FlowHandler::UnknownVn();
+    if (fe->data.source_vn_id < 0) {
+        if (!fe->data.source_vn.length())
+            fe->data.source_vn_id = VnId(*FlowHandler::UnknownVn());
+        else
+            fe->data.source_vn_id = VnId(fe->data.source_vn);
+    }
+    if (fe->data.dest_vn_id < 0) {
+        if (!fe->data.dest_vn.length())
+            fe->data.dest_vn_id = VnId(*FlowHandler::UnknownVn());
+        else
+            fe->data.dest_vn_id = VnId(fe->data.dest_vn);
+    }
+    int src_id = fe->data.source_vn_id, dst_id = fe->data.dest_vn_id;
 
     if (fe->local_flow) {
-        VnStatsUpdateInternal(src_vn, dst_vn, bytes, pkts, true);
-        VnStatsUpdateInternal(dst_vn, src_vn, bytes, pkts, false);
+        VnStatsUpdateInternal(src_id, dst_id, bytes, pkts, true);
+        VnStatsUpdateInternal(dst_id, src_id, bytes, pkts, false);
     } else {
         if (fe->data.ingress) {
-            VnStatsUpdateInternal(src_vn, dst_vn, bytes, pkts, true);
+            VnStatsUpdateInternal(src_id, dst_id, bytes, pkts, true);
         } else {
-            VnStatsUpdateInternal(dst_vn, src_vn, bytes, pkts, false);
+            VnStatsUpdateInternal(dst_id, src_id, bytes, pkts, false);
         }
     }
     //PrintAll();
 }
 
-void InterVnStatsCollector::VnStatsUpdateInternal(string src_vn, string dst_vn,
-                                                  uint64_t bytes, uint64_t pkts, 
+void InterVnStatsCollector::VnStatsUpdateInternal(int src_id, int dst_id,
+                                                  uint64_t bytes, uint64_t pkts,
                                                   bool outgoing) {
-    VnStatsSet *stats_set;
-    VnStats *stats;
-
-    VnStatsMap::iterator it = inter_vn_stats_.find(src_vn);
-
-    if (it == inter_vn_stats_.end()) {
-       stats = new VnStats(dst_vn, bytes, pkts, outgoing);
-       stats_set = new VnStatsSet;
-       stats_set->insert(stats);
-       inter_vn_stats_.insert(make_pair(src_vn, stats_set));
+    VnCounters *counters = Locate(src_id, dst_id);
+    if (outgoing) {
+        counters->out_bytes += bytes;
+        counters->out_pkts += pkts;
     } else {
-       stats_set = it->second;
-       VnStats key(dst_vn, 0, 0, false);
-       VnStatsSet::iterator stats_it = stats_set->find(&key);
-       if (stats_it == stats_set->end()) {
-           stats = new VnStats(dst_vn, bytes, pkts, outgoing);
-           stats_set->insert(stats);
-       } else {
-           stats = *stats_it;
-           if (outgoing) {
-               stats->out_bytes += bytes;
-               stats->out_pkts += pkts;
-           } else {
-               stats->in_bytes += bytes;
-               stats->in_pkts += pkts;
-           }
-       }
-
+        counters->in_bytes += bytes;
+        counters->in_pkts += pkts;
     }
+    counters->valid = true;
 }
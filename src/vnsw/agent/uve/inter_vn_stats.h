@@ -7,8 +7,10 @@
 
 #include "pkt/pkt_flow.h"
 #include "pkt/flowtable.h"
-#include <set>
 #include <map>
+#include <vector>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
 
 struct VnStats {
     std::string dst_vn;
@@ -34,33 +36,57 @@ struct VnStats {
 
 class VnStatsCmp {
 public:
-    bool operator()(const VnStats *lhs, const VnStats *rhs) const {
-         if (lhs->dst_vn.compare(rhs->dst_vn) < 0)
+    bool operator()(const VnStats &lhs, const VnStats &rhs) const {
+         if (lhs.dst_vn.compare(rhs.dst_vn) < 0)
              return true;
          return false;
     }
 
 };
 
+// Stats between pairs of VNs.
+//
+// VN names are interned to integer ids, and the ids are cached in the
+// FlowData of each flow, so a stats update is two array lookups. Counters of
+// a VN are kept in a row indexed by the id of the other VN.
+//
+// Updates come only from the flow stats collector. Rows and counters are
+// added with mutex_ held, which readers also take. Counters are atomic, so
+// the update path does not take the mutex once the counters of a pair exist.
 class InterVnStatsCollector {
 public:
-    typedef std::set<VnStats *, VnStatsCmp> VnStatsSet;
-    typedef std::map<std::string, VnStatsSet *> VnStatsMap;
+    typedef std::vector<VnStats> VnStatsList;
+
     InterVnStatsCollector() {};
-    virtual ~InterVnStatsCollector() {
-        assert(inter_vn_stats_.size() == 0);
-    };
+    virtual ~InterVnStatsCollector();
     void UpdateVnStats(FlowEntry *entry, uint64_t bytes, uint64_t pkts);
-    VnStatsSet *Find(std::string vn);
-    void Remove(std::string vn);
+    // Fills list with the stats of vn against each other VN, ordered by the
+    // name of the other VN. Returns false if there are no stats for vn.
+    bool Find(const std::string &vn, VnStatsList *list);
+    void Remove(const std::string &vn);
     void PrintAll();
-    void PrintVn(std::string vn);
+    void PrintVn(const std::string &vn);
 private:
-    VnStatsMap inter_vn_stats_;
-    void VnStatsUpdateInternal(std::string src_vn, std::string dst_vn, uint64_t bytes, 
+    struct VnCounters {
+        tbb::atomic<uint64_t> in_pkts;
+        tbb::atomic<uint64_t> in_bytes;
+        tbb::atomic<uint64_t> out_pkts;
+        tbb::atomic<uint64_t> out_bytes;
+        tbb::atomic<bool> valid;
+    };
+    typedef std::vector<VnCounters *> VnStatsRow;
+    typedef std::map<std::string, int> VnIdMap;
+
+    int VnId(const std::string &vn);
+    VnCounters *Locate(int src_id, int dst_id);
+    void VnStatsUpdateInternal(int src_id, int dst_id, uint64_t bytes,
                                uint64_t pkts, bool outgoing);
+
+    tbb::mutex mutex_;
+    VnIdMap vn_ids_;
+    std::vector<std::string> vn_names_;
+    std::vector<VnStatsRow> inter_vn_stats_;
     DISALLOW_COPY_AND_ASSIGN(InterVnStatsCollector);
 };
 
 #endif //vnsw_agent_inter_vn_stats_h
-
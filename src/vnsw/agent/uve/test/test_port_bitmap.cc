@@ -254,8 +254,7 @@ public:
         VmPortInterface *intf = static_cast<VmPortInterface *>(VmPortGet(port));
         const VnEntry *vn = intf->GetVnEntry();
         SecurityGroupList empty_sg_id_l;
-        flow->data.source_vn = vn->GetName();
-        flow->data.dest_vn = dest_vn;
+        flow->data.SetVn(vn->GetName(), dest_vn);
         flow->data.source_sg_id_l = empty_sg_id_l;
         flow->data.dest_sg_id_l = empty_sg_id_l;
         flow->data.vn_entry = vn;
@@ -570,28 +570,27 @@ void UveClient::VmNotify(DBTablePartBase *partition, DBEntryBase *e) {
 bool UveClient::PopulateInterVnStats(string vn_name,
                                      UveVirtualNetworkAgent *s_vn) {
     bool changed = false;
-    InterVnStatsCollector::VnStatsSet *stats_set = 
-            AgentUve::GetInstance()->GetInterVnStatsCollector()->Find(vn_name);
+    InterVnStatsCollector::VnStatsList stats_list;
 
-    if (!stats_set) {
+    if (!AgentUve::GetInstance()->GetInterVnStatsCollector()->Find(vn_name,
+                                                                 &stats_list)) {
         return false;
     }
     vector<UveInterVnStats> in_list;
     vector<UveInterVnStats> out_list;
     
-    InterVnStatsCollector::VnStatsSet::iterator it = stats_set->begin();
-    VnStats *stats;
-    while (it != stats_set->end()) {
-        stats = *it;
+    InterVnStatsCollector::VnStatsList::iterator it = stats_list.begin();
+    while (it != stats_list.end()) {
+        const VnStats &stats = *it;
         UveInterVnStats uve_stats;
-        uve_stats.set_other_vn(stats->dst_vn);
+        uve_stats.set_other_vn(stats.dst_vn);
 
-        uve_stats.set_tpkts(stats->in_pkts);
-        uve_stats.set_bytes(stats->in_bytes);
+        uve_stats.set_tpkts(stats.in_pkts);
+        uve_stats.set_bytes(stats.in_bytes);
         in_list.push_back(uve_stats);
 
-        uve_stats.set_tpkts(stats->out_pkts);
-        uve_stats.set_bytes(stats->out_bytes);
+        uve_stats.set_tpkts(stats.out_pkts);
+        uve_stats.set_bytes(stats.out_bytes);
         out_list.push_back(uve_stats);
         it++;
     }
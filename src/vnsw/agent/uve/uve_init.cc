@@ -91,6 +91,41 @@ void SetAgentStatsInterval_InSeconds::HandleRequest() const {
     return;
 }
 
+void SetFlowExportConfig::HandleRequest() const {
+    SandeshResponse *resp;
+    if (get_short_flow_sample() > 0) {
+        AgentUve::GetInstance()->GetFlowStatsCollector()->
+            SetFlowExportConfig(get_batch_size(), get_max_delay_msec(),
+                                get_short_flow_sample());
+        resp = new StatsCfgResp();
+    } else {
+        resp = new StatsCfgErrResp();
+    }
+
+    resp->set_context(context());
+    resp->Response();
+    return;
+}
+
+void GetFlowExportStats::HandleRequest() const {
+    FlowStatsCollector *collector =
+        AgentUve::GetInstance()->GetFlowStatsCollector();
+    FlowExportStatsResp *resp = new FlowExportStatsResp();
+    resp->set_batch_size(collector->export_batch_size());
+    resp->set_max_delay_msec(collector->export_delay());
+    resp->set_short_flow_sample(collector->short_flow_sample());
+    resp->set_records(collector->export_records());
+    resp->set_messages(collector->export_msgs());
+    if (collector->export_records()) {
+        resp->set_bytes_per_record(collector->export_bytes() /
+                                   collector->export_records());
+    }
+    resp->set_short_flows_sampled_out(collector->export_sampled_out());
+    resp->set_context(context());
+    resp->Response();
+    return;
+}
+
 void GetStatsInterval::HandleRequest() const {
     StatsIntervalResp_InSeconds *resp = new StatsIntervalResp_InSeconds();
     resp->set_agent_stats_interval((AgentUve::GetInstance()->
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_framer.h"
+
+#include <sstream>
+#include <vector>
+#include <boost/regex.hpp>
+
+#include "base/logging.h"
+#include "base/util.h"
+#include "xmpp/xmpp_str.h"
+
+#include "testing/gunit.h"
+
+using namespace std;
+
+// Stanza matching as done by XmppSession with boost::regex, in the
+// established state. Used as the baseline for the throughput test.
+class XmppRegexFramer {
+public:
+    XmppRegexFramer() : patt_(rXMPP_MESSAGE), tag_known_(false) {
+        ReplaceBuf("");
+    }
+
+    template <typename Cb>
+    void Parse(const char *data, size_t len, Cb cb) {
+        SetBuf(string(data, data + len));
+        while (!Match()) {
+            string::const_iterator st = buf_.begin();
+            string::const_iterator end = buf_.end();
+            cb(string(st, offset_));
+            if (end == offset_) {
+                buf_.clear();
+                break;
+            }
+            ReplaceBuf(string(offset_, end));
+        }
+    }
+
+private:
+    void SetBuf(const string &str) {
+        if (buf_.empty()) {
+            ReplaceBuf(str);
+        } else {
+            int pos = offset_ - buf_.begin();
+            buf_ += str;
+            offset_ = buf_.begin() + pos;
+        }
+    }
+
+    void ReplaceBuf(const string &str) {
+        buf_ = str;
+        offset_ = buf_.begin();
+    }
+
+    int MatchRegex(const boost::regex &patt) {
+        string::const_iterator end = buf_.end();
+        if (regex_search(offset_, end, res_, patt,
+                         boost::match_default | boost::match_partial) == 0) {
+            return -1;
+        }
+        if (res_[0].matched == false) {
+            offset_ = res_[0].first;
+            return 1;
+        }
+        begin_tag_ = string(res_[0].first, res_[0].second);
+        offset_ = res_[0].second;
+        return 0;
+    }
+
+    // Returns false if a stanza ends at offset_
+    bool Match() {
+        while (true) {
+            if (!tag_known_) {
+                size_t pos = buf_.find_first_not_of(sXMPP_VALIDWS);
+                if (pos != 0) {
+                    if (pos == string::npos) pos = buf_.size();
+                    offset_ = buf_.begin() + pos;
+                    return false;
+                }
+            }
+            int m;
+            if (tag_known_) {
+                string token("</");
+                token += begin_tag_.substr(1);
+                token += "[\\s\\t\\r\\n]*>";
+                m = MatchRegex(boost::regex(token));
+            } else {
+                m = MatchRegex(patt_);
+            }
+            if (m != 0) {
+                return true;
+            }
+            tag_known_ = !tag_known_;
+            if (!tag_known_) {
+                return false;
+            }
+        }
+    }
+
+    boost::regex patt_;
+    bool tag_known_;
+    string begin_tag_;
+    string buf_;
+    string::const_iterator offset_;
+    boost::match_results<string::const_iterator> res_;
+};
+
+struct Collector {
+    explicit Collector(vector<string> *result) : result(result) { }
+    void operator()(const string &stanza) { result->push_back(stanza); }
+    vector<string> *result;
+};
+
+class XmppFramerTest : public ::testing::Test {
+protected:
+    // Feed the stream to the framer in chunks of chunk_size bytes
+    vector<string> Frame(const string &stream, size_t chunk_size) {
+        vector<string> result;
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(stream.data());
+        for (size_t offset = 0; offset < stream.size(); offset += chunk_size) {
+            const uint8_t *cp = data + offset;
+            size_t size = min(chunk_size, stream.size() - offset);
+            while (size > 0) {
+                size_t used = 0;
+                bool done = framer_.Scan(cp, size, &used);
+                cp += used;
+                size -= used;
+                if (!done) break;
+                result.push_back(framer_.stanza());
+            }
+        }
+        return result;
+    }
+
+    // Route publish and collection messages as sent by the agent
+    static string RoutePublish(int index, int items) {
+        ostringstream oss;
+        oss << "<iq type='set' from='agent@vnsw.contrailsystems.com' "
+            << "to='network-control@contrailsystems.com/bgp-peer' "
+            << "id='pubsub" << index << "'>"
+            << "<pubsub xmlns='http://jabber.org/protocol/pubsub'>"
+            << "<publish node='1/1/default-domain:admin:vn1:vn1'>";
+        for (int i = 0; i < items; i++) {
+            oss << "<item id='10.1." << (i >> 8) << "." << (i & 0xFF)
+                << "/32'><entry xmlns=\"http://www.contrailsystems.com/"
+                << "bgp-l3vpn-unicast-cfg\"><nlri><af>1</af>"
+                << "<address>10.1." << (i >> 8) << "." << (i & 0xFF)
+                << "/32</address></nlri><next-hops><next-hop><af>1</af>"
+                << "<address>192.168.1.1</address><label>" << 16 + i
+                << "</label></next-hop></next-hops><version>1</version>"
+                << "<virtual-network>default-domain:admin:vn1</virtual-network>"
+                << "</entry></item>";
+        }
+        oss << "</publish></pubsub></iq>"
+            << "<iq type='set' from='agent@vnsw.contrailsystems.com' "
+            << "to='network-control@contrailsystems.com/bgp-peer' "
+            << "id='collection" << index << "'>"
+            << "<pubsub xmlns='http://jabber.org/protocol/pubsub'>"
+            << "<collection node='default-domain:admin:vn1:vn1'>"
+            << "<associate node='1/1/default-domain:admin:vn1:vn1' />"
+            << "</collection></pubsub></iq>";
+        return oss.str();
+    }
+
+    XmppFramer framer_;
+};
+
+TEST_F(XmppFramerTest, StreamHeader) {
+    string open("<?xml version='1.0'?><stream:stream from='agent' "
+                "to='bgp' version='1.0' xml:lang='en' xmlns='jabber:client' "
+                "xmlns:stream='http://etherx.jabber.org/streams'>");
+    string iq("<iq type='get' id='1'><ping xmlns='urn:xmpp:ping'/></iq>");
+    vector<string> result = Frame(open + iq, 4096);
+    ASSERT_EQ(2U, result.size());
+    EXPECT_EQ(open, result[0]);
+    EXPECT_EQ(iq, result[1]);
+    EXPECT_EQ(0U, framer_.pending());
+}
+
+TEST_F(XmppFramerTest, Whitespace) {
+    string iq("<iq type='get' id='1'/>");
+    vector<string> result = Frame(iq + sXMPP_WHITESPACE + iq, 4096);
+    ASSERT_EQ(3U, result.size());
+    EXPECT_EQ(iq, result[0]);
+    EXPECT_EQ(string(sXMPP_WHITESPACE), result[1]);
+    EXPECT_EQ(iq, result[2]);
+}
+
+// Quoted '>' and nested elements of the same name
+TEST_F(XmppFramerTest, Nested) {
+    string msg("<message to='a>b'><body><message>x</message></body>"
+               "<subject a=\"'/>\"/></message >");
+    vector<string> result = Frame(msg + msg, 4096);
+    ASSERT_EQ(2U, result.size());
+    EXPECT_EQ(msg, result[0]);
+    EXPECT_EQ(msg, result[1]);
+}
+
+// Stream close is not handed up as a stanza
+TEST_F(XmppFramerTest, StreamClose) {
+    string iq("<iq type='get' id='1'/>");
+    vector<string> result = Frame(iq + "</stream:stream>", 4096);
+    ASSERT_EQ(1U, result.size());
+    EXPECT_EQ(iq, result[0]);
+    EXPECT_EQ(16U, framer_.discard_count());
+}
+
+// Stanzas spanning several reads are handed up once complete
+TEST_F(XmppFramerTest, Partial) {
+    vector<string> result = Frame("<message a = '2'> <item> blah blah "
+                                  "</item></mess", 4096);
+    EXPECT_EQ(0U, result.size());
+    result = Frame("age><iq a = '2'> <item>", 4096);
+    ASSERT_EQ(1U, result.size());
+    EXPECT_EQ("<message a = '2'> <item> blah blah </item></message>",
+              result[0]);
+    EXPECT_EQ(string("<iq a = '2'> <item>").size(), framer_.pending());
+
+    framer_.Reset();
+    result = Frame("<message a = '2'> ", 4096);
+    EXPECT_EQ(0U, result.size());
+    result = Frame("<item> blah blah ", 4096);
+    EXPECT_EQ(0U, result.size());
+    result = Frame("</item></message><somejunk>", 4096);
+    ASSERT_EQ(1U, result.size());
+    EXPECT_EQ("<message a = '2'> <item> blah blah </item></message>",
+              result[0]);
+    EXPECT_EQ(string("<somejunk>").size(), framer_.pending());
+}
+
+// Every split of the stream produces the same stanzas
+TEST_F(XmppFramerTest, Split) {
+    string stream = RoutePublish(1, 2) + " " + RoutePublish(2, 1);
+    vector<string> expected = Frame(stream, stream.size());
+    ASSERT_EQ(5U, expected.size());
+    for (size_t chunk = 1; chunk < stream.size(); chunk++) {
+        framer_.Reset();
+        EXPECT_TRUE(expected == Frame(stream, chunk)) << "chunk " << chunk;
+    }
+}
+
+TEST_F(XmppFramerTest, Throughput) {
+    struct Test {
+        int messages;
+        int items;
+    } tests[] = { { 10000, 1 }, { 100, 100 }, { 10, 1000 } };
+    static const size_t kChunkSize = 4096;
+
+    for (size_t t = 0; t < sizeof(tests) / sizeof(tests[0]); t++) {
+        string stream;
+        for (int i = 0; i < tests[t].messages; i++) {
+            stream += RoutePublish(i, tests[t].items);
+        }
+
+        framer_.Reset();
+        uint64_t start = UTCTimestampUsec();
+        vector<string> result = Frame(stream, kChunkSize);
+        uint64_t framer_usec = UTCTimestampUsec() - start;
+
+        XmppRegexFramer regex;
+        vector<string> regex_result;
+        start = UTCTimestampUsec();
+        for (size_t offset = 0; offset < stream.size(); offset += kChunkSize) {
+            regex.Parse(stream.data() + offset,
+                        min(kChunkSize, stream.size() - offset),
+                        Collector(&regex_result));
+        }
+        uint64_t regex_usec = UTCTimestampUsec() - start;
+
+        EXPECT_EQ(2U * tests[t].messages, result.size());
+        EXPECT_TRUE(result == regex_result);
+        LOG(DEBUG, "Stream of " << stream.size() << " bytes, "
+            << tests[t].items << " items per message: framer "
+            << framer_usec << " usec, regex " << regex_usec << " usec");
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_framer.h"
+
+#include <string.h>
+
+#include "xmpp/xmpp_str.h"
+
+using namespace std;
+
+XmppFramer::XmppFramer() : discard_count_(0) {
+    Reset();
+}
+
+void XmppFramer::Reset() {
+    state_ = IDLE;
+    depth_ = 0;
+    close_tag_ = false;
+    empty_tag_ = false;
+    quote_ = 0;
+    name_.clear();
+    buf_.clear();
+}
+
+// Whitespace fillers sent between stanzas as keepalives
+bool XmppFramer::IsWhitespace(uint8_t c) {
+    return (c != 0 && strchr(sXMPP_VALIDWS, c) != NULL);
+}
+
+static inline bool IsSpace(uint8_t c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+// Called at the '>' of a start, end or empty element tag. Returns true if
+// the tag completes a stanza.
+bool XmppFramer::EndTag() {
+    state_ = CONTENT;
+    if (close_tag_) {
+        return (--depth_ == 0);
+    }
+    if (empty_tag_) {
+        return (depth_ == 0);
+    }
+    // The stream start tag is not closed until the session ends
+    if (depth_ == 0 && name_ == sXMPP_STREAM_O) {
+        return true;
+    }
+    depth_++;
+    return false;
+}
+
+bool XmppFramer::Scan(const uint8_t *data, size_t len, size_t *used) {
+    size_t start = 0;
+    size_t i = 0;
+    bool done = false;
+
+    while (i < len && !done) {
+        uint8_t c = data[i];
+        switch (state_) {
+        case IDLE:
+            if (c == '<') {
+                state_ = TAG_OPEN;
+            } else if (IsWhitespace(c)) {
+                state_ = WHITESPACE;
+            } else {
+                discard_count_++;
+                start = i + 1;
+            }
+            i++;
+            break;
+
+        case WHITESPACE:
+            if (IsWhitespace(c)) {
+                i++;
+            } else {
+                done = true;
+            }
+            break;
+
+        case CONTENT: {
+            const uint8_t *p = static_cast<const uint8_t *>(
+                memchr(data + i, '<', len - i));
+            if (p == NULL) {
+                i = len;
+            } else {
+                i = (p - data) + 1;
+                state_ = TAG_OPEN;
+            }
+            break;
+        }
+
+        case TAG_OPEN:
+            close_tag_ = false;
+            empty_tag_ = false;
+            name_.clear();
+            if (c == '/') {
+                close_tag_ = true;
+                state_ = TAG_NAME;
+            } else if (c == '?' || c == '!') {
+                state_ = TAG_SPECIAL;
+            } else {
+                name_.push_back(c);
+                state_ = TAG_NAME;
+            }
+            i++;
+            break;
+
+        case TAG_NAME:
+        case TAG_BODY:
+            i++;
+            if (c == '>') {
+                if (close_tag_ && depth_ == 0) {
+                    // Stray end tag, e.g. </stream:stream>. Not a stanza
+                    discard_count_ += buf_.size() + (i - start);
+                    buf_.clear();
+                    state_ = IDLE;
+                    start = i;
+                    break;
+                }
+                done = EndTag();
+            } else if (c == '"' || c == '\'') {
+                quote_ = c;
+                empty_tag_ = false;
+                state_ = TAG_QUOTE;
+            } else if (c == '/') {
+                empty_tag_ = true;
+                state_ = TAG_BODY;
+            } else if (IsSpace(c)) {
+                state_ = TAG_BODY;
+            } else if (state_ == TAG_NAME) {
+                name_.push_back(c);
+            } else {
+                empty_tag_ = false;
+            }
+            break;
+
+        case TAG_QUOTE: {
+            const uint8_t *p = static_cast<const uint8_t *>(
+                memchr(data + i, quote_, len - i));
+            if (p == NULL) {
+                i = len;
+            } else {
+                i = (p - data) + 1;
+                state_ = TAG_BODY;
+            }
+            break;
+        }
+
+        case TAG_SPECIAL:
+            if (c == '>') {
+                state_ = CONTENT;
+            }
+            i++;
+            break;
+        }
+    }
+
+    // A run of whitespace is delivered as soon as the buffer ends
+    if (state_ == WHITESPACE) {
+        done = true;
+    }
+
+    *used = i;
+    if (!done) {
+        buf_.append(reinterpret_cast<const char *>(data + start), i - start);
+        return false;
+    }
+
+    const char *cp = reinterpret_cast<const char *>(data);
+    if (buf_.empty()) {
+        stanza_.assign(cp + start, cp + i);
+    } else {
+        buf_.append(cp + start, i - start);
+        stanza_.swap(buf_);
+        buf_.clear();
+    }
+    state_ = IDLE;
+    depth_ = 0;
+    return true;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __XMPP_FRAMER_H__
+#define __XMPP_FRAMER_H__
+
+#include <stdint.h>
+#include <string>
+
+//
+// Splits an XMPP byte stream into stanzas.
+//
+// The framer is a resumable state machine that tracks element depth, so
+// every byte is looked at once no matter how many reads a stanza spans.
+// Character data is skipped with memchr. A stanza is one of:
+//  - a run of whitespace fillers (keepalive)
+//  - a stream header, i.e. an optional <?xml?> declaration followed by the
+//    <stream:stream> start tag
+//  - a complete top level element such as <iq/> or <message/>
+// Bytes of a stanza that is not yet complete are kept in buf_.
+//
+class XmppFramer {
+public:
+    XmppFramer();
+
+    // Scan up to len bytes at data. Returns true if a stanza was completed,
+    // in which case it is available through stanza() until the next call.
+    // *used is set to the number of bytes consumed.
+    bool Scan(const uint8_t *data, size_t len, size_t *used);
+    const std::string &stanza() const { return stanza_; }
+
+    void Reset();
+    size_t pending() const { return buf_.size(); }
+    uint64_t discard_count() const { return discard_count_; }
+
+private:
+    enum State {
+        IDLE,           // between stanzas
+        WHITESPACE,     // in a run of whitespace fillers
+        CONTENT,        // character data inside a stanza
+        TAG_OPEN,       // after '<'
+        TAG_NAME,       // in the element name
+        TAG_BODY,       // in the attributes
+        TAG_QUOTE,      // in a quoted attribute value
+        TAG_SPECIAL,    // in <? ?> or <! >
+    };
+
+    static bool IsWhitespace(uint8_t c);
+    bool EndTag();
+
+    State state_;
+    int depth_;
+    bool close_tag_;
+    bool empty_tag_;
+    uint8_t quote_;
+    std::string name_;
+    std::string buf_;
+    std::string stanza_;
+    uint64_t discard_count_;
+};
+
+#endif // __XMPP_FRAMER_H__